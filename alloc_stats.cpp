@@ -0,0 +1,108 @@
+#include "alloc_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<unsigned long long> g_count{0};
+std::atomic<unsigned long long> g_bytes{0};
+thread_local bool t_counting = false;
+
+void count(std::size_t size) {
+    if (t_counting) {
+        g_count.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void* countedAlloc(std::size_t size) {
+    count(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* countedAlignedAlloc(std::size_t size, std::size_t align) {
+    count(size);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants a multiple of the alignment.
+    return std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+}
+
+void alignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+AllocationCountScope::AllocationCountScope(bool counting) : previous_(t_counting) {
+    t_counting = counting;
+}
+
+AllocationCountScope::~AllocationCountScope() {
+    t_counting = previous_;
+}
+
+bool countingAllocations() {
+    return t_counting;
+}
+
+AllocationCounters allocationCounters() {
+    AllocationCounters c;
+    c.count = g_count.load(std::memory_order_relaxed);
+    c.bytes = g_bytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+AllocationCounters allocationsSince(const AllocationCounters& since) {
+    AllocationCounters now = allocationCounters();
+    now.count -= since.count;
+    now.bytes -= since.bytes;
+    return now;
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (void* p = countedAlignedAlloc(size, static_cast<std::size_t>(align))) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
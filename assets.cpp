@@ -0,0 +1,371 @@
+#include "assets.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char ARCHIVE_MAGIC[4] = {'R', 'C', 'T', 'C'};
+constexpr Uint32 ARCHIVE_VERSION = 1;
+constexpr int MAX_MIP_LEVELS = 16;
+constexpr Uint64 PIXEL_ALIGNMENT = 64;
+
+struct ArchiveHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 entryCount;
+    Uint32 reserved;
+    Uint64 sourceHash;
+};
+
+struct ArchiveLevel {
+    Uint32 width;
+    Uint32 height;
+    Uint64 offset; // from the start of the file, PIXEL_ALIGNMENT aligned
+};
+
+struct ArchiveEntry {
+    Uint32 sprite;
+    Sint32 id;
+    Uint32 levelCount; // 0 when the source failed to load
+    Uint32 reserved;
+    ArchiveLevel levels[MAX_MIP_LEVELS];
+};
+
+Uint64 fnv1a(Uint64 hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<AssetEntry> defaultManifest() {
+    const std::string dir = "resources/textures/";
+    return {
+        {false, 1, dir + "redbrick.png"},
+        {false, 2, dir + "greystone.png"},
+        {false, 3, dir + "wood.png"},
+        {false, 4, dir + "bluestone.png"},
+        {false, DOOR_TILE, dir + "door.png"},
+        {true, 0, dir + "sprite_barrel.png"},
+        {true, 1, dir + "sprite_pillar.png"},
+        {true, 2, dir + "sprite_greenlight.png"},
+    };
+}
+
+const std::vector<SDL_Surface*>* chainFor(const TextureManager& tm, const AssetEntry& entry) {
+    const auto& chains = entry.sprite ? tm.spriteMips : tm.textureMips;
+    if (entry.id < 0 || entry.id >= static_cast<int>(chains.size())) {
+        return nullptr;
+    }
+    return &chains[entry.id];
+}
+
+// Read-only mapping of a whole file, released through the returned handle.
+std::shared_ptr<void> mapFile(const std::string& path, size_t& size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!base) {
+        return nullptr;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return std::shared_ptr<void>(base, [](void* p) { UnmapViewOfFile(p); });
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    size = length;
+    return std::shared_ptr<void>(base, [length](void* p) { munmap(p, length); });
+#endif
+}
+
+// The archive's entry table, or null unless it was written for exactly these entries and sources and every
+// level lies inside the file.
+const ArchiveEntry* validArchiveTable(const Uint8* base, size_t size, Uint64 sourceHash, const std::vector<AssetEntry>& entries) {
+    if (size < sizeof(ArchiveHeader)) {
+        return nullptr;
+    }
+    ArchiveHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION ||
+        header.sourceHash != sourceHash || header.entryCount != entries.size() ||
+        size < sizeof(ArchiveHeader) + header.entryCount * sizeof(ArchiveEntry)) {
+        return nullptr;
+    }
+
+    const ArchiveEntry* table = reinterpret_cast<const ArchiveEntry*>(base + sizeof(ArchiveHeader));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ArchiveEntry& e = table[i];
+        if ((e.sprite != 0) != entries[i].sprite || e.id != entries[i].id || e.levelCount > MAX_MIP_LEVELS) {
+            return nullptr;
+        }
+        for (Uint32 l = 0; l < e.levelCount; ++l) {
+            Uint64 bytes = static_cast<Uint64>(e.levels[l].width) * e.levels[l].height * sizeof(Uint32);
+            if (e.levels[l].offset + bytes > size) {
+                return nullptr;
+            }
+        }
+    }
+    return table;
+}
+} // namespace
+
+std::vector<AssetEntry> readAssetManifest(const std::string& manifestPath) {
+    std::ifstream in(manifestPath);
+    if (!in) {
+        return defaultManifest();
+    }
+    std::string dir = std::filesystem::path(manifestPath).parent_path().generic_string();
+    if (!dir.empty()) {
+        dir += "/";
+    }
+
+    std::vector<AssetEntry> entries;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream iss(line);
+        std::string kind;
+        AssetEntry entry;
+        std::string file;
+        if (!(iss >> kind)) {
+            continue;
+        }
+        if (!(iss >> entry.id >> file) || (kind != "wall" && kind != "sprite") || entry.id < 0) {
+            std::cerr << manifestPath << ":" << lineNo << ": expected 'wall|sprite <id> <file>'\n";
+            continue;
+        }
+        entry.sprite = (kind == "sprite");
+        entry.path = dir + file;
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+Uint64 hashAssetSources(const std::vector<AssetEntry>& entries) {
+    Uint64 hash = 14695981039346656037ull;
+    for (const auto& entry : entries) {
+        std::error_code ec;
+        long long size = static_cast<long long>(std::filesystem::file_size(entry.path, ec));
+        if (ec) {
+            size = -1;
+        }
+        long long stamp = 0;
+        auto mtime = std::filesystem::last_write_time(entry.path, ec);
+        if (!ec) {
+            stamp = static_cast<long long>(mtime.time_since_epoch().count());
+        }
+        Uint32 sprite = entry.sprite ? 1 : 0;
+        hash = fnv1a(hash, &sprite, sizeof(sprite));
+        hash = fnv1a(hash, &entry.id, sizeof(entry.id));
+        hash = fnv1a(hash, entry.path.data(), entry.path.size());
+        hash = fnv1a(hash, &size, sizeof(size));
+        hash = fnv1a(hash, &stamp, sizeof(stamp));
+    }
+    return hash;
+}
+
+bool mapTextureArchive(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, TextureManager& tm) {
+    size_t size = 0;
+    std::shared_ptr<void> mapping = mapFile(cachePath, size);
+    if (!mapping) {
+        return false;
+    }
+    const Uint8* base = static_cast<const Uint8*>(mapping.get());
+    const ArchiveEntry* table = validArchiveTable(base, size, sourceHash, entries);
+    if (!table) {
+        return false;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ArchiveEntry& e = table[i];
+        auto& surfaces = e.sprite ? tm.spriteTextures : tm.textures;
+        auto& chains = e.sprite ? tm.spriteMips : tm.textureMips;
+        if (e.id >= static_cast<int>(surfaces.size())) {
+            surfaces.resize(e.id + 1, nullptr);
+            chains.resize(e.id + 1);
+        }
+        // Later manifest lines override earlier ones, as on the decode path; only the headers are ours to free.
+        for (SDL_Surface* old : chains[e.id]) {
+            SDL_FreeSurface(old);
+        }
+        chains[e.id].clear();
+        surfaces[e.id] = nullptr;
+        std::vector<SDL_Surface*> chain;
+        for (Uint32 l = 0; l < e.levelCount; ++l) {
+            const ArchiveLevel& level = e.levels[l];
+            // The surface borrows the mapped pixels; nothing writes to texture memory.
+            void* pixels = const_cast<Uint8*>(base + level.offset);
+            int w = static_cast<int>(level.width);
+            int h = static_cast<int>(level.height);
+            SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormatFrom(pixels, w, h, 32, w * static_cast<int>(sizeof(Uint32)), SDL_PIXELFORMAT_ARGB8888);
+            if (!surf) {
+                break;
+            }
+            chain.push_back(surf);
+        }
+        surfaces[e.id] = chain.empty() ? nullptr : chain.front();
+        chains[e.id] = std::move(chain);
+    }
+    tm.archive = std::move(mapping);
+    return true;
+}
+
+bool readTextureArchiveIndex(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, std::vector<std::vector<TextureArchiveLevel>>& chains) {
+    size_t size = 0;
+    std::shared_ptr<void> mapping = mapFile(cachePath, size);
+    if (!mapping) {
+        return false;
+    }
+    const ArchiveEntry* table = validArchiveTable(static_cast<const Uint8*>(mapping.get()), size, sourceHash, entries);
+    if (!table) {
+        return false;
+    }
+    chains.assign(entries.size(), {});
+    for (size_t i = 0; i < entries.size(); ++i) {
+        for (Uint32 l = 0; l < table[i].levelCount; ++l) {
+            const ArchiveLevel& level = table[i].levels[l];
+            chains[i].push_back({static_cast<int>(level.width), static_cast<int>(level.height), level.offset});
+        }
+    }
+    return true;
+}
+
+std::vector<SDL_Surface*> readTextureArchiveChain(std::istream& in, const std::vector<TextureArchiveLevel>& levels) {
+    std::vector<SDL_Surface*> chain;
+    for (const TextureArchiveLevel& level : levels) {
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, level.width, level.height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!surf) {
+            break;
+        }
+        chain.push_back(surf);
+        size_t rowBytes = static_cast<size_t>(level.width) * sizeof(Uint32);
+        in.seekg(static_cast<std::streamoff>(level.offset));
+        for (int y = 0; y < level.height && in; ++y) {
+            in.read(static_cast<char*>(surf->pixels) + static_cast<size_t>(y) * surf->pitch, static_cast<std::streamsize>(rowBytes));
+        }
+        if (!in) {
+            break;
+        }
+    }
+    if (chain.size() != levels.size()) {
+        for (SDL_Surface* surf : chain) {
+            SDL_FreeSurface(surf);
+        }
+        chain.clear();
+    }
+    return chain;
+}
+
+bool writeTextureArchive(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, const TextureManager& tm) {
+    std::vector<ArchiveEntry> table(entries.size());
+    Uint64 offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ArchiveEntry& e = table[i];
+        std::memset(&e, 0, sizeof(e));
+        e.sprite = entries[i].sprite ? 1 : 0;
+        e.id = entries[i].id;
+        const std::vector<SDL_Surface*>* chain = chainFor(tm, entries[i]);
+        if (!chain) {
+            continue;
+        }
+        e.levelCount = static_cast<Uint32>(std::min<size_t>(chain->size(), MAX_MIP_LEVELS));
+        for (Uint32 l = 0; l < e.levelCount; ++l) {
+            offset = (offset + PIXEL_ALIGNMENT - 1) / PIXEL_ALIGNMENT * PIXEL_ALIGNMENT;
+            SDL_Surface* surf = (*chain)[l];
+            e.levels[l] = {static_cast<Uint32>(surf->w), static_cast<Uint32>(surf->h), offset};
+            offset += static_cast<Uint64>(surf->w) * surf->h * sizeof(Uint32);
+        }
+    }
+
+    // Write next to the destination and rename so a crash never leaves a torn archive.
+    std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write texture cache " << tmpPath << "\n";
+            return false;
+        }
+        ArchiveHeader header{};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.version = ARCHIVE_VERSION;
+        header.entryCount = static_cast<Uint32>(entries.size());
+        header.sourceHash = sourceHash;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(ArchiveEntry)));
+
+        Uint64 written = sizeof(ArchiveHeader) + table.size() * sizeof(ArchiveEntry);
+        const char zeros[PIXEL_ALIGNMENT] = {};
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const std::vector<SDL_Surface*>* chain = chainFor(tm, entries[i]);
+            for (Uint32 l = 0; l < table[i].levelCount; ++l) {
+                const ArchiveLevel& level = table[i].levels[l];
+                out.write(zeros, static_cast<std::streamsize>(level.offset - written));
+                SDL_Surface* surf = (*chain)[l];
+                size_t rowBytes = static_cast<size_t>(surf->w) * sizeof(Uint32);
+                for (int y = 0; y < surf->h; ++y) {
+                    out.write(static_cast<const char*>(surf->pixels) + static_cast<size_t>(y) * surf->pitch, static_cast<std::streamsize>(rowBytes));
+                }
+                written = level.offset + rowBytes * surf->h;
+            }
+        }
+        if (!out) {
+            std::cerr << "Failed to write texture cache " << tmpPath << "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec) {
+        std::cerr << "Failed to replace texture cache " << cachePath << ": " << ec.message() << "\n";
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
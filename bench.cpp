@@ -0,0 +1,1225 @@
+#include "bench.h"
+
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "alloc_stats.h"
+#include "camera_path.h"
+#include "collision.h"
+#include "column_kernels.h"
+#include "doors.h"
+#include "entities.h"
+#include "framebuffer.h"
+#include "level.h"
+#include "level_history.h"
+#include "lighting.h"
+#include "game_types.h"
+#include "map.h"
+#include "pathfinding.h"
+#include "pvs.h"
+#include "renderer.h"
+#include "server.h"
+#include "textures.h"
+#include "thread_pool.h"
+#include "visibility.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Hardware cache-miss counters for the calling thread (Linux perf events only).
+class CacheCounters {
+public:
+    CacheCounters() {
+#ifdef __linux__
+        l1dFd_ = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        llcFd_ = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    }
+    ~CacheCounters() {
+#ifdef __linux__
+        if (l1dFd_ >= 0) close(l1dFd_);
+        if (llcFd_ >= 0) close(llcFd_);
+#endif
+    }
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    bool available() const { return l1dFd_ >= 0 || llcFd_ >= 0; }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : {l1dFd_, llcFd_}) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int fd : {l1dFd_, llcFd_}) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        l1dMisses = read(l1dFd_);
+        llcMisses = read(llcFd_);
+#endif
+    }
+
+    long long l1dMisses = -1;
+    long long llcMisses = -1;
+
+private:
+#ifdef __linux__
+    static int open(Uint32 type, Uint64 config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static long long read(int fd) {
+        long long value = -1;
+        if (fd < 0 || ::read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+            return -1;
+        }
+        return value;
+    }
+#endif
+    int l1dFd_ = -1;
+    int llcFd_ = -1;
+};
+
+// A straight three-wide corridor with alternating wall ids, viewed end-on.
+Map makeCorridorMap(int length) {
+    Map m{};
+    m.width = length;
+    m.height = 5;
+    m.tiles.assign(m.width * m.height, 1);
+    for (int x = 0; x < m.width; ++x) {
+        m.tiles[x] = 1 + (x / 4) % 4;
+        m.tiles[(m.height - 1) * m.width + x] = 1 + (x / 4 + 2) % 4;
+    }
+    for (int y = 1; y < m.height - 1; ++y) {
+        for (int x = 1; x < m.width - 1; ++x) {
+            m.tiles[y * m.width + x] = 0;
+        }
+    }
+    return m;
+}
+
+// A walled square hall with a grid of single-tile pillars.
+Map makeHallMap(int size) {
+    Map m{};
+    m.width = size;
+    m.height = size;
+    m.tiles.assign(size * size, 0);
+    for (int i = 0; i < size; ++i) {
+        m.tiles[i] = 1 + (i / 3) % 4;
+        m.tiles[(size - 1) * size + i] = 1 + (i / 3 + 1) % 4;
+        m.tiles[i * size] = 1 + (i / 3 + 2) % 4;
+        m.tiles[i * size + size - 1] = 1 + (i / 3 + 3) % 4;
+    }
+    for (int y = 6; y < size - 6; y += 7) {
+        for (int x = 6; x < size - 6; x += 7) {
+            m.tiles[y * size + x] = 1 + (x + y) % 4;
+        }
+    }
+    return m;
+}
+
+int benchMipmaps(const std::vector<std::string>& args) {
+    int frames = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 120;
+    Config cfg{};
+    Map map = makeCorridorMap(512);
+    std::vector<Door> doors;
+    std::vector<Sprite> sprites;
+    for (int x = 4; x < map.width - 1; x += 6) {
+        sprites.push_back({x + 0.5, (x % 12 == 4) ? 1.5 : 3.5, (x / 6) % 3});
+    }
+    EntityStore entities = entitiesFromSprites(sprites);
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+
+    const Player poses[] = {
+        cameraFromAngle(1.5, 2.5, 0.0),
+        cameraFromAngle(1.5, 2.2, 0.08),
+        cameraFromAngle(1.5, 2.8, -0.08),
+        cameraFromAngle(60.5, 2.5, 0.02),
+    };
+
+    std::vector<Uint32> pixels(static_cast<size_t>(cfg.screenWidth) * cfg.screenHeight);
+    FrameTarget target{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth};
+
+    std::cout << "mipmaps: " << frames << " frames, " << cfg.screenWidth << "x" << cfg.screenHeight
+              << ", 512-cell corridor\n";
+    for (bool mips : {false, true}) {
+        cfg.textureMode = mips ? TextureMode::Mipmapped : TextureMode::Full;
+        for (const Player& p : poses) {
+            renderWorld(map, doors, entities, p, cfg, tm, target); // warm-up
+        }
+        CacheCounters counters;
+        counters.start();
+        auto start = Clock::now();
+        for (int i = 0; i < frames; ++i) {
+            renderWorld(map, doors, entities, poses[i % 4], cfg, tm, target);
+        }
+        double ms = elapsedMs(start);
+        counters.stop();
+
+        std::cout << std::fixed << std::setprecision(3) << "  " << (mips ? "mipmapped " : "full-res  ")
+                  << ms / frames << " ms/frame";
+        if (counters.available()) {
+            std::cout << "  L1D read misses/frame " << (counters.l1dMisses >= 0 ? counters.l1dMisses / frames : -1)
+                      << "  LLC misses/frame " << (counters.llcMisses >= 0 ? counters.llcMisses / frames : -1);
+        } else {
+            std::cout << "  (cache counters unavailable)";
+        }
+        std::cout << "\n";
+    }
+    freeTextures(tm);
+    return 0;
+}
+
+int benchAssets(const std::vector<std::string>& args) {
+    std::string manifest = args.size() > 1 ? args[1] : "resources/textures/manifest.txt";
+    std::string cache = args.size() > 2 ? args[2] : "resources/textures/textures.cache";
+    std::error_code ec;
+    std::filesystem::remove(cache, ec);
+
+    std::cout << "cold start (no cache):\n";
+    TextureManager cold = loadTextures(manifest, cache);
+    freeTextures(cold);
+    std::cout << "warm start (cache archive):\n";
+    TextureManager warm = loadTextures(manifest, cache);
+    bool mapped = warm.loadStats.fromCache;
+    freeTextures(warm);
+    if (!mapped) {
+        std::cerr << "cache archive was not used on the second load\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchEntities(const std::vector<std::string>& args) {
+    int count = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 10000;
+    int ticks = args.size() > 2 ? std::max(1, std::atoi(args[2].c_str())) : 300;
+    Map map = createRandomMap(1234u, 256, 256);
+    std::vector<Door> doors = extractDoors(map);
+    const double dt = 1.0 / 60.0;
+
+    std::cout << "entities: " << count << " wanderers, " << ticks << " ticks on a " << map.width << "x" << map.height << " map\n";
+    ThreadPool serial(0);
+    for (ThreadPool* pool : {&serial, &workerPool()}) {
+        EntityStore entities;
+        spawnWanderers(entities, map, count, 99u);
+        updateEntities(entities, map, doors, dt, *pool); // warm-up
+        auto start = Clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            updateEntities(entities, map, doors, dt, *pool);
+        }
+        double ms = elapsedMs(start);
+        std::cout << std::fixed << std::setprecision(3) << "  " << pool->concurrency() << " thread(s): " << ms / ticks
+                  << " ms/tick, " << std::setprecision(1) << (static_cast<double>(count) * ticks) / (ms / 1000.0) / 1e6
+                  << " M actor-updates/s\n";
+    }
+    return 0;
+}
+
+int benchCollision(const std::vector<std::string>& args) {
+    std::vector<int> counts;
+    for (size_t i = 1; i < args.size(); ++i) {
+        counts.push_back(std::max(1, std::atoi(args[i].c_str())));
+    }
+    if (counts.empty()) {
+        counts = {1000, 4000, 16000};
+    }
+    Map map = createRandomMap(1234u, 256, 256);
+    std::vector<Door> doors = extractDoors(map);
+    const double dt = 1.0 / 60.0;
+    const int ticks = 120;
+    const int queries = 200000;
+
+    std::cout << "collision: " << map.width << "x" << map.height << " map, " << ticks << " ticks, " << queries
+              << " random queries per count\n";
+    int failures = 0;
+    for (int count : counts) {
+        EntityStore entities = entitiesFromSprites(createSprites(map, 1234u));
+        spawnWanderers(entities, map, count, 99u);
+        assignSpriteColliders(entities, map);
+
+        CollisionGrid grid;
+        auto start = Clock::now();
+        grid.reset(map.width, map.height);
+        grid.sync(entities);
+        double buildMs = elapsedMs(start);
+
+        EntityStore plain = entities;
+        start = Clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            updateEntities(plain, map, doors, dt);
+        }
+        double plainMs = elapsedMs(start) / ticks;
+
+        double updateMs = 0.0;
+        double syncMs = 0.0;
+        for (int t = 0; t < ticks; ++t) {
+            start = Clock::now();
+            updateEntities(entities, map, doors, grid, dt);
+            updateMs += elapsedMs(start);
+            start = Clock::now();
+            grid.sync(entities);
+            syncMs += elapsedMs(start);
+        }
+
+        // Random player-sized probes, answered by the grid and checked against every collider.
+        std::mt19937 rng(count);
+        std::uniform_real_distribution<double> px(0.0, map.width);
+        std::uniform_real_distribution<double> py(0.0, map.height);
+        std::vector<std::pair<double, double>> probes(queries);
+        for (auto& p : probes) {
+            p = {px(rng), py(rng)};
+        }
+        size_t hits = 0;
+        start = Clock::now();
+        for (const auto& p : probes) {
+            grid.forEachOverlap(p.first, p.second, PLAYER_RADIUS, -1, [&](int, double, double, double, double) { ++hits; });
+        }
+        double queryMs = elapsedMs(start);
+        size_t mismatches = 0;
+        for (size_t q = 0; q < probes.size(); q += 97) {
+            size_t gridHits = 0;
+            grid.forEachOverlap(probes[q].first, probes[q].second, PLAYER_RADIUS, -1, [&](int, double, double, double, double) { ++gridHits; });
+            size_t brute = 0;
+            for (size_t i = 0; i < entities.size(); ++i) {
+                double dx = probes[q].first - entities.x[i];
+                double dy = probes[q].second - entities.y[i];
+                double minDistance = PLAYER_RADIUS + entities.radius[i];
+                brute += entities.radius[i] > 0.0f && dx * dx + dy * dy < minDistance * minDistance;
+            }
+            mismatches += gridHits != brute;
+        }
+
+        std::cout << std::fixed << std::setprecision(3) << "  " << count << " wanderers (" << grid.colliders() << " colliders): build "
+                  << buildMs << " ms, sync " << syncMs / ticks << " ms/tick (" << grid.relinks() / ticks << " relinks), update "
+                  << updateMs / ticks << " ms/tick vs " << plainMs << " without the grid; " << std::setprecision(1)
+                  << queries / (queryMs / 1000.0) / 1e6 << " M queries/s, " << hits << " overlaps\n";
+        if (mismatches != 0) {
+            std::cerr << "  " << mismatches << " grid queries disagree with brute force\n";
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int benchSnapshot(const std::vector<std::string>& args) {
+    int size = args.size() > 1 ? std::max(16, std::atoi(args[1].c_str())) : 256;
+    int wanderers = args.size() > 2 ? std::max(0, std::atoi(args[2].c_str())) : 1000;
+    const int ticks = 600;
+    const double dt = 1.0 / 60.0;
+    Level level;
+    level.seed = 77u;
+    level.map = createRandomMap(level.seed, size, size);
+    level.doors = extractDoors(level.map);
+    level.entities = entitiesFromSprites(createSprites(level.map, level.seed));
+    spawnWanderers(level.entities, level.map, wanderers, level.seed);
+    assignSpriteColliders(level.entities, level.map);
+    level.collision.reset(level.map.width, level.map.height);
+    level.collision.sync(level.entities);
+    CameraPath path = generateRoomTour(level.map, level.doors);
+
+    // Every tick is captured; the ring holds the whole run.
+    LevelHistory history(ticks * dt, 0.0);
+    double captureMs = 0.0;
+    double fullCopyMs = 0.0;
+    size_t bytesCopied = 0;
+    Level expected;
+    double expectedTime = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        const Player& player = path.frames[t % path.frames.size()];
+        updateDoors(level.doors, player, dt);
+        updateEntities(level.entities, level.map, level.doors, level.collision, dt);
+        level.collision.sync(level.entities);
+
+        auto start = Clock::now();
+        history.record(level, player, (t + 1) * dt);
+        captureMs += elapsedMs(start);
+        bytesCopied += history.stats().last.bytesCopied;
+
+        start = Clock::now();
+        Map mapCopy = level.map;
+        std::vector<Door> doorCopy = level.doors;
+        EntityStore entityCopy = level.entities;
+        fullCopyMs += elapsedMs(start);
+        if (t == ticks / 2) {
+            expected.map = std::move(mapCopy);
+            expected.doors = std::move(doorCopy);
+            expected.entities = std::move(entityCopy);
+            expectedTime = (t + 1) * dt;
+        }
+    }
+    LevelHistoryStats st = history.stats();
+
+    Player player{};
+    double time = ticks * dt;
+    auto start = Clock::now();
+    bool rewound = history.rewind(time - expectedTime, level, player, time);
+    double rewindMs = elapsedMs(start);
+    bool same = rewound && time == expectedTime && level.map.tiles == expected.map.tiles && level.entities.x == expected.entities.x &&
+                level.entities.y == expected.entities.y && level.entities.rngState == expected.entities.rngState &&
+                level.entities.velX == expected.entities.velX && level.doors.size() == expected.doors.size();
+    for (size_t d = 0; same && d < level.doors.size(); ++d) {
+        same = level.doors[d].openAmount == expected.doors[d].openAmount && level.doors[d].timeFullyOpen == expected.doors[d].timeFullyOpen;
+    }
+
+    std::cout << "snapshot: " << size << "x" << size << " map, " << level.doors.size() << " doors, " << level.entities.size() << " entities ("
+              << wanderers << " wandering), " << ticks << " ticks\n";
+    std::cout << std::fixed << std::setprecision(1) << "  copy-on-write: " << captureMs * 1000.0 / ticks << " us/tick, "
+              << bytesCopied / 1024.0 / ticks << " KiB copied/tick; " << st.snapshots << " snapshots hold " << st.uniqueBytes / 1024.0 << " KiB\n";
+    std::cout << "  full copy:     " << fullCopyMs * 1000.0 / ticks << " us/tick, " << st.fullCopyBytes / 1024.0 << " KiB/tick; "
+              << st.snapshots << " would hold " << st.fullCopyBytes * st.snapshots / 1024.0 << " KiB\n";
+    std::cout << "  rewind " << (ticks * dt - expectedTime) << " s: " << std::setprecision(3) << rewindMs << " ms, "
+              << (same ? "state matches" : "STATE DIFFERS") << "\n";
+    return same ? 0 : 1;
+}
+
+int benchVisibility(const std::vector<std::string>& args) {
+    int count = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 200000;
+    int size = args.size() > 2 ? std::max(16, std::atoi(args[2].c_str())) : 256;
+    Map map = createRandomMap(4321u, size, size);
+    std::vector<Door> doors = extractDoors(map);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> openDist(0.0, 1.0);
+    for (auto& door : doors) {
+        door.openAmount = openDist(rng) < 0.5 ? 0.0 : openDist(rng);
+    }
+
+    // Pairs of floor points a typical AI would test: within 24 cells of each other.
+    std::vector<std::pair<int, int>> floor;
+    for (int y = 1; y < map.height - 1; ++y) {
+        for (int x = 1; x < map.width - 1; ++x) {
+            if (map.at(x, y) == 0) {
+                floor.push_back({x, y});
+            }
+        }
+    }
+    std::uniform_int_distribution<size_t> cellDist(0, floor.size() - 1);
+    std::uniform_real_distribution<double> offset(-24.0, 24.0);
+    std::vector<LosQuery> queries;
+    queries.reserve(count);
+    while (static_cast<int>(queries.size()) < count) {
+        const auto& a = floor[cellDist(rng)];
+        double toX = a.first + 0.5 + offset(rng);
+        double toY = a.second + 0.5 + offset(rng);
+        if (toX <= 1.0 || toY <= 1.0 || toX >= map.width - 1 || toY >= map.height - 1) {
+            continue;
+        }
+        queries.push_back({a.first + 0.5, a.second + 0.5, toX, toY});
+    }
+
+    std::cout << "visibility: " << count << " queries on a " << map.width << "x" << map.height << " map, "
+              << doors.size() << " doors\n";
+    std::vector<Uint8> results;
+    ThreadPool serial(0);
+    for (ThreadPool* pool : {&serial, &workerPool()}) {
+        queryLineOfSight(map, doors, queries, results, *pool); // warm-up
+        auto start = Clock::now();
+        queryLineOfSight(map, doors, queries, results, *pool);
+        double ms = elapsedMs(start);
+        size_t visible = 0;
+        for (Uint8 r : results) {
+            visible += r;
+        }
+        std::cout << std::fixed << std::setprecision(2) << "  " << pool->concurrency() << " thread(s): "
+                  << count / (ms / 1000.0) / 1e6 << " M queries/s (" << 100.0 * visible / count << "% visible)\n";
+    }
+    return 0;
+}
+
+int benchPathfinding(const std::vector<std::string>& args) {
+    int count = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 1000;
+    std::vector<int> sizes;
+    for (size_t i = 2; i < args.size(); ++i) {
+        sizes.push_back(std::max(16, std::atoi(args[i].c_str())));
+    }
+    if (sizes.empty()) {
+        sizes = {256, 512};
+    }
+
+    int failures = 0;
+    for (int size : sizes) {
+        Map map = createRandomMap(2024u, size, size);
+        std::vector<Door> doors = extractDoors(map);
+        std::mt19937 rng(11);
+        for (auto& door : doors) {
+            door.openAmount = (rng() & 1) ? 1.0 : 0.0;
+        }
+        PathService service(map, doors);
+        std::vector<GridPoint> floor;
+        for (int y = 0; y < map.height; ++y) {
+            for (int x = 0; x < map.width; ++x) {
+                if (service.grid().walkable(x, y)) {
+                    floor.push_back({x, y});
+                }
+            }
+        }
+        std::uniform_int_distribution<size_t> cellDist(0, floor.size() - 1);
+        std::cout << "pathfinding: " << map.width << "x" << map.height << " map, " << floor.size() << " walkable cells, "
+                  << doors.size() << " doors\n";
+
+        // Single queries between random cells; a sample is checked against the exact flow-field cost.
+        std::vector<double> latencies;
+        std::vector<GridPoint> waypoints;
+        int found = 0;
+        int mismatches = 0;
+        for (int i = 0; i < count; ++i) {
+            GridPoint a = floor[cellDist(rng)];
+            GridPoint b = floor[cellDist(rng)];
+            Uint32 cost = 0;
+            auto start = Clock::now();
+            bool ok = service.findPath(a, b, waypoints, &cost);
+            latencies.push_back(elapsedMs(start));
+            found += ok ? 1 : 0;
+            if (i < 20) {
+                const FlowField& field = service.flowFieldTo(b);
+                Uint32 exact = field.distance[a.y * map.width + a.x];
+                if ((ok ? cost : NAV_UNREACHABLE) != exact) {
+                    ++mismatches;
+                }
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        double total = 0.0;
+        for (double ms : latencies) {
+            total += ms;
+        }
+        std::cout << std::fixed << std::setprecision(1) << "  JPS query: mean " << total / count * 1000.0 << " us, p50 "
+                  << latencies[latencies.size() / 2] * 1000.0 << " us, p99 " << latencies[latencies.size() * 99 / 100] * 1000.0
+                  << " us (" << found << "/" << count << " reachable, " << mismatches << "/" << std::min(count, 20)
+                  << " cost mismatches vs flow field)\n";
+
+        // Full builds: a one-entry cache misses on every new target.
+        const int builds = 20;
+        service.setCacheCapacity(1);
+        auto buildStart = Clock::now();
+        for (int i = 0; i < builds; ++i) {
+            service.flowFieldTo(floor[cellDist(rng)]);
+        }
+        double buildMs = elapsedMs(buildStart) / builds;
+
+        // Door toggles repaired in place, checked against a fresh build at the end.
+        GridPoint target = floor[cellDist(rng)];
+        service.flowFieldTo(target);
+        const int toggles = std::min<int>(200, static_cast<int>(doors.size()) * 4);
+        std::uniform_int_distribution<size_t> doorDist(0, doors.empty() ? 0 : doors.size() - 1);
+        double repairMs = 0.0;
+        for (int i = 0; i < toggles; ++i) {
+            Door& door = doors[doorDist(rng)];
+            door.openAmount = doorPassable(door) ? 0.0 : 1.0;
+            auto start = Clock::now();
+            service.syncDoors(doors);
+            repairMs += elapsedMs(start);
+        }
+        const FlowField& repaired = service.flowFieldTo(target);
+        PathService fresh(map, doors);
+        const FlowField& rebuilt = fresh.flowFieldTo(target);
+        size_t wrong = 0;
+        for (size_t i = 0; i < rebuilt.distance.size(); ++i) {
+            wrong += repaired.distance[i] != rebuilt.distance[i] ? 1 : 0;
+        }
+        std::cout << std::setprecision(3) << "  flow field: full build " << buildMs << " ms, door repair "
+                  << (toggles ? repairMs / toggles : 0.0) << " ms avg over " << toggles << " toggles ("
+                  << wrong << " cells differ from a fresh build)\n";
+        failures += mismatches + static_cast<int>(wrong);
+    }
+    if (failures != 0) {
+        std::cerr << "JPS costs or repaired flow fields differ from a fresh flow-field build\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchPvs(const std::vector<std::string>& args) {
+    std::vector<int> sizes;
+    for (size_t i = 1; i < args.size(); ++i) {
+        sizes.push_back(std::max(16, std::atoi(args[i].c_str())));
+    }
+    if (sizes.empty()) {
+        sizes = {256, 512};
+    }
+
+    int failures = 0;
+    for (int size : sizes) {
+        Map map = createRandomMap(777u, size, size);
+        std::vector<Door> doors = extractDoors(map);
+        ThreadPool serial(0);
+        PvsData single = buildPvs(map, doors, serial);
+        PvsData pvs = buildPvs(map, doors, workerPool());
+        size_t edges = 0;
+        for (const auto& list : pvs.edges) {
+            edges += list.size();
+        }
+        std::cout << "pvs: " << map.width << "x" << map.height << " map, " << map.rooms.size() << " rooms, "
+                  << pvs.regionCount << " regions, " << edges / 2 << " edges, " << doors.size() << " doors\n";
+        std::cout << std::fixed << std::setprecision(1) << "  build: " << single.buildMs << " ms on 1 thread, "
+                  << pvs.buildMs << " ms on " << workerPool().concurrency() << "\n";
+
+        std::mt19937 rng(5);
+        for (auto& door : doors) {
+            door.openAmount = (rng() & 1) ? 1.0 : 0.0;
+        }
+        std::vector<std::pair<int, int>> floor;
+        for (int y = 1; y < map.height - 1; ++y) {
+            for (int x = 1; x < map.width - 1; ++x) {
+                if (map.at(x, y) == 0) {
+                    floor.push_back({x, y});
+                }
+            }
+        }
+        std::uniform_int_distribution<size_t> cellDist(0, floor.size() - 1);
+        std::uniform_int_distribution<int> offset(-32, 32);
+
+        // Visible-set cost per viewpoint, and how often a cell with real line of sight was culled.
+        const int viewpoints = 1000;
+        VisibleRegions visible;
+        double queryMs = 0.0;
+        double fraction = 0.0;
+        size_t seen = 0;
+        size_t culledButSeen = 0;
+        for (int i = 0; i < viewpoints; ++i) {
+            auto from = floor[cellDist(rng)];
+            auto start = Clock::now();
+            computeVisibleRegions(pvs, doors, from.first + 0.5, from.second + 0.5, visible);
+            queryMs += elapsedMs(start);
+            fraction += visible.all ? 1.0 : static_cast<double>(visible.count) / pvs.regionCount;
+            for (int k = 0; k < 100; ++k) {
+                int tx = from.first + offset(rng);
+                int ty = from.second + offset(rng);
+                if (map.at(tx, ty) != 0 || !hasLineOfSight(map, doors, from.first + 0.5, from.second + 0.5, tx + 0.5, ty + 0.5)) {
+                    continue;
+                }
+                ++seen;
+                culledButSeen += visible.containsCell(tx, ty) ? 0 : 1;
+            }
+        }
+        std::cout << std::setprecision(2) << "  visible set: " << queryMs / viewpoints * 1000.0 << " us/query, "
+                  << 100.0 * fraction / viewpoints << "% of regions on average, " << culledButSeen << "/" << seen
+                  << " line-of-sight cells wrongly culled\n";
+        if (culledButSeen != 0) {
+            std::cerr << "  the PVS culled cells the viewer can see\n";
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int benchAlloc(const std::vector<std::string>& args) {
+    int frames = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 300;
+    Config cfg{};
+    Map map = createRandomMap(31u, 96, 96);
+    std::vector<Door> doors = extractDoors(map);
+    EntityStore entities = entitiesFromSprites(createSprites(map, 31u));
+    spawnWanderers(entities, map, 200, 31u);
+    assignSpriteColliders(entities, map);
+    CollisionGrid collision;
+    collision.reset(map.width, map.height);
+    collision.sync(entities);
+    PvsData pvs = buildPvs(map, doors);
+    VisibleRegions visible;
+    CameraPath path = generateRoomTour(map, doors);
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+    std::vector<Uint32> pixels(static_cast<size_t>(cfg.screenWidth) * cfg.screenHeight);
+    FrameTarget target{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth};
+    RenderContext rc;
+
+    // Simulation and world rendering as the main loop runs them, minus SDL presentation.
+    auto tick = [&](int frame) {
+        const Player& camera = path.frames[frame % path.frames.size()];
+        updateDoors(doors, camera, 1.0 / 60.0);
+        updateEntities(entities, map, doors, collision, 1.0 / 60.0);
+        collision.sync(entities);
+        computeVisibleRegions(pvs, doors, camera.x, camera.y, visible);
+        renderWorld(rc, map, doors, entities, camera, cfg, tm, target, &visible);
+    };
+    for (int i = 0; i < 10; ++i) {
+        tick(i); // warm-up: the arena and visible set reach their working size
+    }
+    AllocationCounters used;
+    {
+        AllocationCountScope counting;
+        AllocationCounters start = allocationCounters();
+        for (int i = 0; i < frames; ++i) {
+            tick(10 + i);
+        }
+        used = allocationsSince(start);
+    }
+    freeTextures(tm);
+
+    std::cout << "alloc: " << frames << " steady-state frames, " << used.count << " heap allocations (" << used.bytes
+              << " bytes); frame arena " << rc.arena.capacity() / 1024 << " KiB, grown " << rc.arena.growCount() << " times\n";
+    if (used.count != 0) {
+        std::cerr << "steady-state frames must not allocate\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchViews(const std::vector<std::string>& args) {
+    int frames = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 120;
+    std::vector<unsigned> threadCounts;
+    for (size_t i = 2; i < args.size(); ++i) {
+        threadCounts.push_back(static_cast<unsigned>(std::max(1, std::atoi(args[i].c_str()))));
+    }
+    if (threadCounts.empty()) {
+        threadCounts = {1u, workerPool().concurrency()};
+    }
+    Config cfg{};
+    Map map = createRandomMap(36u, 96, 96);
+    std::vector<Door> doors = extractDoors(map);
+    EntityStore entities = entitiesFromSprites(createSprites(map, 36u));
+    CameraPath path = generateRoomTour(map, doors);
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+    std::vector<Uint32> pixels(static_cast<size_t>(cfg.screenWidth) * cfg.screenHeight);
+    FrameTarget target{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth};
+    SDL_Rect quad[4];
+    splitScreenLayout(cfg.screenWidth, cfg.screenHeight, 4, quad);
+    auto camera = [&](int frame) { return path.frames[frame % path.frames.size()]; };
+
+    std::cout << "views: " << frames << " frames, " << cfg.screenWidth << "x" << cfg.screenHeight << " frame, "
+              << quad[0].w << "x" << quad[0].h << " quadrants\n";
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool(threads - 1);
+        RenderContext rc;
+        rc.pool = &pool;
+        auto timeFrames = [&](auto&& render) {
+            for (int i = 0; i < 5; ++i) {
+                render(i);
+            }
+            auto start = Clock::now();
+            for (int i = 0; i < frames; ++i) {
+                render(i);
+            }
+            return elapsedMs(start) / frames;
+        };
+        double single = timeFrames([&](int i) {
+            renderWorld(rc, map, doors, entities, camera(i), cfg, tm, target);
+        });
+        // Four views, one schedule: the columns of every quadrant share the pool.
+        RenderView views[4];
+        double joint = timeFrames([&](int i) {
+            for (int v = 0; v < 4; ++v) {
+                views[v] = RenderView{cameraForViewport(camera(i + v * 97), cfg.screenWidth, cfg.screenHeight, quad[v]), quad[v], nullptr};
+            }
+            renderViews(rc, map, doors, entities, views, 4, cfg, tm, target);
+        });
+        // The same four views rendered back to back, each waiting for the pool to drain.
+        double serial = timeFrames([&](int i) {
+            for (int v = 0; v < 4; ++v) {
+                views[v] = RenderView{cameraForViewport(camera(i + v * 97), cfg.screenWidth, cfg.screenHeight, quad[v]), quad[v], nullptr};
+                renderViews(rc, map, doors, entities, &views[v], 1, cfg, tm, target);
+            }
+        });
+        std::cout << std::fixed << std::setprecision(3) << "  " << threads << " thread(s): 1 view " << single
+                  << " ms, 4 views " << joint << " ms (" << joint / single << "x), 4 views one at a time " << serial
+                  << " ms\n";
+    }
+    freeTextures(tm);
+    return 0;
+}
+
+int benchServer(const std::vector<std::string>& args) {
+    int ticks = args.size() > 1 ? std::max(10, std::atoi(args[1].c_str())) : 600;
+    std::vector<int> playerCounts;
+    for (size_t i = 2; i < args.size(); ++i) {
+        playerCounts.push_back(std::max(1, std::atoi(args[i].c_str())));
+    }
+    if (playerCounts.empty()) {
+        playerCounts = {16, 64, 256, 512};
+    }
+    Config cfg{};
+    const double dt = 1.0 / 120.0;
+    std::cout << "server: " << ticks << " ticks at " << 1.0 / dt << " Hz simulated time, " << workerPool().concurrency()
+              << " thread(s)\n";
+    if (!reserveClientLinks(*std::max_element(playerCounts.begin(), playerCounts.end()))) {
+        return 1;
+    }
+    int failures = 0;
+    for (int players : playerCounts) {
+        SimulationServer server(createRandomMap(37u, 128, 128), cfg);
+        std::vector<std::unique_ptr<SnapshotClient>> clients;
+        for (int i = 0; i < players; ++i) {
+            SocketHandle socket = server.connectClient(botSpawn(server.map(), i));
+            if (socket == INVALID_SOCKET_HANDLE) {
+                std::cerr << "could not connect all " << players << " clients\n";
+                return 1;
+            }
+            clients.push_back(std::make_unique<SnapshotClient>(socket));
+        }
+        std::vector<double> tickMs;
+        tickMs.reserve(ticks);
+        for (int t = 1; t <= ticks; ++t) {
+            for (int i = 0; i < players; ++i) {
+                clients[i]->receive();
+                clients[i]->sendInput(scriptedBotInput(i, static_cast<Uint32>(t)));
+            }
+            server.tick(dt);
+            tickMs.push_back(server.stats().lastTickMs);
+        }
+
+        // Every client must have rebuilt exactly what the server last sent it.
+        int mismatches = 0;
+        size_t fullBytes = 0;
+        std::vector<Uint8> full;
+        for (int i = 0; i < players; ++i) {
+            clients[i]->receive();
+            const WorldSnapshot& truth = server.lastSent(i);
+            const WorldSnapshot& rebuilt = clients[i]->latest();
+            bool same = rebuilt.tick == truth.tick && rebuilt.doors == truth.doors && rebuilt.players.size() == truth.players.size();
+            for (size_t j = 0; same && j < truth.players.size(); ++j) {
+                const NetPlayer& a = truth.players[j];
+                const NetPlayer& b = rebuilt.players[j];
+                same = a.present == b.present && a.x == b.x && a.y == b.y && a.angle == b.angle;
+            }
+            mismatches += same ? 0 : 1;
+            full.clear();
+            encodeSnapshot(truth, nullptr, full);
+            fullBytes += full.size();
+        }
+        failures += mismatches;
+
+        const ServerStats& stats = server.stats();
+        std::vector<double> sorted = tickMs;
+        std::sort(sorted.begin(), sorted.end());
+        double meanMs = 0.0;
+        for (double ms : tickMs) {
+            meanMs += ms;
+        }
+        meanMs /= tickMs.size();
+        std::cout << std::fixed << std::setprecision(3) << "  " << std::setw(4) << players << " players: tick " << meanMs
+                  << " ms mean, " << sorted[sorted.size() * 99 / 100] << " ms p99 (" << std::setprecision(0)
+                  << 1000.0 / meanMs << " Hz max); " << std::setprecision(1)
+                  << static_cast<double>(stats.snapshotBytes) / std::max<Uint64>(1, stats.snapshots)
+                  << " bytes/player/tick delta vs " << static_cast<double>(fullBytes) / players << " full; "
+                  << stats.fullSnapshots << " full sends, " << stats.droppedSnapshots << " dropped, " << mismatches
+                  << " clients out of sync\n";
+    }
+    if (failures != 0) {
+        std::cerr << "decoded client state differs from what the server sent\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchSpans(const std::vector<std::string>& args) {
+    int frames = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 60;
+    const double tolerance = 0.005; // fraction of pixels allowed to differ from per-column casting
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+    Config cfg{};
+    std::vector<Uint32> reference(static_cast<size_t>(cfg.screenWidth) * cfg.screenHeight);
+    std::vector<Uint32> pixels(reference.size());
+    RenderContext rc;
+
+    struct Scene {
+        const char* name;
+        Map map;
+        std::vector<Player> poses;
+    };
+    std::vector<Scene> scenes;
+    scenes.push_back({"open hall", makeHallMap(64), {}});
+    for (int i = 0; i < 16; ++i) {
+        scenes.back().poses.push_back(cameraFromAngle(2.5 + i * 3.0, 4.5 + i * 2.0, i * 0.41)); // clear of every pillar
+    }
+    scenes.push_back({"corridor", makeCorridorMap(512), {}});
+    for (int i = 0; i < 16; ++i) {
+        scenes.back().poses.push_back(cameraFromAngle(1.5 + i * 20.0, 2.5, (i % 5 - 2) * 0.06));
+    }
+    Map level = createRandomMap(38u, 96, 96);
+    std::vector<Door> levelDoors = extractDoors(level);
+    CameraPath tour = generateRoomTour(level, levelDoors);
+    scenes.push_back({"level tour", level, {}});
+    for (size_t i = 0; i < tour.frames.size(); i += std::max<size_t>(1, tour.frames.size() / 32)) {
+        scenes.back().poses.push_back(tour.frames[i]);
+    }
+
+    std::cout << "spans: " << frames << " frames per scene, " << cfg.screenWidth << "x" << cfg.screenHeight << "\n";
+    bool withinTolerance = true;
+    for (const Scene& scene : scenes) {
+        std::vector<Door> doors = extractDoors(scene.map);
+        EntityStore entities;
+        double ms[2] = {0.0, 0.0};
+        double rays[2] = {0.0, 0.0};
+        for (int spans = 0; spans < 2; ++spans) {
+            cfg.wallSpans = spans != 0;
+            FrameTarget target{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth};
+            renderWorld(rc, scene.map, doors, entities, scene.poses[0], cfg, tm, target);
+            auto start = Clock::now();
+            for (int i = 0; i < frames; ++i) {
+                renderWorld(rc, scene.map, doors, entities, scene.poses[i % scene.poses.size()], cfg, tm, target);
+                rays[spans] += rc.lastFrameRays;
+            }
+            ms[spans] = elapsedMs(start) / frames;
+            rays[spans] /= frames;
+        }
+
+        // Every pose, pixel for pixel, against per-column casting.
+        size_t differing = 0;
+        int maxDelta = 0;
+        for (const Player& pose : scene.poses) {
+            cfg.wallSpans = false;
+            renderWorld(rc, scene.map, doors, entities, pose, cfg, tm, FrameTarget{reference.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth});
+            cfg.wallSpans = true;
+            renderWorld(rc, scene.map, doors, entities, pose, cfg, tm, FrameTarget{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth});
+            for (size_t i = 0; i < pixels.size(); ++i) {
+                if (pixels[i] == reference[i]) {
+                    continue;
+                }
+                ++differing;
+                for (int shift = 0; shift < 24; shift += 8) {
+                    int a = (pixels[i] >> shift) & 0xff;
+                    int b = (reference[i] >> shift) & 0xff;
+                    maxDelta = std::max(maxDelta, std::abs(a - b));
+                }
+            }
+        }
+        double fraction = static_cast<double>(differing) / (pixels.size() * scene.poses.size());
+        withinTolerance = withinTolerance && fraction <= tolerance;
+        std::cout << std::fixed << std::setprecision(3) << "  " << std::left << std::setw(11) << scene.name << std::right
+                  << " per-column " << ms[0] << " ms (" << std::setprecision(0) << rays[0] << " rays), spans "
+                  << std::setprecision(3) << ms[1] << " ms (" << std::setprecision(0) << rays[1] << " rays); "
+                  << std::setprecision(4) << 100.0 * fraction << "% pixels differ, max channel delta " << maxDelta << "\n";
+    }
+    freeTextures(tm);
+    if (!withinTolerance) {
+        std::cerr << "span renderer differs from per-column casting by more than " << tolerance * 100.0 << "% of pixels\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchFramebuffer(const std::vector<std::string>& args) {
+    int frames = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 30;
+    std::vector<std::pair<int, int>> sizes;
+    for (size_t i = 2; i < args.size(); ++i) {
+        int w = 0;
+        int h = 0;
+        if (std::sscanf(args[i].c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+            sizes.push_back({w, h});
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {{960, 640}, {1920, 1080}, {2560, 1440}, {3840, 2160}};
+    }
+    Map map = createRandomMap(43u, 96, 96);
+    std::vector<Door> doors = extractDoors(map);
+    EntityStore entities = entitiesFromSprites(createSprites(map, 43u));
+    CameraPath path = generateRoomTour(map, doors);
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+    ThreadPool& pool = workerPool();
+    RenderContext rc;
+    auto camera = [&](int frame) { return path.frames[(frame * 7) % path.frames.size()]; };
+
+    std::cout << "framebuffer: " << frames << " frames per size, " << pool.concurrency() << " thread(s), "
+              << transposeIsa() << " transpose\n";
+    bool identical = true;
+    for (const auto& [width, height] : sizes) {
+        Config cfg{};
+        cfg.screenWidth = width;
+        cfg.screenHeight = height;
+        std::vector<Uint32> rows(static_cast<size_t>(width) * height);
+        std::vector<Uint32> transposed(rows.size());
+        ColumnMajorFrame columnFrame;
+        columnFrame.resize(width, height);
+        FrameTarget rowTarget{rows.data(), width, height, width};
+        FrameTarget columnTarget{columnFrame.pixels.data(), width, height, 1, height};
+
+        renderWorld(rc, map, doors, entities, camera(0), cfg, tm, rowTarget);
+        auto start = Clock::now();
+        for (int i = 0; i < frames; ++i) {
+            renderWorld(rc, map, doors, entities, camera(i), cfg, tm, rowTarget);
+        }
+        double rowMs = elapsedMs(start) / frames;
+
+        renderWorld(rc, map, doors, entities, camera(0), cfg, tm, columnTarget);
+        double columnMs = 0.0;
+        double transposeMs = 0.0;
+        for (int i = 0; i < frames; ++i) {
+            start = Clock::now();
+            renderWorld(rc, map, doors, entities, camera(i), cfg, tm, columnTarget);
+            columnMs += elapsedMs(start);
+            start = Clock::now();
+            transposeColumnsToRows(columnTarget.pixels, width, height, height, transposed.data(), width, pool);
+            transposeMs += elapsedMs(start);
+        }
+        columnMs /= frames;
+        transposeMs /= frames;
+
+        // The transpose a plain loop would do: one thread, no tiling.
+        start = Clock::now();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                transposed[static_cast<size_t>(y) * width + x] = columnFrame.pixels[static_cast<size_t>(x) * height + y];
+            }
+        }
+        double naiveMs = elapsedMs(start);
+
+        renderWorld(rc, map, doors, entities, camera(frames), cfg, tm, rowTarget);
+        renderWorld(rc, map, doors, entities, camera(frames), cfg, tm, columnTarget);
+        transposeColumnsToRows(columnTarget.pixels, width, height, height, transposed.data(), width, pool);
+        bool same = rows == transposed;
+        identical = identical && same;
+        std::cout << std::fixed << std::setprecision(3) << "  " << width << "x" << height << ": row-major " << rowMs
+                  << " ms, column-major " << columnMs << " ms + transpose " << transposeMs << " ms = "
+                  << columnMs + transposeMs << " ms (" << rowMs / (columnMs + transposeMs) << "x); naive transpose "
+                  << naiveMs << " ms" << (same ? "" : "; OUTPUT DIFFERS") << "\n";
+    }
+    freeTextures(tm);
+    if (!identical) {
+        std::cerr << "column-major frames differ from row-major rendering\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchKernels(const std::vector<std::string>& args) {
+    int passes = args.size() > 1 ? std::max(1, std::atoi(args[1].c_str())) : 20;
+    const int screenW = 960;
+    const int screenH = 640;
+    std::vector<Uint32> reference(static_cast<size_t>(screenW) * screenH);
+    std::vector<Uint32> pixels(reference.size());
+    SDL_Surface* wall = makeCheckerSurface(3, false);
+    SDL_Surface* sprite = makeCheckerSurface(9, true);
+    const Uint32* wallTexels = static_cast<const Uint32*>(wall->pixels);
+    const Uint32* spriteTexels = static_cast<const Uint32*>(sprite->pixels);
+
+    // A frame's worth of columns per mode mix: wall heights from distant to far taller than the screen.
+    std::mt19937 rng(39u);
+    std::vector<WallColumn> walls(screenW);
+    std::vector<WallShade> shades(screenW);
+    std::vector<int> wallTexX(screenW), spriteTexX(screenW);
+    std::vector<SpriteStripe> stripes(screenW);
+    for (int x = 0; x < screenW; ++x) {
+        int lineHeight = 16 + static_cast<int>(rng() % (x % 4 == 0 ? 2400 : 600));
+        WallColumn& c = walls[x];
+        c.pitch = screenW;
+        c.screenH = screenH;
+        c.drawStart = -lineHeight / 2 + screenH / 2;
+        c.drawEnd = lineHeight / 2 + screenH / 2;
+        bool textured = rng() % 8 != 0;
+        wallTexX[x] = static_cast<int>(rng() % wall->w);
+        c.texels = textured ? wallTexels + wallTexX[x] : nullptr;
+        c.texStride = wall->pitch / 4;
+        c.texH = textured ? wall->h : 1;
+        c.texStep = static_cast<double>(c.texH) / lineHeight;
+        c.texPos = (c.drawStart - screenH / 2 + lineHeight / 2) * c.texStep;
+        c.flat = {200, 60, 60};
+        c.lightR = 200 + rng() % 120;
+        c.lightG = 200 + rng() % 120;
+        c.lightB = 200 + rng() % 120;
+        shades[x] = static_cast<WallShade>(rng() % 3);
+
+        int spriteHeight = 24 + static_cast<int>(rng() % 900);
+        SpriteStripe& s = stripes[x];
+        s.pitch = screenW;
+        s.screenH = screenH;
+        s.spriteHeight = spriteHeight;
+        s.startY = std::max(-spriteHeight / 2 + screenH / 2, 0);
+        s.endY = std::min(spriteHeight / 2 + screenH / 2, screenH - 1);
+        spriteTexX[x] = static_cast<int>(rng() % sprite->w);
+        s.texels = spriteTexels + spriteTexX[x];
+        s.texStride = sprite->pitch / 4;
+        s.texH = sprite->h;
+        s.light = LightLevel{static_cast<Uint16>(180 + rng() % 150), 256, static_cast<Uint16>(200 + rng() % 100)};
+    }
+    auto drawAll = [&](std::vector<Uint32>& out, bool specialised) {
+        for (int x = 0; x < screenW; ++x) {
+            WallColumn c = walls[x];
+            c.dst = out.data() + x;
+            if (specialised) {
+                bool clipped = c.drawStart < 0 || c.drawEnd >= screenH;
+                selectWallKernel(c.texels != nullptr, shades[x], clipped)(c);
+            } else {
+                drawWallColumnReference(c, shades[x], c.texels ? wall : nullptr, wallTexX[x]);
+            }
+        }
+        for (int x = 0; x < screenW; ++x) {
+            SpriteStripe s = stripes[x];
+            s.dst = out.data() + x;
+            bool lit = x % 2 == 0;
+            if (specialised) {
+                selectSpriteKernel(lit)(s);
+            } else {
+                drawSpriteStripeReference(s, lit, sprite, spriteTexX[x]);
+            }
+        }
+    };
+
+    std::cout << "kernels: " << passes << " passes of " << screenW << " wall columns and sprite stripes, " << screenW
+              << "x" << screenH << "\n";
+    double ms[2];
+    for (int specialised = 0; specialised < 2; ++specialised) {
+        std::vector<Uint32>& out = specialised ? pixels : reference;
+        drawAll(out, specialised != 0);
+        auto start = Clock::now();
+        for (int i = 0; i < passes; ++i) {
+            drawAll(out, specialised != 0);
+        }
+        ms[specialised] = elapsedMs(start) / passes;
+    }
+
+    // Columns that start on screen must match exactly; clipped ones may differ where the skipped
+    // rows' accumulated texture position rounds across a texel boundary.
+    size_t differing = 0, differingUnclipped = 0;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        if (pixels[i] != reference[i]) {
+            ++differing;
+            const WallColumn& c = walls[i % screenW];
+            differingUnclipped += (c.drawStart >= 0 && c.drawEnd < screenH) ? 1 : 0;
+        }
+    }
+    std::cout << std::fixed << std::setprecision(3) << "  generic loop " << ms[0] << " ms/frame, specialised " << ms[1]
+              << " ms/frame (" << std::setprecision(2) << ms[0] / ms[1] << "x); " << differing << " pixels differ ("
+              << differingUnclipped << " in unclipped columns)\n";
+    SDL_FreeSurface(wall);
+    SDL_FreeSurface(sprite);
+    if (differingUnclipped != 0) {
+        std::cerr << "specialised kernels differ from the generic loop on unclipped columns\n";
+        return 1;
+    }
+    return 0;
+}
+
+int benchLighting(const std::vector<std::string>& args) {
+    int size = args.size() > 1 ? std::max(16, std::atoi(args[1].c_str())) : 256;
+    int frames = args.size() > 2 ? std::max(1, std::atoi(args[2].c_str())) : 60;
+    Map map = createRandomMap(99u, size, size);
+    std::vector<Door> doors = extractDoors(map);
+    // Denser than the game's sprite count so every room has lights to bake.
+    EntityStore entities;
+    std::mt19937 rng(3);
+    for (const auto& room : map.rooms) {
+        addEntity(entities, room.x + 0.5 + rng() % room.w, room.y + 0.5 + rng() % room.h, LIGHT_SPRITE_ID, ENTITY_VISIBLE);
+    }
+    std::vector<LightSource> lights = collectLights(entities);
+
+    ThreadPool serial(0);
+    Lightmap single = bakeLightmap(map, doors, lights, serial);
+    Lightmap lm = bakeLightmap(map, doors, lights, workerPool());
+    std::cout << "lighting: " << map.width << "x" << map.height << " map, " << lights.size() << " lights, " << doors.size() << " doors\n";
+    std::cout << std::fixed << std::setprecision(2) << "  full bake: " << single.bakeMs << " ms on 1 thread, " << lm.bakeMs
+              << " ms on " << workerPool().concurrency() << "\n";
+
+    // Door toggles rebake locally; the result must match a from-scratch bake.
+    std::uniform_int_distribution<size_t> doorDist(0, doors.empty() ? 0 : doors.size() - 1);
+    const int toggles = doors.empty() ? 0 : 100;
+    double rebakeMs = 0.0;
+    for (int i = 0; i < toggles; ++i) {
+        Door& door = doors[doorDist(rng)];
+        door.openAmount = door.openAmount > 0.0 ? 0.0 : 1.0;
+        syncLightmapDoors(lm, map, doors);
+        rebakeMs += lm.bakeMs;
+    }
+    Lightmap fresh = bakeLightmap(map, doors, lights);
+    size_t differ = 0;
+    for (size_t i = 0; i < fresh.faces.size(); ++i) {
+        const LightLevel& a = fresh.faces[i];
+        const LightLevel& b = lm.faces[i];
+        differ += (a.r != b.r || a.g != b.g || a.b != b.b) ? 1 : 0;
+    }
+    std::cout << "  door rebake: " << (toggles ? rebakeMs / toggles : 0.0) << " ms avg over " << toggles << " toggles ("
+              << differ << " faces differ from a full bake)\n";
+
+    Config cfg{};
+    TextureManager tm = loadTextures();
+    fillMissingTextures(tm);
+    std::vector<Uint32> pixels(static_cast<size_t>(cfg.screenWidth) * cfg.screenHeight);
+    FrameTarget target{pixels.data(), cfg.screenWidth, cfg.screenHeight, cfg.screenWidth};
+    RenderContext rc;
+    const MapRoom& room = map.rooms.empty() ? MapRoom{1, 1, 1, 1} : map.rooms[0];
+    Player camera = cameraFromAngle(room.x + room.w / 2.0, room.y + room.h / 2.0, 0.3);
+    for (bool lit : {false, true}) {
+        cfg.lighting = lit;
+        renderWorld(rc, map, doors, entities, camera, cfg, tm, target, nullptr, &lm);
+        auto start = Clock::now();
+        for (int i = 0; i < frames; ++i) {
+            renderWorld(rc, map, doors, entities, camera, cfg, tm, target, nullptr, &lm);
+        }
+        std::cout << "  " << (lit ? "lit  " : "unlit") << " frame: " << elapsedMs(start) / frames << " ms\n";
+    }
+    freeTextures(tm);
+    return differ == 0 ? 0 : 1;
+}
+
+struct Benchmark {
+    const char* name;
+    const char* description;
+    int (*run)(const std::vector<std::string>& args);
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"assets", "[manifest] [cache] - texture startup time, cold decode vs mapped cache archive", benchAssets},
+    {"entities", "[count] [ticks] - parallel wandering-actor update throughput", benchEntities},
+    {"collision", "[wanderer counts...] - collision grid sync and query cost, actor update with and without it; checks queries", benchCollision},
+    {"snapshot", "[map size] [wanderers] - copy-on-write level snapshot cost vs full copies; checks a rewind restores the state", benchSnapshot},
+    {"visibility", "[queries] [map size] - batched line-of-sight throughput", benchVisibility},
+    {"pathfinding", "[queries] [map sizes...] - JPS query latency and flow-field build vs door-repair time; fails on a wrong cost or repair", benchPathfinding},
+    {"pvs", "[map sizes...] - region PVS build time and visible-set query cost; fails if a cell in line of sight is culled", benchPvs},
+    {"alloc", "[frames] - fails if steady-state simulation and world rendering touch the heap", benchAlloc},
+    {"lighting", "[map size] [frames] - lightmap bake and door rebake time, lit vs unlit frame cost", benchLighting},
+    {"server", "[ticks] [player counts...] - headless server tick time and delta snapshot bytes per player", benchServer},
+    {"framebuffer", "[frames] [WxH...] - column-major target plus transpose vs direct row-major writes per resolution", benchFramebuffer},
+    {"kernels", "[passes] - specialised wall and sprite column kernels vs the generic per-pixel loop", benchKernels},
+    {"spans", "[frames] - span-based vs per-column wall casting on an open hall, a corridor and a level; checks pixels", benchSpans},
+    {"views", "[frames] [threads...] - one full view vs four split-screen views, scheduled jointly and one at a time", benchViews},
+    {"mipmaps", "[frames] - long-corridor frame time and cache misses, full-res vs mipmapped", benchMipmaps},
+};
+} // namespace
+
+int runBenchmark(const std::vector<std::string>& args) {
+    std::string name = args.empty() ? "list" : args[0];
+    for (const auto& bench : BENCHMARKS) {
+        if (name == bench.name) {
+            IMG_Init(IMG_INIT_PNG);
+            int result = bench.run(args);
+            IMG_Quit();
+            return result;
+        }
+    }
+    if (name != "list") {
+        std::cerr << "Unknown benchmark: " << name << "\n";
+    }
+    std::cout << "Benchmarks (run with --bench <name> [args]):\n";
+    for (const auto& bench : BENCHMARKS) {
+        std::cout << "  " << bench.name << " " << bench.description << "\n";
+    }
+    return name == "list" ? 0 : 1;
+}
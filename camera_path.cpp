@@ -0,0 +1,136 @@
+#include "camera_path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "pathfinding.h"
+
+namespace {
+const double LOOK_AHEAD = 1.5; // cells; heading follows a point ahead on the path so turns are smooth
+
+struct PathPoint {
+    double x;
+    double y;
+};
+
+// Position at arc length s along the polyline.
+PathPoint pointAt(const std::vector<PathPoint>& points, const std::vector<double>& lengths, double s) {
+    if (s <= 0.0) {
+        return points.front();
+    }
+    for (size_t i = 1; i < points.size(); ++i) {
+        if (s <= lengths[i] || i + 1 == points.size()) {
+            double segment = lengths[i] - lengths[i - 1];
+            double t = segment > 0.0 ? std::min(1.0, (s - lengths[i - 1]) / segment) : 1.0;
+            return {points[i - 1].x + (points[i].x - points[i - 1].x) * t, points[i - 1].y + (points[i].y - points[i - 1].y) * t};
+        }
+    }
+    return points.back();
+}
+} // namespace
+
+Player cameraFromAngle(double x, double y, double angle) {
+    double dirX = std::cos(angle);
+    double dirY = std::sin(angle);
+    return Player{x, y, dirX, dirY, dirY * 0.66, -dirX * 0.66};
+}
+
+bool loadCameraPath(const std::string& file, CameraPath& path) {
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "Failed to open camera path " << file << "\n";
+        return false;
+    }
+    path.frames.clear();
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream iss(line);
+        double x, y, angle;
+        if (!(iss >> x)) {
+            continue; // blank or comment
+        }
+        if (!(iss >> y >> angle)) {
+            std::cerr << file << ":" << lineNo << ": expected \"x y angle\"\n";
+            return false;
+        }
+        path.frames.push_back(cameraFromAngle(x, y, angle));
+    }
+    if (path.frames.empty()) {
+        std::cerr << "Camera path " << file << " has no frames\n";
+        return false;
+    }
+    return true;
+}
+
+bool saveCameraPath(const std::string& file, const CameraPath& path) {
+    std::ofstream out(file);
+    if (!out) {
+        std::cerr << "Failed to write camera path " << file << "\n";
+        return false;
+    }
+    out << "# camera path: x y angle (radians), one line per frame\n";
+    out.precision(6);
+    out << std::fixed;
+    for (const auto& p : path.frames) {
+        out << p.x << " " << p.y << " " << std::atan2(p.dirY, p.dirX) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+CameraPath generateRoomTour(const Map& map, const std::vector<Door>& doors, int maxRooms, double cellsPerFrame) {
+    CameraPath path;
+    std::vector<PathPoint> points;
+    PathService service(map, doors);
+    std::vector<GridPoint> waypoints;
+    int rooms = std::min(static_cast<int>(map.rooms.size()), maxRooms);
+    for (int i = 0; i + 1 < rooms; ++i) {
+        const MapRoom& a = map.rooms[i];
+        const MapRoom& b = map.rooms[i + 1];
+        if (!service.findPath({a.x + a.w / 2, a.y + a.h / 2}, {b.x + b.w / 2, b.y + b.h / 2}, waypoints)) {
+            continue;
+        }
+        for (const auto& w : waypoints) {
+            PathPoint p{w.x + 0.5, w.y + 0.5};
+            if (points.empty() || points.back().x != p.x || points.back().y != p.y) {
+                points.push_back(p);
+            }
+        }
+    }
+
+    if (points.size() < 2) {
+        // Nothing to fly between: turn once on the spot.
+        PathPoint centre{map.width / 2.0, map.height / 2.0};
+        if (!map.rooms.empty()) {
+            centre = {map.rooms[0].x + map.rooms[0].w / 2 + 0.5, map.rooms[0].y + map.rooms[0].h / 2 + 0.5};
+        }
+        for (int f = 0; f < 360; ++f) {
+            path.frames.push_back(cameraFromAngle(centre.x, centre.y, f * 6.283185307179586 / 360.0));
+        }
+        return path;
+    }
+
+    std::vector<double> lengths(points.size(), 0.0);
+    for (size_t i = 1; i < points.size(); ++i) {
+        lengths[i] = lengths[i - 1] + std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+    }
+    double total = lengths.back();
+    double angle = 0.0;
+    for (double s = 0.0; s <= total; s += cellsPerFrame) {
+        PathPoint p = pointAt(points, lengths, s);
+        PathPoint ahead = pointAt(points, lengths, std::min(total, s + LOOK_AHEAD));
+        if (ahead.x != p.x || ahead.y != p.y) {
+            angle = std::atan2(ahead.y - p.y, ahead.x - p.x);
+        }
+        path.frames.push_back(cameraFromAngle(p.x, p.y, angle));
+    }
+    return path;
+}
@@ -0,0 +1,114 @@
+#include "capture.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "console.h"
+
+FrameCapture::FrameCapture(int width, int height, size_t bufferCount, unsigned writerThreads)
+    : queue_(width, height, bufferCount, writerThreads, ImageFormat::PNG) {}
+
+void FrameCapture::requestScreenshot(std::string path) {
+    screenshotPath_ = std::move(path);
+}
+
+bool FrameCapture::startRecording(const std::string& dir, ImageFormat format) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        std::cerr << "Failed to create " << dir << ": " << ec.message() << "\n";
+        return false;
+    }
+    recordDir_ = dir;
+    recordFormat_ = format;
+    recording_ = true;
+    frameIndex_ = 0;
+    return true;
+}
+
+void FrameCapture::stopRecording() {
+    recording_ = false;
+}
+
+void FrameCapture::offer(const Uint32* pixels, int width, int height, int pitch) {
+    auto start = std::chrono::steady_clock::now();
+    // A screenshot and a recorded frame may want the same image; each gets its own buffer.
+    for (int pass = 0; pass < 2; ++pass) {
+        bool screenshot = pass == 0;
+        if (screenshot ? screenshotPath_.empty() : !recording_) {
+            continue;
+        }
+        ImageBuffer* buffer = queue_.tryAcquire();
+        if (!buffer) {
+            // A screenshot waits for the next frame; a recording loses this one.
+            dropped_ += screenshot ? 0 : 1;
+            continue;
+        }
+        if (buffer->width != width || buffer->height != height) {
+            // Only after the 3D view was resized (r_scale); steady recording reuses the buffers as they are.
+            buffer->pixels.resize(static_cast<size_t>(width) * height);
+            buffer->width = width;
+            buffer->height = height;
+        }
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(buffer->pixels.data() + static_cast<size_t>(y) * width, pixels + static_cast<size_t>(y) * pitch, width * sizeof(Uint32));
+        }
+        ++captured_;
+        if (screenshot) {
+            ImageFormat format = std::filesystem::path(screenshotPath_).extension() == ".ppm" ? ImageFormat::PPM : ImageFormat::PNG;
+            queue_.submit(buffer, std::move(screenshotPath_), format);
+            screenshotPath_.clear();
+        } else {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%06zu", frameIndex_++);
+            queue_.submit(buffer, (std::filesystem::path(recordDir_) / (std::string(name) + imageExtension(recordFormat_))).string(), recordFormat_);
+        }
+    }
+    lastCopyMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void takeScreenshot(ConsoleState& console, FrameCapture& capture, std::string file) {
+    while (file.empty() || (file.rfind("screenshot_", 0) == 0 && std::filesystem::exists(file))) {
+        file = "screenshot_" + std::to_string(capture.nextScreenshotNumber()) + ".png";
+    }
+    capture.requestScreenshot(file);
+    consolePrint(console, "Saving " + file);
+}
+
+void registerCaptureCommands(ConsoleState& console, FrameCapture& capture) {
+    registerConsoleCommand(console, "screenshot", "screenshot [file]", "Save the next 3D frame (.png or .ppm)", [&capture](ConsoleState& con, const std::vector<std::string>& args) {
+        takeScreenshot(con, capture, args.size() >= 2 ? args[1] : "");
+    });
+    registerConsoleCommand(console, "record", "record [dir] [ppm|png]", "Write every 3D frame to dir; record_stop ends", [&capture](ConsoleState& con, const std::vector<std::string>& args) {
+        std::string dir = args.size() >= 2 ? args[1] : "capture";
+        ImageFormat format = ImageFormat::PPM;
+        if (args.size() >= 3 && !parseImageFormat(args[2], format)) {
+            consolePrint(con, "Usage: record [dir] [ppm|png]");
+            return;
+        }
+        if (capture.recording()) {
+            consolePrint(con, "Already recording; record_stop first");
+        } else if (capture.startRecording(dir, format)) {
+            consolePrint(con, "Recording to " + dir);
+        } else {
+            consolePrint(con, "Could not create " + dir);
+        }
+    });
+    registerConsoleCommand(console, "record_stop", "record_stop", "Stop recording frames", [&capture](ConsoleState& con, const std::vector<std::string>&) {
+        if (!capture.recording()) {
+            consolePrint(con, "Not recording");
+            return;
+        }
+        capture.stopRecording();
+        consolePrint(con, "Recorded " + std::to_string(capture.recordedFrames()) + " frames, " + std::to_string(capture.dropped()) + " dropped so far");
+    });
+    registerConsoleCommand(console, "capture_stats", "capture_stats", "Captured, written and dropped frame counts", [&capture](ConsoleState& con, const std::vector<std::string>&) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "captured %zu, written %zu, failed %zu, dropped %zu; queue peak %zu, last copy %.2f ms",
+                      capture.captured(), capture.written(), capture.failed(), capture.dropped(), capture.maxQueued(), capture.lastCopyMs());
+        consolePrint(con, line);
+    });
+}
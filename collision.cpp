@@ -0,0 +1,185 @@
+#include "collision.h"
+
+#include "doors.h"
+#include "entities.h"
+#include "lighting.h"
+
+namespace {
+// One axis of sweepCircle, written for x; `alongY` swaps the roles of the map axes.
+double sweepAxis(const Map& map, const std::vector<Door>& doors, bool alongY, double along, double across, double radius, double d, bool& blocked) {
+    double target = along + d;
+    if (d == 0.0) {
+        return along;
+    }
+    int acrossFirst = static_cast<int>(std::floor(across - radius));
+    int acrossLast = static_cast<int>(std::floor(across + radius));
+    // Only cells entirely ahead of the centre can stop the move.
+    int first = d > 0.0 ? static_cast<int>(std::ceil(along)) : static_cast<int>(std::floor(target - radius));
+    int last = d > 0.0 ? static_cast<int>(std::floor(target + radius)) : static_cast<int>(std::floor(along)) - 1;
+    double result = target;
+    for (int c = first; c <= last; ++c) {
+        for (int a = acrossFirst; a <= acrossLast; ++a) {
+            if (!(alongY ? cellBlocksMovement(map, doors, a, c) : cellBlocksMovement(map, doors, c, a))) {
+                continue;
+            }
+            // Distance from the centre line to the cell across the move; the face or corner is touched
+            // where the circle's chord at that distance meets it.
+            double gap = std::max({0.0, a - across, across - (a + 1.0)});
+            if (gap >= radius) {
+                continue;
+            }
+            double reach = std::sqrt(radius * radius - gap * gap);
+            if (d > 0.0 && c - reach < result) {
+                result = std::max(along, c - reach);
+                blocked = true;
+            } else if (d < 0.0 && c + 1.0 + reach > result) {
+                result = std::min(along, c + 1.0 + reach);
+                blocked = true;
+            }
+        }
+    }
+    return result;
+}
+} // namespace
+
+bool cellBlocksMovement(const Map& map, const std::vector<Door>& doors, int x, int y) {
+    int tile = map.at(x, y);
+    if (tile == 0) {
+        return false;
+    }
+    if (tile == DOOR_TILE) {
+        const Door* door = findDoor(doors, x, y);
+        return !door || !doorPassable(*door);
+    }
+    return true;
+}
+
+CircleMove sweepCircle(const Map& map, const std::vector<Door>& doors, double x, double y, double radius, double dx, double dy) {
+    CircleMove move{x, y, false, false};
+    move.x = sweepAxis(map, doors, false, x, y, radius, dx, move.blockedX);
+    move.y = sweepAxis(map, doors, true, y, move.x, radius, dy, move.blockedY);
+    return move;
+}
+
+void CollisionGrid::reset(int width, int height, double cellSize) {
+    invCellSize_ = 1.0 / cellSize;
+    cellsW_ = std::max(1, static_cast<int>(std::ceil(width * invCellSize_)));
+    cellsH_ = std::max(1, static_cast<int>(std::ceil(height * invCellSize_)));
+    head_.assign(static_cast<size_t>(cellsW_) * cellsH_, -1);
+    next_.clear();
+    prev_.clear();
+    cell_.clear();
+    x_.clear();
+    y_.clear();
+    radius_.clear();
+    maxRadius_ = 0.0;
+    colliders_ = 0;
+    relinks_ = 0;
+}
+
+void CollisionGrid::link(int id, int cell) {
+    cell_[id] = cell;
+    prev_[id] = -1;
+    next_[id] = head_[cell];
+    if (next_[id] >= 0) {
+        prev_[next_[id]] = id;
+    }
+    head_[cell] = id;
+}
+
+void CollisionGrid::unlink(int id) {
+    if (prev_[id] >= 0) {
+        next_[prev_[id]] = next_[id];
+    } else {
+        head_[cell_[id]] = next_[id];
+    }
+    if (next_[id] >= 0) {
+        prev_[next_[id]] = prev_[id];
+    }
+    cell_[id] = -1;
+}
+
+void CollisionGrid::sync(const EntityStore& entities) {
+    size_t known = cell_.size();
+    size_t count = entities.size();
+    next_.resize(count, -1);
+    prev_.resize(count, -1);
+    cell_.resize(count, -1);
+    x_.resize(count);
+    y_.resize(count);
+    radius_.resize(count, 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+        int id = static_cast<int>(i);
+        float radius = entities.radius[i];
+        x_[i] = entities.x[i];
+        y_[i] = entities.y[i];
+        if (i >= known || radius != radius_[i]) {
+            // New entity or a changed radius: (re)insert from scratch.
+            if (cell_[i] >= 0) {
+                unlink(id);
+                --colliders_;
+            }
+            radius_[i] = radius;
+            if (radius > 0.0f) {
+                link(id, cellY(y_[i]) * cellsW_ + cellX(x_[i]));
+                maxRadius_ = std::max(maxRadius_, static_cast<double>(radius));
+                ++colliders_;
+            }
+            continue;
+        }
+        if (cell_[i] < 0) {
+            continue;
+        }
+        int cell = cellY(y_[i]) * cellsW_ + cellX(x_[i]);
+        if (cell != cell_[i]) {
+            unlink(id);
+            link(id, cell);
+            ++relinks_;
+        }
+    }
+}
+
+CircleMove moveCircle(const Map& map, const std::vector<Door>& doors, const CollisionGrid* grid, double x, double y, double radius, double dx, double dy, int self) {
+    CircleMove move = sweepCircle(map, doors, x, y, radius, dx, dy);
+    if (!grid) {
+        return move;
+    }
+    double pushX = 0.0;
+    double pushY = 0.0;
+    grid->forEachOverlap(move.x, move.y, radius, self, [&](int, double ox, double oy, double distanceSquared, double minDistance) {
+        double distance = std::sqrt(distanceSquared);
+        if (distance < 1e-9) {
+            // Same centre: the whole of minDistance overlaps; back out along the move, or along +x.
+            double length = std::sqrt(dx * dx + dy * dy);
+            pushX += length > 0.0 ? -dx / length * minDistance : minDistance;
+            pushY += length > 0.0 ? -dy / length * minDistance : 0.0;
+            return;
+        }
+        pushX += ox / distance * (minDistance - distance);
+        pushY += oy / distance * (minDistance - distance);
+    });
+    if (pushX == 0.0 && pushY == 0.0) {
+        return move;
+    }
+    CircleMove pushed = sweepCircle(map, doors, move.x, move.y, radius, pushX, pushY);
+    pushed.blockedX = pushed.blockedX || move.blockedX || pushX != 0.0;
+    pushed.blockedY = pushed.blockedY || move.blockedY || pushY != 0.0;
+    return pushed;
+}
+
+void assignSpriteColliders(EntityStore& entities, const Map& map) {
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (entities.flags[i] & ENTITY_WANDER || entities.textureId[i] == LIGHT_SPRITE_ID) {
+            continue;
+        }
+        int cx = static_cast<int>(entities.x[i]);
+        int cy = static_cast<int>(entities.y[i]);
+        bool open = true;
+        for (int y = cy - 1; y <= cy + 1 && open; ++y) {
+            for (int x = cx - 1; x <= cx + 1 && open; ++x) {
+                open = map.at(x, y) == 0;
+            }
+        }
+        entities.radius[i] = open ? SPRITE_RADIUS : 0.0f;
+    }
+}
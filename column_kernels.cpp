@@ -0,0 +1,169 @@
+#include "column_kernels.h"
+
+#include <algorithm>
+#include <array>
+
+#include "textures.h"
+
+namespace {
+// c * 0.7 truncated, exactly as the per-channel double multiply rounds.
+const std::array<Uint8, 256> SIDE_SHADE = [] {
+    std::array<Uint8, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        table[i] = static_cast<Uint8>(i * 0.7);
+    }
+    return table;
+}();
+
+Uint32 litChannel(Uint32 c, Uint32 light) {
+    return std::min<Uint32>(255, (c * light) >> 8);
+}
+
+template <WallShade Shade>
+Uint32 shadeTexel(Uint32 texel, const WallColumn& c) {
+    Uint32 r = (texel >> 16) & 0xff;
+    Uint32 g = (texel >> 8) & 0xff;
+    Uint32 b = texel & 0xff;
+    if constexpr (Shade == WallShade::Side) {
+        r = SIDE_SHADE[r];
+        g = SIDE_SHADE[g];
+        b = SIDE_SHADE[b];
+    } else if constexpr (Shade == WallShade::Lit) {
+        r = litChannel(r, c.lightR);
+        g = litChannel(g, c.lightG);
+        b = litChannel(b, c.lightB);
+    }
+    return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+
+Uint32 packFlat(Color c) {
+    return (static_cast<Uint32>(c.r) << 16) | (static_cast<Uint32>(c.g) << 8) | c.b;
+}
+
+template <bool Textured, WallShade Shade, bool Clipped>
+void wallKernel(const WallColumn& c) {
+    int first = c.drawStart;
+    int last = c.drawEnd;
+    double texPos = c.texPos;
+    if constexpr (Clipped) {
+        first = std::max(first, 0);
+        last = std::min(last, c.screenH - 1);
+        texPos += (first - c.drawStart) * c.texStep;
+    }
+    Uint32* dst = c.dst + first * c.pitch;
+    if constexpr (!Textured) {
+        // An untextured column is one colour top to bottom.
+        Uint32 colour = shadeTexel<Shade>(packFlat(c.flat), c);
+        for (int y = first; y <= last; ++y, dst += c.pitch) {
+            *dst = colour;
+        }
+    } else {
+        const int mask = c.texH - 1;
+        for (int y = first; y <= last; ++y, dst += c.pitch) {
+            int texY = static_cast<int>(texPos) & mask;
+            texPos += c.texStep;
+            *dst = shadeTexel<Shade>(c.texels[texY * c.texStride], c);
+        }
+    }
+}
+
+Uint32 stripeTexel(const SpriteStripe& s, int y) {
+    int d = (y * 256) - (s.screenH * 128) + (s.spriteHeight * 128);
+    int texY = std::clamp(((d * s.texH) / s.spriteHeight) / 256, 0, s.texH - 1);
+    return s.texels[texY * s.texStride];
+}
+
+// Alpha-transparent or pure black texels are holes.
+bool opaqueTexel(Uint32 texel) {
+    return (texel >> 24) != 0 && (texel & 0x00ffffffu) != 0;
+}
+
+template <bool Lit>
+void spriteKernel(const SpriteStripe& s) {
+    Uint32* dst = s.dst + s.startY * s.pitch;
+    for (int y = s.startY; y <= s.endY; ++y, dst += s.pitch) {
+        Uint32 texel = stripeTexel(s, y);
+        bool opaque = opaqueTexel(texel);
+        Uint32 colour = 0xff000000u | texel;
+        if constexpr (Lit) {
+            colour = 0xff000000u | (litChannel((texel >> 16) & 0xff, s.light.r) << 16) |
+                     (litChannel((texel >> 8) & 0xff, s.light.g) << 8) | litChannel(texel & 0xff, s.light.b);
+        }
+        *dst = opaque ? colour : *dst;
+    }
+}
+
+template <bool Textured, WallShade Shade>
+WallKernel pickClipped(bool clipped) {
+    return clipped ? &wallKernel<Textured, Shade, true> : &wallKernel<Textured, Shade, false>;
+}
+
+template <bool Textured>
+WallKernel pickShade(WallShade shade, bool clipped) {
+    switch (shade) {
+    case WallShade::Side:
+        return pickClipped<Textured, WallShade::Side>(clipped);
+    case WallShade::Lit:
+        return pickClipped<Textured, WallShade::Lit>(clipped);
+    default:
+        return pickClipped<Textured, WallShade::None>(clipped);
+    }
+}
+} // namespace
+
+WallKernel selectWallKernel(bool textured, WallShade shade, bool clipped) {
+    return textured ? pickShade<true>(shade, clipped) : pickShade<false>(shade, clipped);
+}
+
+SpriteKernel selectSpriteKernel(bool lit) {
+    return lit ? &spriteKernel<true> : &spriteKernel<false>;
+}
+
+void countSpriteStripe(const SpriteStripe& s, Uint8* writes, int pitch) {
+    for (int y = s.startY; y <= s.endY; ++y) {
+        Uint8& count = writes[y * pitch];
+        count = static_cast<Uint8>(count + (opaqueTexel(stripeTexel(s, y)) && count < 255));
+    }
+}
+
+void drawWallColumnReference(const WallColumn& c, WallShade shade, SDL_Surface* surf, int texX) {
+    double texPos = c.texPos;
+    for (int y = c.drawStart; y <= c.drawEnd; ++y) {
+        if (y < 0 || y >= c.screenH) {
+            texPos += c.texStep;
+            continue;
+        }
+        int texY = static_cast<int>(texPos) & (c.texH - 1);
+        texPos += c.texStep;
+        Color col = surf ? sampleTexture(surf, texX, texY) : c.flat;
+        if (shade == WallShade::Lit) {
+            col.r = static_cast<Uint8>(litChannel(col.r, c.lightR));
+            col.g = static_cast<Uint8>(litChannel(col.g, c.lightG));
+            col.b = static_cast<Uint8>(litChannel(col.b, c.lightB));
+        } else if (shade == WallShade::Side) {
+            col.r = static_cast<Uint8>(col.r * 0.7);
+            col.g = static_cast<Uint8>(col.g * 0.7);
+            col.b = static_cast<Uint8>(col.b * 0.7);
+        }
+        c.dst[y * c.pitch] = 0xff000000u | packFlat(col);
+    }
+}
+
+void drawSpriteStripeReference(const SpriteStripe& s, bool lit, SDL_Surface* surf, int texX) {
+    for (int y = s.startY; y <= s.endY; ++y) {
+        int d = (y * 256) - (s.screenH * 128) + (s.spriteHeight * 128);
+        int texY = ((d * surf->h) / s.spriteHeight) / 256;
+        Uint32 pixel = sampleTextureRaw(surf, texX, texY);
+        Uint8 r, g, b, a;
+        SDL_GetRGBA(pixel, surf->format, &r, &g, &b, &a);
+        if (a == 0 || (r == 0 && g == 0 && b == 0)) {
+            continue;
+        }
+        if (lit) {
+            r = static_cast<Uint8>(litChannel(r, s.light.r));
+            g = static_cast<Uint8>(litChannel(g, s.light.g));
+            b = static_cast<Uint8>(litChannel(b, s.light.b));
+        }
+        s.dst[y * s.pitch] = 0xff000000u | (static_cast<Uint32>(r) << 16) | (static_cast<Uint32>(g) << 8) | b;
+    }
+}
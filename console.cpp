@@ -3,11 +3,15 @@
 #include <SDL2/SDL.h>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
 #include <sstream>
 
 namespace {
 void addLogLine(ConsoleState& console, const std::string& line) {
     console.log.push_back(line);
+    ++console.logged;
     const size_t maxLines = 200;
     if (console.log.size() > maxLines) {
         console.log.erase(console.log.begin(), console.log.begin() + (console.log.size() - maxLines));
@@ -51,6 +55,21 @@ void printHelp(ConsoleState& console) {
     addLogLine(console, "  set_sprint <v>     - Set sprint speed");
     addLogLine(console, "  wall_height <v>    - Set wall height scale");
     addLogLine(console, "  show_fps           - Toggle FPS counter");
+    addLogLine(console, "  mipmaps            - Toggle mipmapped textures");
+    addLogLine(console, "  lighting           - Toggle baked lighting");
+    addLogLine(console, "  spans              - Toggle span-based wall casting");
+    addLogLine(console, "  cvars [prefix]     - List console variables");
+    addLogLine(console, "  get <name>         - Show a variable");
+    addLogLine(console, "  set <name> <value> - Set a variable (or <name> <value>)");
+    addLogLine(console, "  reset <name|all>   - Restore defaults");
+    addLogLine(console, "  exec <file>        - Apply a file of cvar settings");
+    for (const auto& entry : console.commands) {
+        std::string usage = entry.second.usage;
+        if (usage.size() < 19) {
+            usage.resize(19, ' ');
+        }
+        addLogLine(console, "  " + usage + "- " + entry.second.help);
+    }
     addLogLine(console, "  quit/exit          - Quit the game");
 }
 
@@ -60,16 +79,77 @@ bool parseDouble(const std::string& s, double& out) {
     return !iss.fail() && iss.eof();
 }
 
+std::string formatNumber(double v) {
+    std::ostringstream oss;
+    oss << v;
+    return oss.str();
+}
+
+bool parseBool(const std::string& s, bool& out) {
+    std::string v = toLower(s);
+    if (v == "1" || v == "true" || v == "on") {
+        out = true;
+        return true;
+    }
+    if (v == "0" || v == "false" || v == "off") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+std::string describeRange(const Cvar& cvar) {
+    switch (cvar.type) {
+    case CvarType::Bool:
+        return "0|1";
+    case CvarType::Choice: {
+        std::string joined;
+        for (const std::string& choice : cvar.choices) {
+            joined += (joined.empty() ? "" : "|") + choice;
+        }
+        return joined;
+    }
+    default:
+        return formatNumber(cvar.minValue) + ".." + formatNumber(cvar.maxValue);
+    }
+}
+
+void printCvar(ConsoleState& console, const std::string& name, const Cvar& cvar) {
+    std::string value = cvar.get();
+    addLogLine(console, name + " = " + value + (value == cvar.defaultValue ? "" : " (default " + cvar.defaultValue + ")"));
+}
+
+void assignCvar(ConsoleState& console, const std::string& name, const std::string& text) {
+    std::string error;
+    if (setCvar(console, name, text, error)) {
+        printCvar(console, name, console.cvars[name]);
+    } else {
+        addLogLine(console, error);
+    }
+}
+
+// The old on/off commands flip the cvar that now backs them.
+void toggleCvar(ConsoleState& console, const std::string& name, const std::string& off, const std::string& on) {
+    auto it = console.cvars.find(name);
+    if (it == console.cvars.end()) {
+        addLogLine(console, "Unknown cvar: " + name);
+        return;
+    }
+    assignCvar(console, name, it->second.get() == on ? off : on);
+}
+
 void handleCommand(ConsoleState& console, const std::string& rawCmd, Config& cfg, Player& player, bool& running) {
     std::string cmd = trim(rawCmd);
     if (cmd.empty()) {
         return;
     }
     addLogLine(console, "> " + cmd);
-    std::vector<std::string> tokens = tokenize(toLower(cmd));
+    // Only the name is case-folded so arguments such as file paths survive intact.
+    std::vector<std::string> tokens = tokenize(cmd);
     if (tokens.empty()) {
         return;
     }
+    tokens[0] = toLower(tokens[0]);
     const std::string& name = tokens[0];
     if (name == "help") {
         printHelp(console);
@@ -86,43 +166,65 @@ void handleCommand(ConsoleState& console, const std::string& rawCmd, Config& cfg
         oss << std::fixed << "walk=" << cfg.moveSpeed << " sprint=" << cfg.moveSpeedSprint;
         addLogLine(console, oss.str());
     } else if (name == "set_speed" && tokens.size() >= 2) {
-        double v = 0.0;
-        if (parseDouble(tokens[1], v) && v > 0.0) {
-            cfg.moveSpeed = v;
-            std::ostringstream oss;
-            oss.precision(2);
-            oss << std::fixed << "walk speed set to " << v;
-            addLogLine(console, oss.str());
+        assignCvar(console, "move_speed", tokens[1]);
+    } else if (name == "set_sprint" && tokens.size() >= 2) {
+        assignCvar(console, "sprint_speed", tokens[1]);
+    } else if (name == "show_fps") {
+        console.showFPS = !console.showFPS;
+        addLogLine(console, std::string("FPS display ") + (console.showFPS ? "enabled" : "disabled"));
+    } else if (name == "mipmaps") {
+        toggleCvar(console, "r_textures", "full", "mipmapped");
+    } else if (name == "lighting") {
+        toggleCvar(console, "r_lighting", "0", "1");
+    } else if (name == "spans") {
+        toggleCvar(console, "r_spans", "0", "1");
+    } else if (name == "cvars") {
+        std::string prefix = tokens.size() >= 2 ? toLower(tokens[1]) : "";
+        for (const auto& [cvarName, cvar] : console.cvars) {
+            if (cvarName.compare(0, prefix.size(), prefix) == 0) {
+                addLogLine(console, "  " + cvarName + " " + cvar.get() + " [" + describeRange(cvar) + "] - " + cvar.help);
+            }
+        }
+    } else if (name == "get" && tokens.size() >= 2) {
+        std::string cvarName = toLower(tokens[1]);
+        if (console.cvars.count(cvarName)) {
+            printCvar(console, cvarName, console.cvars[cvarName]);
         } else {
-            addLogLine(console, "Invalid speed value");
+            addLogLine(console, "Unknown cvar: " + cvarName);
         }
-    } else if (name == "set_sprint" && tokens.size() >= 2) {
-        double v = 0.0;
-        if (parseDouble(tokens[1], v) && v > 0.0) {
-            cfg.moveSpeedSprint = v;
-            std::ostringstream oss;
-            oss.precision(2);
-            oss << std::fixed << "sprint speed set to " << v;
-            addLogLine(console, oss.str());
+    } else if (name == "set" && tokens.size() >= 3) {
+        assignCvar(console, toLower(tokens[1]), tokens[2]);
+    } else if (name == "reset" && tokens.size() >= 2) {
+        std::string cvarName = toLower(tokens[1]);
+        if (cvarName == "all") {
+            std::vector<std::string> names;
+            for (const auto& entry : console.cvars) {
+                names.push_back(entry.first);
+            }
+            std::string error;
+            for (const std::string& n : names) {
+                setCvar(console, n, console.cvars[n].defaultValue, error);
+            }
+            addLogLine(console, std::to_string(names.size()) + " cvars reset");
+        } else if (console.cvars.count(cvarName)) {
+            assignCvar(console, cvarName, console.cvars[cvarName].defaultValue);
         } else {
-            addLogLine(console, "Invalid sprint value");
+            addLogLine(console, "Unknown cvar: " + cvarName);
         }
-    } else if (name == "wall_height" && tokens.size() >= 2) {
-        double v = 0.0;
-        if (parseDouble(tokens[1], v) && v > 0.1) {
-            cfg.wallHeight = v;
-            std::ostringstream oss;
-            oss.precision(2);
-            oss << std::fixed << "wall height set to " << v;
-            addLogLine(console, oss.str());
+    } else if (name == "exec" && tokens.size() >= 2) {
+        loadCvarFile(console, tokens[1]);
+    } else if (console.cvars.count(name)) {
+        if (tokens.size() >= 2) {
+            assignCvar(console, name, tokens[1]);
         } else {
-            addLogLine(console, "Invalid wall height value");
+            printCvar(console, name, console.cvars[name]);
         }
-    } else if (name == "show_fps") {
-        console.showFPS = !console.showFPS;
-        addLogLine(console, std::string("FPS display ") + (console.showFPS ? "enabled" : "disabled"));
     } else if (name == "quit" || name == "exit") {
         running = false;
+    } else if (console.commands.count(name)) {
+        // Copy so a command may re-register itself while running.
+        ConsoleCommandFn run = console.commands[name].run;
+        run(console, tokens);
     } else {
         addLogLine(console, "Unknown command: " + name);
     }
@@ -143,6 +245,152 @@ void submitInput(ConsoleState& console, Config& cfg, Player& player, bool& runni
 }
 } // namespace
 
+void registerConsoleCommand(ConsoleState& console, const std::string& name, const std::string& usage, const std::string& help, ConsoleCommandFn run) {
+    console.commands[toLower(name)] = ConsoleCommand{usage, help, std::move(run)};
+}
+
+void registerCvar(ConsoleState& console, const std::string& name, bool* value, const std::string& help, CvarChangedFn onChange) {
+    Cvar cvar;
+    cvar.type = CvarType::Bool;
+    cvar.help = help;
+    cvar.get = [value] { return std::string(*value ? "1" : "0"); };
+    cvar.assign = [value](const std::string& text) {
+        return parseBool(text, *value) ? std::string() : "expected 0 or 1";
+    };
+    cvar.onChange = std::move(onChange);
+    cvar.defaultValue = cvar.get();
+    console.cvars[toLower(name)] = std::move(cvar);
+}
+
+void registerCvar(ConsoleState& console, const std::string& name, int* value, int minValue, int maxValue, const std::string& help, CvarChangedFn onChange) {
+    Cvar cvar;
+    cvar.type = CvarType::Int;
+    cvar.help = help;
+    cvar.minValue = minValue;
+    cvar.maxValue = maxValue;
+    cvar.get = [value] { return std::to_string(*value); };
+    cvar.assign = [value, minValue, maxValue](const std::string& text) {
+        char* end = nullptr;
+        long v = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || v < minValue || v > maxValue) {
+            return "expected an integer in " + std::to_string(minValue) + ".." + std::to_string(maxValue);
+        }
+        *value = static_cast<int>(v);
+        return std::string();
+    };
+    cvar.onChange = std::move(onChange);
+    cvar.defaultValue = cvar.get();
+    console.cvars[toLower(name)] = std::move(cvar);
+}
+
+void registerCvar(ConsoleState& console, const std::string& name, double* value, double minValue, double maxValue, const std::string& help, CvarChangedFn onChange) {
+    Cvar cvar;
+    cvar.type = CvarType::Float;
+    cvar.help = help;
+    cvar.minValue = minValue;
+    cvar.maxValue = maxValue;
+    cvar.get = [value] { return formatNumber(*value); };
+    cvar.assign = [value, minValue, maxValue](const std::string& text) {
+        double v = 0.0;
+        if (!parseDouble(text, v) || v < minValue || v > maxValue) {
+            return "expected a number in " + formatNumber(minValue) + ".." + formatNumber(maxValue);
+        }
+        *value = v;
+        return std::string();
+    };
+    cvar.onChange = std::move(onChange);
+    cvar.defaultValue = cvar.get();
+    console.cvars[toLower(name)] = std::move(cvar);
+}
+
+void registerChoiceCvar(ConsoleState& console, const std::string& name, std::vector<std::string> choices, std::function<int()> get, std::function<void(int)> set, const std::string& help, CvarChangedFn onChange) {
+    Cvar cvar;
+    cvar.type = CvarType::Choice;
+    cvar.help = help;
+    cvar.choices = std::move(choices);
+    cvar.get = [choices = cvar.choices, get] {
+        int index = get();
+        return index >= 0 && index < static_cast<int>(choices.size()) ? choices[index] : std::to_string(index);
+    };
+    cvar.assign = [choices = cvar.choices, set](const std::string& text) {
+        auto it = std::find(choices.begin(), choices.end(), toLower(text));
+        if (it == choices.end()) {
+            std::string joined;
+            for (const std::string& choice : choices) {
+                joined += (joined.empty() ? "" : "|") + choice;
+            }
+            return "expected one of " + joined;
+        }
+        set(static_cast<int>(it - choices.begin()));
+        return std::string();
+    };
+    cvar.onChange = std::move(onChange);
+    cvar.defaultValue = cvar.get();
+    console.cvars[toLower(name)] = std::move(cvar);
+}
+
+bool setCvar(ConsoleState& console, const std::string& name, const std::string& text, std::string& error) {
+    auto it = console.cvars.find(toLower(name));
+    if (it == console.cvars.end()) {
+        error = "Unknown cvar: " + name;
+        return false;
+    }
+    std::string previous = it->second.get();
+    std::string problem = it->second.assign(text);
+    if (!problem.empty()) {
+        error = it->first + ": " + problem;
+        return false;
+    }
+    if (it->second.get() != previous && it->second.onChange) {
+        // Copy so the callback may re-register cvars.
+        CvarChangedFn onChange = it->second.onChange;
+        onChange(console);
+    }
+    return true;
+}
+
+bool loadCvarFile(ConsoleState& console, const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        addLogLine(console, "Could not open " + path);
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    int applied = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::vector<std::string> tokens = tokenize(line.substr(0, line.find('#')));
+        if (!tokens.empty() && toLower(tokens[0]) == "set") {
+            tokens.erase(tokens.begin());
+        }
+        if (tokens.empty()) {
+            continue;
+        }
+        std::string error = "expected <name> <value>";
+        if (tokens.size() == 2 && setCvar(console, tokens[0], tokens[1], error)) {
+            ++applied;
+            continue;
+        }
+        std::string message = path + ":" + std::to_string(lineNumber) + ": " + error;
+        addLogLine(console, message);
+        std::cerr << message << "\n";
+    }
+    addLogLine(console, path + ": " + std::to_string(applied) + " setting(s) applied");
+    return true;
+}
+
+void consolePrint(ConsoleState& console, const std::string& line) {
+    addLogLine(console, line);
+}
+
+std::vector<std::string> executeConsoleCommand(ConsoleState& console, const std::string& line, Config& cfg, Player& player, bool& running) {
+    size_t before = console.logged;
+    handleCommand(console, line, cfg, player, running);
+    size_t added = std::min(console.logged - before, console.log.size());
+    return std::vector<std::string>(console.log.end() - added, console.log.end());
+}
+
 void setConsoleOpen(ConsoleState& console, bool open) {
     if (console.open == open) {
         return;
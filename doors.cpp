@@ -49,6 +49,10 @@ const Door* findDoor(const std::vector<Door>& doors, int x, int y) {
 }
 
 bool computeDoorHit(const Door& door, const Player& player, double rayDirX, double rayDirY, double& dist, bool& side) {
+    return computeDoorHit(door, player.x, player.y, rayDirX, rayDirY, dist, side);
+}
+
+bool computeDoorHit(const Door& door, double originX, double originY, double rayDirX, double rayDirY, double& dist, bool& side) {
     const double minDist = 0.0001;
     if (door.vertical) {
         // Corridor runs left/right (walls above/below). Door plane stays at x=const and slides into a wall along Y.
@@ -56,11 +60,11 @@ bool computeDoorHit(const Door& door, const Player& player, double rayDirX, doub
             return false;
         }
         double planeX = door.x + 0.5;
-        double t = (planeX - player.x) / rayDirX;
+        double t = (planeX - originX) / rayDirX;
         if (t <= minDist) {
             return false;
         }
-        double yHit = player.y + t * rayDirY;
+        double yHit = originY + t * rayDirY;
         double minY = door.y + door.openAmount; // slides down as it opens (into bottom wall)
         double maxY = door.y + 1.0;
         if (yHit >= minY && yHit <= maxY) {
@@ -74,11 +78,11 @@ bool computeDoorHit(const Door& door, const Player& player, double rayDirX, doub
             return false;
         }
         double planeY = door.y + 0.5;
-        double t = (planeY - player.y) / rayDirY;
+        double t = (planeY - originY) / rayDirY;
         if (t <= minDist) {
             return false;
         }
-        double xHit = player.x + t * rayDirX;
+        double xHit = originX + t * rayDirX;
         double minX = door.x + door.openAmount; // slides right as it opens (into right wall)
         double maxX = door.x + 1.0;
         if (xHit >= minX && xHit <= maxX) {
@@ -90,6 +94,10 @@ bool computeDoorHit(const Door& door, const Player& player, double rayDirX, doub
     return false;
 }
 
+bool doorPassable(const Door& door) {
+    return door.openAmount > 0.8;
+}
+
 bool playerInDoorway(const Door& door, const Player& player) {
     return player.x >= door.x && player.x <= door.x + 1.0 &&
            player.y >= door.y && player.y <= door.y + 1.0;
@@ -107,28 +115,46 @@ Door* doorInFront(Player& player, const Map& map, std::vector<Door>& doors) {
     return nullptr;
 }
 
-void updateDoors(std::vector<Door>& doors, const Player& player, double dt) {
+namespace {
+void stepDoor(Door& door, bool blocked, double dt) {
     const double openSpeed = 1.2; // fraction per second
     const double autoCloseDelay = 5.0;
 
-    for (auto& door : doors) {
-        bool playerBlocking = playerInDoorway(door, player);
-        if (playerBlocking) {
-            door.targetOpen = true;
-            door.timeFullyOpen = 0.0;
+    if (blocked) {
+        door.targetOpen = true;
+        door.timeFullyOpen = 0.0;
+    }
+
+    if (door.targetOpen) {
+        door.openAmount = std::min(1.0, door.openAmount + openSpeed * dt);
+        if (door.openAmount >= 1.0) {
+            door.timeFullyOpen += dt;
+            if (!blocked && door.timeFullyOpen >= autoCloseDelay) {
+                door.targetOpen = false;
+            }
         }
+    } else {
+        door.timeFullyOpen = 0.0;
+        door.openAmount = std::max(0.0, door.openAmount - openSpeed * dt);
+    }
+}
+} // namespace
 
-        if (door.targetOpen) {
-            door.openAmount = std::min(1.0, door.openAmount + openSpeed * dt);
-            if (door.openAmount >= 1.0) {
-                door.timeFullyOpen += dt;
-                if (!playerBlocking && door.timeFullyOpen >= autoCloseDelay) {
-                    door.targetOpen = false;
-                }
+void updateDoors(std::vector<Door>& doors, const Player& player, double dt) {
+    for (auto& door : doors) {
+        stepDoor(door, playerInDoorway(door, player), dt);
+    }
+}
+
+void updateDoors(std::vector<Door>& doors, const std::vector<Player>& players, double dt) {
+    for (auto& door : doors) {
+        bool blocked = false;
+        for (const auto& player : players) {
+            if (playerInDoorway(door, player)) {
+                blocked = true;
+                break;
             }
-        } else {
-            door.timeFullyOpen = 0.0;
-            door.openAmount = std::max(0.0, door.openAmount - openSpeed * dt);
         }
+        stepDoor(door, blocked, dt);
     }
 }
@@ -0,0 +1,159 @@
+#include "entities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "collision.h"
+#include "doors.h"
+#include "thread_pool.h"
+
+namespace {
+const double WANDER_SPEED = 1.2; // units per second
+const size_t UPDATE_CHUNK = 1024;
+
+Uint32 nextRandom(Uint32& state) {
+    // xorshift32; state must stay non-zero.
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+double randomUnit(Uint32& state) {
+    return (nextRandom(state) >> 8) * (1.0 / 16777216.0);
+}
+
+void pickHeading(EntityStore& store, size_t i) {
+    Uint32& rng = store.rngState[i];
+    double angle = randomUnit(rng) * 6.283185307179586;
+    store.velX[i] = std::cos(angle) * WANDER_SPEED;
+    store.velY[i] = std::sin(angle) * WANDER_SPEED;
+    store.animTime[i] = static_cast<float>(1.0 + randomUnit(rng) * 3.0);
+}
+
+void updateRange(EntityStore& store, const Map& map, const std::vector<Door>& doors, const CollisionGrid* grid, double dt, size_t begin, size_t end) {
+    double* xs = store.x.data();
+    double* ys = store.y.data();
+    double* vxs = store.velX.data();
+    double* vys = store.velY.data();
+    float* timers = store.animTime.data();
+    const float* radii = store.radius.data();
+    const Uint32* flags = store.flags.data();
+    for (size_t i = begin; i < end; ++i) {
+        if (!(flags[i] & ENTITY_WANDER)) {
+            continue;
+        }
+        timers[i] -= static_cast<float>(dt);
+        if (timers[i] <= 0.0f) {
+            pickHeading(store, i);
+        }
+        // Swept like the player; bounce off whatever blocks an axis.
+        CircleMove move = sweepCircle(map, doors, xs[i], ys[i], radii[i], vxs[i] * dt, vys[i] * dt);
+        xs[i] = move.x;
+        ys[i] = move.y;
+        if (move.blockedX) {
+            vxs[i] = -vxs[i];
+        }
+        if (move.blockedY) {
+            vys[i] = -vys[i];
+        }
+        if (!grid || radii[i] <= 0.0f) {
+            continue;
+        }
+        // Two wanderers each take half of their overlap; sprites and other fixed colliders take none of it.
+        double pushX = 0.0;
+        double pushY = 0.0;
+        grid->forEachOverlap(xs[i], ys[i], radii[i], static_cast<int>(i), [&](int other, double dx, double dy, double distanceSquared, double minDistance) {
+            double distance = std::sqrt(distanceSquared);
+            if (distance < 1e-9) {
+                return; // the other one resolves it from its side of the tie
+            }
+            double share = flags[other] & ENTITY_WANDER ? 0.5 : 1.0;
+            double nx = dx / distance;
+            double ny = dy / distance;
+            pushX += nx * (minDistance - distance) * share;
+            pushY += ny * (minDistance - distance) * share;
+            // Turn away from the contact rather than pressing into it every tick.
+            double into = vxs[i] * nx + vys[i] * ny;
+            if (into < 0.0) {
+                vxs[i] -= 2.0 * into * nx;
+                vys[i] -= 2.0 * into * ny;
+            }
+        });
+        if (pushX != 0.0 || pushY != 0.0) {
+            move = sweepCircle(map, doors, xs[i], ys[i], radii[i], pushX, pushY);
+            xs[i] = move.x;
+            ys[i] = move.y;
+        }
+    }
+}
+} // namespace
+
+size_t addEntity(EntityStore& store, double x, double y, int textureId, Uint32 flags, float radius) {
+    size_t index = store.size();
+    store.x.push_back(x);
+    store.y.push_back(y);
+    store.velX.push_back(0.0);
+    store.velY.push_back(0.0);
+    store.textureId.push_back(textureId);
+    store.animTime.push_back(0.0f);
+    store.rngState.push_back(static_cast<Uint32>(index * 2654435761u) | 1u);
+    store.flags.push_back(flags);
+    store.radius.push_back(radius);
+    return index;
+}
+
+EntityStore entitiesFromSprites(const std::vector<Sprite>& sprites) {
+    EntityStore store;
+    for (const auto& s : sprites) {
+        addEntity(store, s.x, s.y, s.textureId, ENTITY_VISIBLE);
+    }
+    return store;
+}
+
+void spawnWanderers(EntityStore& store, const Map& map, int count, unsigned seed) {
+    std::vector<std::pair<int, int>> floor;
+    for (int y = 1; y < map.height - 1; ++y) {
+        for (int x = 1; x < map.width - 1; ++x) {
+            if (map.at(x, y) == 0) {
+                floor.push_back({x, y});
+            }
+        }
+    }
+    if (floor.empty()) {
+        return;
+    }
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> cellDist(0, floor.size() - 1);
+    std::uniform_real_distribution<double> jitter(0.2, 0.8);
+    std::uniform_int_distribution<int> texDist(0, 2);
+    for (int i = 0; i < count; ++i) {
+        const auto& cell = floor[cellDist(rng)];
+        size_t index = addEntity(store, cell.first + jitter(rng), cell.second + jitter(rng), texDist(rng), ENTITY_VISIBLE | ENTITY_WANDER, ACTOR_RADIUS);
+        store.rngState[index] = static_cast<Uint32>(rng()) | 1u;
+        pickHeading(store, index);
+    }
+}
+
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, double dt) {
+    updateEntities(store, map, doors, dt, workerPool());
+}
+
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, double dt, ThreadPool& pool) {
+    // Entities only read the map and doors and write their own slots, so chunks need no locking.
+    pool.parallelFor(store.size(), UPDATE_CHUNK, [&](size_t begin, size_t end) {
+        updateRange(store, map, doors, nullptr, dt, begin, end);
+    });
+}
+
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, const CollisionGrid& grid, double dt) {
+    updateEntities(store, map, doors, grid, dt, workerPool());
+}
+
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, const CollisionGrid& grid, double dt, ThreadPool& pool) {
+    // The grid holds its own copy of the positions, so reading it while chunks write the store is safe.
+    pool.parallelFor(store.size(), UPDATE_CHUNK, [&](size_t begin, size_t end) {
+        updateRange(store, map, doors, &grid, dt, begin, end);
+    });
+}
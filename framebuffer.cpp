@@ -0,0 +1,97 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RAYCASTER_TRANSPOSE_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RAYCASTER_TRANSPOSE_NEON 1
+#endif
+
+namespace {
+// 32x32 pixels = 4 KiB per side, so a source and destination tile stay in L1 together.
+const int TILE = 32;
+
+// Rows [y, y + 4) of columns [x, x + 4).
+inline void transpose4x4(const Uint32* src, int columnStride, Uint32* dst, int dstPitch) {
+#if defined(RAYCASTER_TRANSPOSE_SSE2)
+    __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + columnStride));
+    __m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * columnStride));
+    __m128i c3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * columnStride));
+    __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+    __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+    __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+    __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dstPitch), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * dstPitch), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * dstPitch), _mm_unpackhi_epi64(t2, t3));
+#elif defined(RAYCASTER_TRANSPOSE_NEON)
+    uint32x4x2_t t01 = vtrnq_u32(vld1q_u32(src), vld1q_u32(src + columnStride));
+    uint32x4x2_t t23 = vtrnq_u32(vld1q_u32(src + 2 * columnStride), vld1q_u32(src + 3 * columnStride));
+    vst1q_u32(dst, vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+    vst1q_u32(dst + dstPitch, vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+    vst1q_u32(dst + 2 * dstPitch, vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+    vst1q_u32(dst + 3 * dstPitch, vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+#else
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            dst[y * dstPitch + x] = src[x * columnStride + y];
+        }
+    }
+#endif
+}
+
+void transposeTile(const Uint32* src, int columnStride, Uint32* dst, int dstPitch, int x0, int x1, int y0, int y1) {
+    int x4 = x0 + ((x1 - x0) & ~3);
+    int y4 = y0 + ((y1 - y0) & ~3);
+    for (int y = y0; y < y4; y += 4) {
+        for (int x = x0; x < x4; x += 4) {
+            transpose4x4(src + x * columnStride + y, columnStride, dst + y * dstPitch + x, dstPitch);
+        }
+    }
+    // Ragged right and bottom edges.
+    for (int y = y0; y < y1; ++y) {
+        for (int x = (y < y4 ? x4 : x0); x < x1; ++x) {
+            dst[y * dstPitch + x] = src[x * columnStride + y];
+        }
+    }
+}
+} // namespace
+
+void transposeColumnsToRows(const Uint32* src, int width, int height, int columnStride, Uint32* dst, int dstPitch, ThreadPool& pool) {
+    const size_t bands = static_cast<size_t>((height + TILE - 1) / TILE);
+    pool.parallelFor(bands, 1, [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band) {
+            int y0 = static_cast<int>(band) * TILE;
+            int y1 = std::min(y0 + TILE, height);
+            for (int x0 = 0; x0 < width; x0 += TILE) {
+                transposeTile(src, columnStride, dst, dstPitch, x0, std::min(x0 + TILE, width), y0, y1);
+            }
+        }
+    });
+}
+
+const char* transposeIsa() {
+#if defined(RAYCASTER_TRANSPOSE_SSE2)
+    return "sse2";
+#elif defined(RAYCASTER_TRANSPOSE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void ColumnMajorFrame::resize(int w, int h) {
+    if (w == width && h == height) {
+        return;
+    }
+    width = w;
+    height = h;
+    pixels.assign(static_cast<size_t>(w) * h, 0);
+}
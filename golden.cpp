@@ -0,0 +1,378 @@
+#include "golden.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#include "assets.h"
+#include "camera_path.h"
+#include "doors.h"
+#include "entities.h"
+#include "framebuffer.h"
+#include "image_writer.h"
+#include "lighting.h"
+#include "map.h"
+#include "pvs.h"
+#include "renderer.h"
+#include "textures.h"
+#include "thread_pool.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const int GOLDEN_WIDTH = 320;
+const int GOLDEN_HEIGHT = 200;
+const unsigned GOLDEN_SEEDS[] = {1u, 38u};
+const int POSES_PER_SCENE = 2;
+
+struct DoorState {
+    const char* name;
+    double openAmount;
+};
+const DoorState DOOR_STATES[] = {{"shut", 0.0}, {"ajar", 0.5}, {"open", 1.0}};
+
+// One way of producing a frame. The reference path writes the golden images; every path must then
+// match them to within its own tolerance.
+struct RenderPath {
+    const char* name;
+    bool threaded;
+    bool wallSpans;
+    bool culled;         // sprites culled against the pose's PVS visible set
+    bool columnMajor;    // drawn column-major, then transposed
+    int tolerance;       // per-channel delta a pixel may have and still count as equal
+    double maxDiffering; // fraction of pixels allowed beyond the tolerance
+};
+const RenderPath RENDER_PATHS[] = {
+    {"reference", false, false, false, false, 0, 0.0},
+    {"threaded", true, false, false, false, 0, 0.0},
+    {"culled", true, false, true, false, 0, 0.0},
+    {"columns", true, false, false, true, 0, 0.0},
+    {"spans", true, true, true, false, 0, 0.005},
+};
+
+struct GoldenOptions {
+    bool update = false;
+    std::string dir = "resources/golden";
+    int tolerance = -1;       // overrides every path's tolerance when set
+    double maxDiffering = -1; // likewise, as a fraction
+    double budget = 50.0;     // percent a stage may run over its baseline
+    int repeat = 10;
+    bool timing = true;
+};
+
+struct GoldenScene {
+    std::string name;
+    Map map;
+    std::vector<Door> doors;
+    EntityStore entities;
+    Lightmap lightmap;
+    PvsData pvs;
+    std::vector<Player> poses;
+};
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool parseOptions(const std::vector<std::string>& args, GoldenOptions& opts) {
+    if (args.empty() || (args[0] != "check" && args[0] != "update")) {
+        std::cerr << "Usage: raycaster --golden check|update [--dir d] [--tolerance n] [--max-differing pct] [--budget pct] [--repeat n] [--no-timing]\n";
+        return false;
+    }
+    opts.update = args[0] == "update";
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--no-timing") {
+            opts.timing = false;
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        const std::string& value = args[++i];
+        if (arg == "--dir") {
+            opts.dir = value;
+        } else if (arg == "--tolerance") {
+            opts.tolerance = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--max-differing") {
+            opts.maxDiffering = std::max(0.0, std::atof(value.c_str())) / 100.0;
+        } else if (arg == "--budget") {
+            opts.budget = std::max(0.0, std::atof(value.c_str()));
+        } else if (arg == "--repeat") {
+            opts.repeat = std::max(1, std::atoi(value.c_str()));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Best of `repeat` runs, so one descheduled run does not read as a regression.
+template <typename Fn>
+double bestOf(int repeat, Fn&& fn) {
+    double best = 0.0;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = Clock::now();
+        fn();
+        double ms = elapsedMs(start);
+        best = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+// A procedural texture for every id the manifest lists. Goldens never see the PNGs, so they are the same on a
+// checkout with or without the asset files, and on any SDL_image version.
+TextureManager goldenTextures() {
+    TextureManager tm;
+    for (const AssetEntry& entry : readAssetManifest(TEXTURE_MANIFEST_PATH)) {
+        std::vector<SDL_Surface*>& surfaces = entry.sprite ? tm.spriteTextures : tm.textures;
+        if (static_cast<int>(surfaces.size()) <= entry.id) {
+            surfaces.resize(entry.id + 1, nullptr);
+        }
+    }
+    fillMissingTextures(tm);
+    return tm;
+}
+
+// Fixed seeds and door states; poses are taken from the room tour so they always stand in open floor.
+std::vector<GoldenScene> buildScenes(int repeat, std::map<std::string, double>& stageMs) {
+    std::vector<GoldenScene> scenes;
+    for (unsigned seed : GOLDEN_SEEDS) {
+        Map map = createRandomMap(seed);
+        std::vector<Door> shut = extractDoors(map);
+        CameraPath tour = generateRoomTour(map, shut);
+        EntityStore entities = entitiesFromSprites(createSprites(map, seed));
+        for (const DoorState& state : DOOR_STATES) {
+            GoldenScene scene;
+            scene.name = "seed" + std::to_string(seed) + "_" + state.name;
+            scene.map = map;
+            scene.doors = shut;
+            for (Door& door : scene.doors) {
+                door.openAmount = state.openAmount;
+                door.targetOpen = state.openAmount > 0.0;
+            }
+            scene.entities = entities;
+            stageMs["lightmap_bake"] += bestOf(repeat, [&] {
+                scene.lightmap = bakeLightmap(scene.map, scene.doors, collectLights(scene.entities));
+            });
+            stageMs["pvs_build"] += bestOf(repeat, [&] { scene.pvs = buildPvs(scene.map, scene.doors); });
+            for (int i = 0; i < POSES_PER_SCENE; ++i) {
+                scene.poses.push_back(tour.frames[tour.frames.size() * (i + 1) / (POSES_PER_SCENE + 1)]);
+            }
+            scenes.push_back(std::move(scene));
+        }
+    }
+    return scenes;
+}
+
+struct FrameDiff {
+    size_t differing = 0;
+    int maxDelta = 0;
+};
+
+FrameDiff compareFrames(const std::vector<Uint32>& actual, const std::vector<Uint32>& expected, int tolerance) {
+    FrameDiff diff;
+    for (size_t i = 0; i < actual.size(); ++i) {
+        if (actual[i] == expected[i]) {
+            continue;
+        }
+        int delta = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            delta = std::max(delta, std::abs(static_cast<int>((actual[i] >> shift) & 0xff) - static_cast<int>((expected[i] >> shift) & 0xff)));
+        }
+        diff.maxDelta = std::max(diff.maxDelta, delta);
+        if (delta > tolerance) {
+            ++diff.differing;
+        }
+    }
+    return diff;
+}
+
+// "stage milliseconds" per line; # starts a comment.
+std::map<std::string, double> loadTimings(const std::string& path) {
+    std::map<std::string, double> timings;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string stage;
+        double ms = 0.0;
+        if (fields >> stage >> ms && stage[0] != '#') {
+            timings[stage] = ms;
+        }
+    }
+    return timings;
+}
+
+bool saveTimings(const std::string& path, const std::map<std::string, double>& timings) {
+    std::ofstream out(path);
+    out << "# stage baseline_ms (best of repeated runs on the machine that last ran --golden update)\n";
+    for (const auto& [stage, ms] : timings) {
+        out << stage << " " << std::fixed << std::setprecision(4) << ms << "\n";
+    }
+    return static_cast<bool>(out);
+}
+} // namespace
+
+int runGolden(const std::vector<std::string>& args) {
+    GoldenOptions opts;
+    if (!parseOptions(args, opts)) {
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(opts.dir, ec);
+    if (ec) {
+        std::cerr << "Failed to create " << opts.dir << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    TextureManager tm = goldenTextures();
+    Config cfg{};
+    cfg.screenWidth = GOLDEN_WIDTH;
+    cfg.screenHeight = GOLDEN_HEIGHT;
+    std::map<std::string, double> stageMs;
+    std::vector<GoldenScene> scenes = buildScenes(opts.timing ? opts.repeat : 1, stageMs);
+
+    ThreadPool serialPool(0);
+    RenderContext rc;
+    VisibleRegions visible;
+    const size_t pixelCount = static_cast<size_t>(GOLDEN_WIDTH) * GOLDEN_HEIGHT;
+    std::vector<Uint32> pixels(pixelCount);
+    std::vector<Uint32> golden;
+    ColumnMajorFrame columnFrame;
+    columnFrame.resize(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+    auto render = [&](const RenderPath& path, const GoldenScene& scene, const Player& pose) {
+        Config pathCfg = cfg;
+        pathCfg.wallSpans = path.wallSpans;
+        rc.pool = path.threaded ? &workerPool() : &serialPool;
+        const VisibleRegions* culling = nullptr;
+        if (path.culled) {
+            computeVisibleRegions(scene.pvs, scene.doors, pose.x, pose.y, visible);
+            culling = &visible;
+        }
+        if (path.columnMajor) {
+            FrameTarget columns{columnFrame.pixels.data(), GOLDEN_WIDTH, GOLDEN_HEIGHT, 1, GOLDEN_HEIGHT};
+            renderWorld(rc, scene.map, scene.doors, scene.entities, pose, pathCfg, tm, columns, culling, &scene.lightmap);
+            transposeColumnsToRows(columns.pixels, GOLDEN_WIDTH, GOLDEN_HEIGHT, columns.step, pixels.data(), GOLDEN_WIDTH, *rc.pool);
+            return;
+        }
+        FrameTarget target{pixels.data(), GOLDEN_WIDTH, GOLDEN_HEIGHT, GOLDEN_WIDTH};
+        renderWorld(rc, scene.map, scene.doors, scene.entities, pose, pathCfg, tm, target, culling, &scene.lightmap);
+    };
+
+    std::cout << (opts.update ? "golden update: " : "golden check: ") << scenes.size() * POSES_PER_SCENE << " frames at "
+              << GOLDEN_WIDTH << "x" << GOLDEN_HEIGHT << " in " << opts.dir << ", " << workerPool().concurrency()
+              << " thread(s)\n";
+    bool passed = true;
+    size_t compared[std::size(RENDER_PATHS)] = {};
+    size_t failed[std::size(RENDER_PATHS)] = {};
+    int maxDelta[std::size(RENDER_PATHS)] = {};
+    for (const GoldenScene& scene : scenes) {
+        for (size_t p = 0; p < scene.poses.size(); ++p) {
+            const std::string frameName = scene.name + "_" + std::to_string(p);
+            const std::string goldenPath = (std::filesystem::path(opts.dir) / (frameName + ".ppm")).string();
+            if (opts.update) {
+                render(RENDER_PATHS[0], scene, scene.poses[p]);
+                if (!writeImage(goldenPath, pixels.data(), GOLDEN_WIDTH, GOLDEN_HEIGHT, GOLDEN_WIDTH, ImageFormat::PPM)) {
+                    passed = false;
+                    continue;
+                }
+                golden = pixels;
+            } else {
+                int width = 0;
+                int height = 0;
+                if (!readPpm(goldenPath, golden, width, height)) {
+                    std::cerr << "Missing golden image " << goldenPath << " (run --golden update on a known-good build)\n";
+                    passed = false;
+                    continue;
+                }
+                if (width != GOLDEN_WIDTH || height != GOLDEN_HEIGHT) {
+                    std::cerr << goldenPath << " is " << width << "x" << height << ", expected " << GOLDEN_WIDTH << "x"
+                              << GOLDEN_HEIGHT << "\n";
+                    passed = false;
+                    continue;
+                }
+            }
+            for (size_t r = 0; r < std::size(RENDER_PATHS); ++r) {
+                const RenderPath& path = RENDER_PATHS[r];
+                render(path, scene, scene.poses[p]);
+                int tolerance = opts.tolerance >= 0 ? opts.tolerance : path.tolerance;
+                double allowed = opts.maxDiffering >= 0.0 ? opts.maxDiffering : path.maxDiffering;
+                FrameDiff diff = compareFrames(pixels, golden, tolerance);
+                ++compared[r];
+                maxDelta[r] = std::max(maxDelta[r], diff.maxDelta);
+                double fraction = static_cast<double>(diff.differing) / pixelCount;
+                if (fraction <= allowed) {
+                    continue;
+                }
+                ++failed[r];
+                passed = false;
+                // Keep the offending frame next to the goldens for inspection.
+                std::filesystem::create_directories(std::filesystem::path(opts.dir) / "failed", ec);
+                std::string actualPath = (std::filesystem::path(opts.dir) / "failed" / (frameName + "_" + path.name + ".ppm")).string();
+                writeImage(actualPath, pixels.data(), GOLDEN_WIDTH, GOLDEN_HEIGHT, GOLDEN_WIDTH, ImageFormat::PPM);
+                std::cerr << std::fixed << std::setprecision(3) << frameName << " [" << path.name << "]: "
+                          << 100.0 * fraction << "% pixels differ (allowed " << 100.0 * allowed << "%), max channel delta "
+                          << diff.maxDelta << "; wrote " << actualPath << "\n";
+            }
+        }
+    }
+    for (size_t r = 0; r < std::size(RENDER_PATHS); ++r) {
+        std::cout << "  " << std::left << std::setw(10) << RENDER_PATHS[r].name << std::right << " "
+                  << compared[r] - failed[r] << "/" << compared[r] << " frames match, max channel delta " << maxDelta[r]
+                  << "\n";
+    }
+
+    if (opts.timing) {
+        // Per-frame render time of each path, best pass over the whole frame set.
+        for (const RenderPath& path : RENDER_PATHS) {
+            double ms = bestOf(opts.repeat, [&] {
+                for (const GoldenScene& scene : scenes) {
+                    for (const Player& pose : scene.poses) {
+                        render(path, scene, pose);
+                    }
+                }
+            });
+            stageMs[std::string("render_") + path.name] = ms / (scenes.size() * POSES_PER_SCENE);
+        }
+        const std::string timingsPath = (std::filesystem::path(opts.dir) / "timings.txt").string();
+        std::map<std::string, double> baseline = loadTimings(timingsPath);
+        for (const auto& [stage, ms] : stageMs) {
+            std::cout << "  " << std::left << std::setw(16) << stage << std::right << std::fixed << std::setprecision(3)
+                      << " " << ms << " ms";
+            auto it = baseline.find(stage);
+            if (!opts.update && it != baseline.end() && it->second > 0.0) {
+                double over = 100.0 * (ms / it->second - 1.0);
+                bool withinBudget = over <= opts.budget;
+                passed = passed && withinBudget;
+                std::cout << " (baseline " << it->second << " ms, " << std::showpos << std::setprecision(1) << over
+                          << std::noshowpos << "%)" << (withinBudget ? "" : " OVER BUDGET");
+            } else if (!opts.update) {
+                std::cout << " (no baseline)";
+            }
+            std::cout << "\n";
+        }
+        if (opts.update && !saveTimings(timingsPath, stageMs)) {
+            std::cerr << "Failed to write " << timingsPath << "\n";
+            passed = false;
+        }
+    }
+
+    freeTextures(tm);
+    if (!passed) {
+        std::cerr << "golden " << (opts.update ? "update" : "check") << " failed\n";
+        return 1;
+    }
+    std::cout << "golden " << (opts.update ? "images and timings updated" : "check passed") << "\n";
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "image_writer.h"
+
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+bool parseImageFormat(const std::string& name, ImageFormat& format) {
+    if (name == "ppm") {
+        format = ImageFormat::PPM;
+        return true;
+    }
+    if (name == "png") {
+        format = ImageFormat::PNG;
+        return true;
+    }
+    return false;
+}
+
+const char* imageExtension(ImageFormat format) {
+    return format == ImageFormat::PNG ? ".png" : ".ppm";
+}
+
+bool writeImage(const std::string& path, const Uint32* pixels, int width, int height, int pitch, ImageFormat format) {
+    if (format == ImageFormat::PNG) {
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint32*>(pixels), width, height, 32,
+                                                               pitch * static_cast<int>(sizeof(Uint32)), SDL_PIXELFORMAT_ARGB8888);
+        if (!surf) {
+            std::cerr << "Failed to wrap frame for " << path << ": " << SDL_GetError() << "\n";
+            return false;
+        }
+        bool ok = IMG_SavePNG(surf, path.c_str()) == 0;
+        SDL_FreeSurface(surf);
+        if (!ok) {
+            std::cerr << "Failed to write " << path << ": " << IMG_GetError() << "\n";
+        }
+        return ok;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing\n";
+        return false;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<Uint8> row(static_cast<size_t>(width) * 3);
+    bool ok = true;
+    for (int y = 0; y < height && ok; ++y) {
+        const Uint32* src = pixels + static_cast<size_t>(y) * pitch;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3] = static_cast<Uint8>(src[x] >> 16);
+            row[x * 3 + 1] = static_cast<Uint8>(src[x] >> 8);
+            row[x * 3 + 2] = static_cast<Uint8>(src[x]);
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write " << path << "\n";
+    }
+    return ok;
+}
+
+bool readPpm(const std::string& path, std::vector<Uint32>& pixels, int& width, int& height) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    int maxValue = 0;
+    if (std::fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) != 3 || width <= 0 || height <= 0 ||
+        maxValue != 255 || std::fgetc(file) == EOF) {
+        std::fclose(file);
+        std::cerr << "Malformed PPM header: " << path << "\n";
+        return false;
+    }
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    std::vector<Uint8> row(rowBytes);
+    pixels.resize(static_cast<size_t>(width) * height);
+    bool ok = true;
+    for (int y = 0; y < height && ok; ++y) {
+        ok = std::fread(row.data(), 1, rowBytes, file) == rowBytes;
+        Uint32* dst = pixels.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width && ok; ++x) {
+            dst[x] = 0xff000000u | (static_cast<Uint32>(row[x * 3]) << 16) | (static_cast<Uint32>(row[x * 3 + 1]) << 8) | row[x * 3 + 2];
+        }
+    }
+    std::fclose(file);
+    if (!ok) {
+        std::cerr << "Truncated PPM: " << path << "\n";
+    }
+    return ok;
+}
+
+ImageWriteQueue::ImageWriteQueue(int width, int height, size_t bufferCount, unsigned writerThreads, ImageFormat format)
+    : format_(format), buffers_(bufferCount < 1 ? 1 : bufferCount) {
+    for (auto& buffer : buffers_) {
+        buffer.pixels.assign(static_cast<size_t>(width) * height, 0);
+        buffer.width = width;
+        buffer.height = height;
+        free_.push_back(&buffer);
+    }
+    for (unsigned i = 0; i < (writerThreads < 1 ? 1 : writerThreads); ++i) {
+        writers_.emplace_back([this] { writerLoop(); });
+    }
+}
+
+ImageWriteQueue::~ImageWriteQueue() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workReady_.notify_all();
+    for (auto& t : writers_) {
+        t.join();
+    }
+}
+
+ImageBuffer* ImageWriteQueue::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        freeReady_.wait(lock, [this] { return !free_.empty(); });
+        acquireWaitMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    ImageBuffer* buffer = free_.back();
+    free_.pop_back();
+    return buffer;
+}
+
+ImageBuffer* ImageWriteQueue::tryAcquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+        return nullptr;
+    }
+    ImageBuffer* buffer = free_.back();
+    free_.pop_back();
+    return buffer;
+}
+
+void ImageWriteQueue::submit(ImageBuffer* buffer, std::string path) {
+    submit(buffer, std::move(path), format_);
+}
+
+void ImageWriteQueue::submit(ImageBuffer* buffer, std::string path, ImageFormat format) {
+    buffer->path = std::move(path);
+    buffer->format = format;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(buffer);
+        ++inFlight_;
+        maxQueued_ = std::max(maxQueued_, pending_.size());
+    }
+    workReady_.notify_one();
+}
+
+void ImageWriteQueue::finish() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return inFlight_ == 0; });
+}
+
+void ImageWriteQueue::writerLoop() {
+    for (;;) {
+        ImageBuffer* buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workReady_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            buffer = pending_.front();
+            pending_.pop_front();
+        }
+        bool ok = writeImage(buffer->path, buffer->pixels.data(), buffer->width, buffer->height, buffer->width, buffer->format);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++(ok ? written_ : failed_);
+            free_.push_back(buffer);
+            --inFlight_;
+        }
+        freeReady_.notify_one();
+        drained_.notify_all();
+    }
+}
+
+size_t ImageWriteQueue::written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+size_t ImageWriteQueue::failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+double ImageWriteQueue::acquireWaitMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return acquireWaitMs_;
+}
+
+size_t ImageWriteQueue::maxQueued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxQueued_;
+}
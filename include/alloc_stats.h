@@ -0,0 +1,27 @@
+#pragma once
+
+// Counters fed by the replaced global operator new (alloc_stats.cpp). Only threads inside an
+// AllocationCountScope add to them: the thread that opened it, and pool workers while they run its
+// parallelFor chunks. Loader, writer and I/O threads running at the same time are not counted.
+struct AllocationCounters {
+    unsigned long long count = 0;
+    unsigned long long bytes = 0;
+};
+
+AllocationCounters allocationCounters();
+// Allocations made since `since` was sampled.
+AllocationCounters allocationsSince(const AllocationCounters& since);
+
+// Counts (or, with false, stops counting) this thread's allocations until destroyed; scopes nest.
+class AllocationCountScope {
+public:
+    explicit AllocationCountScope(bool counting = true);
+    ~AllocationCountScope();
+    AllocationCountScope(const AllocationCountScope&) = delete;
+    AllocationCountScope& operator=(const AllocationCountScope&) = delete;
+
+private:
+    bool previous_;
+};
+// Whether this thread is inside a counting scope.
+bool countingAllocations();
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "game_types.h"
+
+struct AssetEntry {
+    bool sprite = false; // false: wall/door texture indexed by tile id
+    int id = 0;          // tile id or Sprite::textureId
+    std::string path;
+};
+
+// Reads "wall <id> <file>" / "sprite <id> <file>" lines; falls back to the built-in set.
+std::vector<AssetEntry> readAssetManifest(const std::string& manifestPath);
+// Fingerprint of the manifest entries and their source files' sizes and timestamps.
+Uint64 hashAssetSources(const std::vector<AssetEntry>& entries);
+
+// Maps a texture cache archive and points the manager's surfaces and mip chains into it.
+bool mapTextureArchive(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, TextureManager& tm);
+// Where one mip level's pixels sit in a cache archive.
+struct TextureArchiveLevel {
+    int width = 0;
+    int height = 0;
+    Uint64 offset = 0;
+};
+// Reads the level table of a cache archive without mapping its pixels: one chain per manifest entry, in
+// manifest order, empty for sources that failed to load.
+bool readTextureArchiveIndex(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, std::vector<std::vector<TextureArchiveLevel>>& chains);
+// Reads one chain's levels from an open archive into newly allocated ARGB8888 surfaces; empty on a read error.
+std::vector<SDL_Surface*> readTextureArchiveChain(std::istream& in, const std::vector<TextureArchiveLevel>& levels);
+// Writes the already converted mip chains of every manifest entry into a cache archive.
+bool writeTextureArchive(const std::string& cachePath, Uint64 sourceHash, const std::vector<AssetEntry>& entries, const TextureManager& tm);
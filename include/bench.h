@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Runs a headless benchmark; args[0] is the benchmark name. Returns a process exit code.
+int runBenchmark(const std::vector<std::string>& args);
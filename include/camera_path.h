@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "game_types.h"
+
+// One camera pose per rendered frame, so playback is independent of frame rate.
+struct CameraPath {
+    std::vector<Player> frames;
+};
+
+// Pose facing `angle` radians with the same handedness as the spawn camera.
+Player cameraFromAngle(double x, double y, double angle);
+// Text format: one "x y angle" line per frame, '#' starts a comment.
+bool loadCameraPath(const std::string& file, CameraPath& path);
+bool saveCameraPath(const std::string& file, const CameraPath& path);
+// Deterministic flythrough visiting room centres in generation order along door-aware paths.
+CameraPath generateRoomTour(const Map& map, const std::vector<Door>& doors, int maxRooms = 6, double cellsPerFrame = 0.08);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+#include "image_writer.h"
+
+struct ConsoleState;
+
+// Screenshots and frame recording off the render thread. Finished 3D views are copied into a fixed pool of
+// buffers and encoded by background writers; when every buffer is still queued the frame is dropped and
+// counted rather than stalling the render loop.
+class FrameCapture {
+public:
+    FrameCapture(int width, int height, size_t bufferCount = 8, unsigned writerThreads = 2);
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // The next offered frame is written to `path`; .ppm selects PPM, anything else PNG.
+    void requestScreenshot(std::string path);
+    // Every offered frame is written to dir/frame_000000.<ext>, ... until stopRecording().
+    bool startRecording(const std::string& dir, ImageFormat format);
+    void stopRecording();
+    bool recording() const { return recording_; }
+    bool wantsFrame() const { return recording_ || !screenshotPath_.empty(); }
+
+    // Called by the renderer with the finished frame (pitch in pixels) while it is still mapped.
+    void offer(const Uint32* pixels, int width, int height, int pitch);
+    // Blocks until everything queued so far is on disk.
+    void finish() { queue_.finish(); }
+
+    size_t captured() const { return captured_; }
+    size_t dropped() const { return dropped_; }
+    size_t recordedFrames() const { return frameIndex_; }
+    size_t written() const { return queue_.written(); }
+    size_t failed() const { return queue_.failed(); }
+    size_t maxQueued() const { return queue_.maxQueued(); }
+    double lastCopyMs() const { return lastCopyMs_; }
+    // Numbers screenshot_<n>.png names; counts up for the life of the capture.
+    int nextScreenshotNumber() { return screenshotCount_++; }
+
+private:
+    ImageWriteQueue queue_;
+    std::string screenshotPath_;
+    std::string recordDir_;
+    ImageFormat recordFormat_ = ImageFormat::PPM;
+    bool recording_ = false;
+    size_t frameIndex_ = 0;
+    size_t captured_ = 0;
+    size_t dropped_ = 0;
+    double lastCopyMs_ = 0.0;
+    int screenshotCount_ = 0;
+};
+
+// Saves the next 3D frame to `file`, or to the first unused screenshot_<n>.png when it is empty.
+void takeScreenshot(ConsoleState& console, FrameCapture& capture, std::string file);
+// screenshot, record, record_stop and capture_stats.
+void registerCaptureCommands(ConsoleState& console, FrameCapture& capture);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "game_types.h"
+
+struct EntityStore;
+
+constexpr double PLAYER_RADIUS = 0.25;
+constexpr float ACTOR_RADIUS = 0.25f;
+constexpr float SPRITE_RADIUS = 0.3f;
+
+struct CircleMove {
+    double x;
+    double y;
+    bool blockedX; // the x part of the move was cut short
+    bool blockedY;
+};
+
+// Walls, and doors that are not open far enough to walk through (see doorPassable).
+bool cellBlocksMovement(const Map& map, const std::vector<Door>& doors, int x, int y);
+// Moves a circle by (dx, dy), x first, then y, stopping each axis where the circle first touches a blocking
+// cell's face or corner. Exact for any step length, so fast movers cannot tunnel; cells the circle already
+// overlaps only stop it moving further in.
+CircleMove sweepCircle(const Map& map, const std::vector<Door>& doors, double x, double y, double radius, double dx, double dy);
+
+// Uniform grid broadphase over the map for the circles of solid entities. Colliders live in intrusive
+// per-cell lists, so an entity that crosses into another cell is relinked in O(1) and the rest cost one
+// comparison per sync. Queries read the positions of the last sync, which lets parallel entity updates
+// test against a consistent snapshot while they write the store.
+class CollisionGrid {
+public:
+    // Empties the grid and sizes it for a width x height map in square cells of `cellSize` units.
+    void reset(int width, int height, double cellSize = 1.0);
+    // Takes the store's positions: entities added since the last sync are inserted, and those whose cell
+    // changed are relinked. Entities with a zero radius are not colliders.
+    void sync(const EntityStore& entities);
+
+    // Calls fn(id, dx, dy, distanceSquared, minDistance) for every collider other than `ignore` whose circle
+    // overlaps the given one; (dx, dy) points from the collider to (x, y).
+    template <typename Fn>
+    void forEachOverlap(double x, double y, double radius, int ignore, Fn&& fn) const {
+        double reach = radius + maxRadius_;
+        int x0 = cellX(x - reach), x1 = cellX(x + reach);
+        int y0 = cellY(y - reach), y1 = cellY(y + reach);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                for (int id = head_[cy * cellsW_ + cx]; id >= 0; id = next_[id]) {
+                    double dx = x - x_[id];
+                    double dy = y - y_[id];
+                    double minDistance = radius + radius_[id];
+                    double distanceSquared = dx * dx + dy * dy;
+                    if (id != ignore && distanceSquared < minDistance * minDistance) {
+                        fn(id, dx, dy, distanceSquared, minDistance);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t colliders() const { return colliders_; }
+    size_t relinks() const { return relinks_; } // since reset
+
+private:
+    int cellX(double x) const { return std::clamp(static_cast<int>(std::floor(x * invCellSize_)), 0, cellsW_ - 1); }
+    int cellY(double y) const { return std::clamp(static_cast<int>(std::floor(y * invCellSize_)), 0, cellsH_ - 1); }
+    void link(int id, int cell);
+    void unlink(int id);
+
+    int cellsW_ = 1;
+    int cellsH_ = 1;
+    double invCellSize_ = 1.0;
+    double maxRadius_ = 0.0;
+    std::vector<int> head_{-1}; // first collider per cell, -1 when empty
+    std::vector<int> next_;     // per entity, -1 at the end of a list
+    std::vector<int> prev_;     // per entity, -1 at the head of a list
+    std::vector<int> cell_;     // per entity, -1 when not a collider
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<float> radius_;
+    size_t colliders_ = 0;
+    size_t relinks_ = 0;
+};
+
+// Moves a circle through the level: swept against the grid's cells, then pushed out of any collider it
+// overlaps (itself excepted), with the push swept too so it never ends up in a wall.
+CircleMove moveCircle(const Map& map, const std::vector<Door>& doors, const CollisionGrid* grid, double x, double y, double radius, double dx, double dy, int self = -1);
+// Gives non-light sprites a collision radius where they stand in the open (all eight neighbouring cells
+// free), so a barrel or pillar never closes a corridor.
+void assignSpriteColliders(EntityStore& entities, const Map& map);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "game_types.h"
+#include "lighting.h"
+
+// How a wall column is shaded: not at all, the unlit 0.7 side darkening, or a baked light level.
+enum class WallShade { None, Side, Lit };
+
+// Everything the wall pixel loop needs, resolved once per column.
+struct WallColumn {
+    Uint32* dst;          // row 0 of this column
+    int pitch;            // in pixels
+    int screenH;
+    int drawStart;        // unclipped span; may extend past the screen
+    int drawEnd;
+    const Uint32* texels; // ARGB8888 column base (texX applied); null for flat colour
+    int texStride;        // in pixels
+    int texH;
+    double texPos;        // texel row at drawStart
+    double texStep;
+    Color flat;           // door or wall colour when untextured
+    Uint32 lightR;        // 8.8, WallShade::Lit only
+    Uint32 lightG;
+    Uint32 lightB;
+};
+
+// One on-screen column of a sprite.
+struct SpriteStripe {
+    Uint32* dst;          // row 0 of this column
+    int pitch;
+    int screenH;
+    int startY;           // already clipped to the screen
+    int endY;
+    int spriteHeight;
+    const Uint32* texels; // ARGB8888 column base (texX applied)
+    int texStride;
+    int texH;
+    LightLevel light;
+};
+
+using WallKernel = void (*)(const WallColumn&);
+using SpriteKernel = void (*)(const SpriteStripe&);
+
+// Kernels compiled per (textured, shade, clipped) and per lit, so the pixel loops carry no mode branches.
+// Texels must be ARGB8888; clipped columns start at the first visible row instead of stepping through
+// the rows above the screen.
+WallKernel selectWallKernel(bool textured, WallShade shade, bool clipped);
+SpriteKernel selectSpriteKernel(bool lit);
+// Adds one to writes[y * pitch] for every row the stripe's kernel draws (its opaque texels).
+void countSpriteStripe(const SpriteStripe& s, Uint8* writes, int pitch);
+
+// The generic per-pixel loops the kernels replaced (surface sampling, SDL_GetRGBA, per-pixel mode and
+// bounds checks), kept as the baseline for --bench kernels. c.texels and s.texels are ignored.
+void drawWallColumnReference(const WallColumn& c, WallShade shade, SDL_Surface* surf, int texX);
+void drawSpriteStripeReference(const SpriteStripe& s, bool lit, SDL_Surface* surf, int texX);
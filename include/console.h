@@ -1,11 +1,42 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <functional>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "game_types.h"
 
+struct ConsoleState;
+
+// args[0] is the lower-cased command name.
+using ConsoleCommandFn = std::function<void(ConsoleState& console, const std::vector<std::string>& args)>;
+
+struct ConsoleCommand {
+    std::string usage; // e.g. "spawn_actors <n>", shown in help
+    std::string help;
+    ConsoleCommandFn run;
+};
+
+enum class CvarType { Bool, Int, Float, Choice };
+
+// Runs after a cvar's value actually changed.
+using CvarChangedFn = std::function<void(ConsoleState& console)>;
+
+// A typed setting bound to a variable owned by the module that registered it (usually a Config field).
+struct Cvar {
+    CvarType type = CvarType::Bool;
+    std::string help;
+    std::string defaultValue;         // text form at registration, restored by reset
+    double minValue = 0.0;            // Int and Float
+    double maxValue = 0.0;
+    std::vector<std::string> choices; // Choice, in enum order
+    std::function<std::string()> get;
+    std::function<std::string(const std::string& text)> assign; // parses and stores; returns an error or ""
+    CvarChangedFn onChange;
+};
+
 struct ConsoleState {
     bool open = false;
     bool showFPS = false;
@@ -13,7 +44,30 @@ struct ConsoleState {
     std::vector<std::string> history;
     int historyIndex = -1; // -1 means editing current input
     std::vector<std::string> log;
+    size_t logged = 0; // lines ever added to log, which keeps only the latest
+    std::map<std::string, ConsoleCommand> commands; // registered by other modules
+    std::map<std::string, Cvar> cvars;              // likewise
 };
 
+void registerConsoleCommand(ConsoleState& console, const std::string& name, const std::string& usage, const std::string& help, ConsoleCommandFn run);
+void registerCvar(ConsoleState& console, const std::string& name, bool* value, const std::string& help, CvarChangedFn onChange = nullptr);
+void registerCvar(ConsoleState& console, const std::string& name, int* value, int minValue, int maxValue, const std::string& help, CvarChangedFn onChange = nullptr);
+void registerCvar(ConsoleState& console, const std::string& name, double* value, double minValue, double maxValue, const std::string& help, CvarChangedFn onChange = nullptr);
+void registerChoiceCvar(ConsoleState& console, const std::string& name, std::vector<std::string> choices, std::function<int()> get, std::function<void(int)> set, const std::string& help, CvarChangedFn onChange = nullptr);
+// An enum whose values run 0..choices.size()-1, set by name.
+template <typename Enum>
+void registerCvar(ConsoleState& console, const std::string& name, Enum* value, std::vector<std::string> choices, const std::string& help, CvarChangedFn onChange = nullptr) {
+    registerChoiceCvar(console, name, std::move(choices), [value] { return static_cast<int>(*value); },
+                       [value](int index) { *value = static_cast<Enum>(index); }, help, std::move(onChange));
+}
+// Parses, range-checks and stores `text`, then runs the change callback. On failure returns false and
+// leaves the reason in `error`.
+bool setCvar(ConsoleState& console, const std::string& name, const std::string& text, std::string& error);
+// "name value" or "set name value" per line; blank lines and # comments are skipped. Bad lines are
+// reported and skipped. Returns false if the file could not be read.
+bool loadCvarFile(ConsoleState& console, const std::string& path);
+void consolePrint(ConsoleState& console, const std::string& line);
+// Runs one command line as if typed (without adding it to the input history); returns the lines it logged.
+std::vector<std::string> executeConsoleCommand(ConsoleState& console, const std::string& line, Config& cfg, Player& player, bool& running);
 void setConsoleOpen(ConsoleState& console, bool open);
 void handleConsoleEvent(ConsoleState& console, const SDL_Event& e, Config& cfg, Player& player, bool& running);
@@ -9,6 +9,11 @@ std::vector<Door> extractDoors(const Map& map);
 Door* findDoor(std::vector<Door>& doors, int x, int y);
 const Door* findDoor(const std::vector<Door>& doors, int x, int y);
 bool computeDoorHit(const Door& door, const Player& player, double rayDirX, double rayDirY, double& dist, bool& side);
+bool computeDoorHit(const Door& door, double originX, double originY, double rayDirX, double rayDirY, double& dist, bool& side);
+// Open far enough to walk through; movement and path costs both use this threshold.
+bool doorPassable(const Door& door);
 bool playerInDoorway(const Door& door, const Player& player);
 Door* doorInFront(Player& player, const Map& map, std::vector<Door>& doors);
 void updateDoors(std::vector<Door>& doors, const Player& player, double dt);
+// Any player standing in a doorway holds that door open.
+void updateDoors(std::vector<Door>& doors, const std::vector<Player>& players, double dt);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+class CollisionGrid;
+class ThreadPool;
+
+enum EntityFlags : Uint32 {
+    ENTITY_VISIBLE = 1u << 0, // drawn by the sprite pass
+    ENTITY_WANDER = 1u << 1,  // picks random headings and moves every tick
+};
+
+// Structure-of-arrays entity storage: entity i is element i of every array.
+struct EntityStore {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> velX;
+    std::vector<double> velY;
+    std::vector<int> textureId;   // index into TextureManager::spriteTextures
+    std::vector<float> animTime;  // seconds until the next heading change
+    std::vector<Uint32> rngState; // per-entity xorshift state so parallel updates stay deterministic
+    std::vector<Uint32> flags;    // EntityFlags
+    std::vector<float> radius;    // collision circle; 0 for entities nothing bumps into
+
+    size_t size() const { return x.size(); }
+};
+
+size_t addEntity(EntityStore& store, double x, double y, int textureId, Uint32 flags, float radius = 0.0f);
+EntityStore entitiesFromSprites(const std::vector<Sprite>& sprites);
+void spawnWanderers(EntityStore& store, const Map& map, int count, unsigned seed);
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, double dt);
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, double dt, ThreadPool& pool);
+// As above, and wanderers also push apart from the grid's colliders (as of its last sync) and bounce off them.
+// Sync the grid afterwards to pick up the new positions.
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, const CollisionGrid& grid, double dt);
+void updateEntities(EntityStore& store, const Map& map, const std::vector<Door>& doors, const CollisionGrid& grid, double dt, ThreadPool& pool);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+class ThreadPool;
+
+// Writes a column-major image (column x at src + x * columnStride, rows contiguous) into a row-major one
+// (row y at dst + y * dstPitch). Cache-blocked tiles, 4x4 SSE2 or NEON transposes where available, split
+// into row bands across the pool.
+void transposeColumnsToRows(const Uint32* src, int width, int height, int columnStride, Uint32* dst, int dstPitch, ThreadPool& pool);
+// "sse2", "neon" or "scalar".
+const char* transposeIsa();
+
+// Column-major scratch frame the renderer draws into before the transpose on present.
+struct ColumnMajorFrame {
+    std::vector<Uint32> pixels;
+    int width = 0;
+    int height = 0;
+
+    // Grows the buffer only when the frame size changes.
+    void resize(int w, int h);
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <memory>
 #include <vector>
 
 constexpr int DOOR_TILE = 5;
@@ -11,10 +12,19 @@ struct Color {
     Uint8 b;
 };
 
+// Floor rectangle carved by the generator; corridors may run through it.
+struct MapRoom {
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
 struct Map {
     int width;
     int height;
     std::vector<int> tiles; // 0 = empty, >0 = wall id
+    std::vector<MapRoom> rooms;
 
     int at(int x, int y) const {
         if (x < 0 || x >= width || y < 0 || y >= height) {
@@ -51,21 +61,68 @@ struct Player {
     double planeY;
 };
 
+enum class TextureMode {
+    Flat,      // walls in flat per-tile colours; sprites stay textured
+    Full,      // full-resolution textures only
+    Mipmapped, // prefiltered mip levels for distant walls/sprites
+};
+
+// Renderer counters and which of them is drawn as a heatmap over the 3D view.
+enum class DiagOverlay {
+    Off,      // nothing counted
+    Counters, // per-frame totals only
+    Steps,    // DDA cell steps per column
+    Doors,    // door slab intersection tests per column
+    Overdraw, // pixel writes per screen pixel, sprites included
+};
+
 struct Config {
     int screenWidth = 960;
     int screenHeight = 640;
     double moveSpeed = 3.0;      // units per second
     double moveSpeedSprint = 5.0; // units per second when sprinting
     double rotSpeed = 1.8;       // radians per second
+    bool mouseLook = true;       // relative-mode mouse turning while the console is closed
+    double mouseSensitivity = 0.0025; // radians per mouse count
     double wallHeight = 1.0;
+    TextureMode textureMode = TextureMode::Mipmapped;
+    bool lighting = true;        // apply the baked lightmap when one is supplied
+    bool wallSpans = true;       // cast only at wall-face edges and solve the columns between analytically
+    bool pvsCulling = true;      // skip sprites (and minimap cells) outside the PVS visible set
+    double renderScale = 1.0;    // 3D view resolution relative to the window, stretched on present
+    bool columnMajor = false;    // draw into a column-major buffer and transpose it into the texture on present
+    DiagOverlay diagnostics = DiagOverlay::Off;
 };
 
 struct SDLContext {
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
+    SDL_Texture* frameTexture = nullptr; // streaming ARGB8888 target for the 3D view
+    int frameWidth = 0;                  // frameTexture size, which Config::renderScale may make smaller
+    int frameHeight = 0;                 // than the window
 };
 
+// Startup timing for loadTextures; decode/convert are summed across worker threads.
+struct AssetLoadStats {
+    bool fromCache = false;
+    unsigned threads = 1;
+    size_t textureCount = 0;
+    size_t pixelBytes = 0; // all mip levels
+    double ioMs = 0.0;      // manifest, source reads, cache write or map
+    double decodeMs = 0.0;  // PNG decode
+    double convertMs = 0.0; // ARGB8888 conversion and mip generation
+    double totalMs = 0.0;   // wall clock
+};
+
+class TextureResidency;
+
 struct TextureManager {
     std::vector<SDL_Surface*> textures;       // index by tile id
     std::vector<SDL_Surface*> spriteTextures; // index by Sprite::textureId
+    // Prefiltered mip chains, level 0 aliases the surface in the vectors above.
+    std::vector<std::vector<SDL_Surface*>> textureMips;
+    std::vector<std::vector<SDL_Surface*>> spriteMips;
+    std::shared_ptr<void> archive; // mapped texture cache backing the surfaces, if any
+    TextureResidency* residency = nullptr; // swaps wall textures in and out when attached
+    AssetLoadStats loadStats;
 };
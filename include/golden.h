@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Headless regression check: renders fixed seeds, poses and door states through every renderer path
+// and compares them with stored reference frames and stage timings.
+// args: check|update [--dir d] [--tolerance n] [--max-differing pct] [--budget pct] [--repeat n] [--no-timing]
+int runGolden(const std::vector<std::string>& args);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game_types.h"
+
+enum class ImageFormat {
+    PPM,
+    PNG,
+};
+
+bool parseImageFormat(const std::string& name, ImageFormat& format);
+const char* imageExtension(ImageFormat format);
+// Writes ARGB8888 pixels (pitch in pixels) as binary PPM or PNG.
+bool writeImage(const std::string& path, const Uint32* pixels, int width, int height, int pitch, ImageFormat format);
+// Reads a binary PPM (as written above) into opaque ARGB8888 pixels; false if missing or malformed.
+bool readPpm(const std::string& path, std::vector<Uint32>& pixels, int& width, int& height);
+
+struct ImageBuffer {
+    std::vector<Uint32> pixels;
+    int width = 0;
+    int height = 0;
+    std::string path;
+    ImageFormat format = ImageFormat::PPM;
+};
+
+// Fixed set of frame buffers cycled between producers and background writer threads.
+// Producers block in acquire() only when every buffer is still waiting to be written.
+class ImageWriteQueue {
+public:
+    ImageWriteQueue(int width, int height, size_t bufferCount, unsigned writerThreads, ImageFormat format);
+    ~ImageWriteQueue();
+    ImageWriteQueue(const ImageWriteQueue&) = delete;
+    ImageWriteQueue& operator=(const ImageWriteQueue&) = delete;
+
+    ImageBuffer* acquire();
+    // Non-blocking acquire for producers that would rather skip a frame than wait; null when all are busy.
+    ImageBuffer* tryAcquire();
+    void submit(ImageBuffer* buffer, std::string path);
+    void submit(ImageBuffer* buffer, std::string path, ImageFormat format);
+    // Blocks until everything submitted so far is on disk.
+    void finish();
+
+    size_t written() const;
+    size_t failed() const;
+    double acquireWaitMs() const;   // total time producers spent waiting for a free buffer
+    size_t maxQueued() const;
+
+private:
+    void writerLoop();
+
+    ImageFormat format_;
+    std::vector<ImageBuffer> buffers_;
+    std::vector<ImageBuffer*> free_;
+    std::deque<ImageBuffer*> pending_;
+    size_t inFlight_ = 0;
+    size_t written_ = 0;
+    size_t failed_ = 0;
+    size_t maxQueued_ = 0;
+    double acquireWaitMs_ = 0.0;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable freeReady_;
+    std::condition_variable workReady_;
+    std::condition_variable drained_;
+    std::vector<std::thread> writers_;
+};
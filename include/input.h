@@ -1,7 +1,61 @@
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "game_types.h"
 
-void handleInput(const Uint8* keystate, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt);
+class CollisionGrid;
+struct ConsoleState;
+
+// Buttons held during one tick; local keys and server clients both reduce to these.
+enum InputButton : Uint8 {
+    INPUT_FORWARD = 1 << 0,
+    INPUT_BACK = 1 << 1,
+    INPUT_TURN_LEFT = 1 << 2,
+    INPUT_TURN_RIGHT = 1 << 3,
+    INPUT_SPRINT = 1 << 4,
+    INPUT_USE = 1 << 5,
+};
+
+// Mouse turning gathered between frames and the latency of the turns that reached the screen.
+struct MouseLook {
+    bool relative = false;      // SDL relative mode is on
+    Sint32 pendingX = 0;        // counts not applied to the player yet
+    bool pending = false;
+    Uint32 oldestEvent = 0;     // SDL timestamp of the first pending event
+    bool applied = false;       // this frame turned the player
+    Uint32 appliedEvent = 0;
+    Uint64 appliedCounter = 0;  // performance counter when the turn was applied
+    std::array<float, 256> eventToPresentMs{}; // ring of the latest samples
+    std::array<float, 256> applyToPresentMs{};
+    size_t samples = 0;         // ever taken; the ring holds the last 256
+};
+
+struct MouseLatencyStats {
+    size_t samples = 0;
+    double eventMeanMs = 0.0, eventP95Ms = 0.0, eventMaxMs = 0.0; // first motion event to present
+    double applyMeanMs = 0.0, applyMaxMs = 0.0;                   // turn applied to present
+};
+
+Uint8 inputFromKeys(const Uint8* keystate);
+// Turns relative mode on while cfg.mouseLook is set and `captured` (the console is closed); leaving it
+// drops any pending motion.
+void setMouseCaptured(MouseLook& look, const Config& cfg, bool captured);
+// Adds a motion event's x delta to the pending turn; ignores other events and motion outside relative mode.
+void accumulateMouseMotion(MouseLook& look, const SDL_Event& e);
+// Pumps SDL and takes only the motion events queued since the last poll, then turns the player by the
+// whole pending delta. Call right before the views are set up so the turn is as fresh as the frame allows.
+void applyMouseLook(MouseLook& look, Player& player, const Config& cfg);
+// After present: records the latency of the turn this frame applied, if any.
+void finishMouseLookFrame(MouseLook& look);
+MouseLatencyStats mouseLatencyStats(const MouseLook& look);
+// Moves one player; previousButtons is that player's last input, so Use only fires on the press. The player
+// is a PLAYER_RADIUS circle swept against walls and closed doors, and pushed out of the grid's colliders
+// when one is given.
+void applyPlayerInput(Uint8 buttons, Uint8& previousButtons, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt, const CollisionGrid* grid = nullptr);
+void handleInput(const Uint8* keystate, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt, const CollisionGrid* grid = nullptr);
+// move_speed, sprint_speed, turn_speed, m_look and m_sensitivity, bound to cfg.
+void registerInputCvars(ConsoleState& console, Config& cfg);
+// input_latency, reporting on `mouseLook`.
+void registerInputCommands(ConsoleState& console, const MouseLook& mouseLook);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "collision.h"
+#include "entities.h"
+#include "game_types.h"
+#include "lighting.h"
+#include "pvs.h"
+
+class ThreadPool;
+struct ConsoleState;
+
+// Everything that belongs to one level. Built as a whole and swapped in as a whole.
+struct Level {
+    unsigned seed = 0;
+    Map map;
+    std::vector<Door> doors;
+    PvsData pvs;
+    EntityStore entities;
+    CollisionGrid collision; // synced with entities after every update
+    Lightmap lightmap;
+    Player spawn{};
+    double buildMs = 0.0;
+    size_t texturePagesTouched = 0; // pages of the level's textures faulted in ahead of the first frame
+};
+
+// Generates the map and sprites from `seed`, then derives doors, colliders, PVS and lightmap on `pool`.
+// Sprites next to the spawn point are dropped. Texture memory the level will sample is touched so a memory-mapped
+// cache is paged in here rather than during the first frames.
+std::unique_ptr<Level> buildLevel(unsigned seed, const TextureManager& tm, ThreadPool& pool);
+
+// Builds the next level on a loader thread of its own while the current one keeps running, so neither the
+// frame loop nor the render workers wait on it.
+class LevelManager {
+public:
+    LevelManager() = default;
+    ~LevelManager();
+    LevelManager(const LevelManager&) = delete;
+    LevelManager& operator=(const LevelManager&) = delete;
+
+    // Starts building `seed`; false while another build is still running. A finished but untaken level is
+    // discarded. `tm` must outlive the build.
+    bool preload(unsigned seed, const TextureManager& tm);
+    bool building() const { return loader_.joinable() && !finished_.load(); }
+    bool ready() const { return loader_.joinable() && finished_.load(); }
+    unsigned pendingSeed() const { return pendingSeed_; }
+    // The finished level, handed over once; null while building or when nothing was preloaded.
+    std::unique_ptr<Level> takeReady();
+    // Frees a swapped-out level on a retire thread of its own, so its destruction lands neither in a frame
+    // nor ahead of the render's jobs on the shared pool. Levels still queued are freed before the destructor returns.
+    void retire(std::unique_ptr<Level> level);
+    // Waits for a running build, drops an untaken level and frees every retired one. Call before the textures a
+    // build was given are freed; the destructor does the same.
+    void shutdown();
+
+private:
+    void retireLoop();
+
+    std::thread loader_;
+    std::atomic<bool> finished_{false};
+    std::unique_ptr<Level> result_; // written by the loader before finished_ is set
+    unsigned pendingSeed_ = 0;
+    std::thread retirer_; // started by the first retire
+    std::mutex retireMutex_;
+    std::condition_variable retireReady_;
+    std::vector<std::unique_ptr<Level>> retired_;
+    bool stopping_ = false;
+};
+
+// spawn_actors and pvs_stats on whatever `level` holds when they run, pvs_stats with the frame's `visible` set;
+// level_preload and level_switch drive `levels`. level_switch only sets `switchPending` for the frame loop to act
+// on, and a new build clears `readyReported` so the loop announces it once.
+void registerLevelCommands(ConsoleState& console, std::unique_ptr<Level>& level, const VisibleRegions& visible, LevelManager& levels, const TextureManager& textures, bool& switchPending, bool& readyReported);
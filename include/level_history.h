@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "entities.h"
+#include "game_types.h"
+
+struct ConsoleState;
+struct Level;
+
+// What one capture copied and shared.
+struct CowCaptureStats {
+    size_t chunksCopied = 0;
+    size_t chunksShared = 0;
+    size_t bytesCopied = 0;
+};
+
+// A vector stored as fixed-size chunks that snapshots share for as long as their contents stay the same.
+// Numbers compare bitwise, so a restore gives back exactly what was captured.
+template <typename T, size_t Chunk = 256>
+class CowArray {
+public:
+    using ChunkPtr = std::shared_ptr<const std::vector<T>>;
+
+    // Records `live`, sharing every chunk equal to the same chunk of `prev` and copying the rest.
+    template <typename Eq>
+    void capture(const std::vector<T>& live, const CowArray* prev, CowCaptureStats& stats, Eq equal) {
+        size_t count = (live.size() + Chunk - 1) / Chunk;
+        chunks_.resize(count);
+        size_ = live.size();
+        for (size_t c = 0; c < count; ++c) {
+            const T* begin = live.data() + c * Chunk;
+            size_t length = std::min(Chunk, live.size() - c * Chunk);
+            const ChunkPtr* old = prev && c < prev->chunks_.size() ? &prev->chunks_[c] : nullptr;
+            if (old && (*old)->size() == length && sameChunk(begin, (*old)->data(), length, equal)) {
+                chunks_[c] = *old;
+                ++stats.chunksShared;
+                continue;
+            }
+            chunks_[c] = std::make_shared<const std::vector<T>>(begin, begin + length);
+            ++stats.chunksCopied;
+            stats.bytesCopied += length * sizeof(T);
+        }
+    }
+    void capture(const std::vector<T>& live, const CowArray* prev, CowCaptureStats& stats) {
+        capture(live, prev, stats, [](const T& a, const T& b) { return a == b; });
+    }
+
+    // Replaces `out` with the captured contents; no allocation when `out` already has the capacity.
+    void restore(std::vector<T>& out) const {
+        out.clear();
+        for (const ChunkPtr& chunk : chunks_) {
+            out.insert(out.end(), chunk->begin(), chunk->end());
+        }
+    }
+
+    size_t size() const { return size_; }
+    const std::vector<ChunkPtr>& chunks() const { return chunks_; }
+
+private:
+    template <typename Eq>
+    static bool sameChunk(const T* a, const T* b, size_t length, Eq equal) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return std::memcmp(a, b, length * sizeof(T)) == 0;
+        } else {
+            for (size_t i = 0; i < length; ++i) {
+                if (!equal(a[i], b[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::vector<ChunkPtr> chunks_;
+    size_t size_ = 0;
+};
+
+// The mutable state of a level at one moment: tiles, doors, entities and the player. Map size, rooms,
+// PVS and lightmap are derived from the level's seed or from these, so they are not stored.
+struct LevelSnapshot {
+    double time = 0.0; // game seconds
+    unsigned seed = 0;
+    Player player{};
+    CowArray<int, 4096> tiles;
+    CowArray<Door, 16> doors;
+    CowArray<double> x, y, velX, velY;
+    CowArray<int> textureId;
+    CowArray<float> animTime;
+    CowArray<Uint32> rngState;
+    CowArray<Uint32> flags;
+    CowArray<float> radius;
+};
+
+struct LevelHistoryStats {
+    size_t snapshots = 0;
+    double seconds = 0.0;        // covered by the ring, oldest to newest
+    double lastCaptureUs = 0.0;
+    double avgCaptureUs = 0.0;
+    size_t captures = 0;
+    CowCaptureStats last;        // of the newest capture
+    size_t uniqueBytes = 0;      // chunk memory the ring holds, shared chunks counted once
+    size_t fullCopyBytes = 0;    // what one snapshot would take copied in full
+};
+
+// A bounded ring of snapshots of the current level, taken at most every `interval` game seconds. Tiles
+// sit in 4096-tile chunks, doors in blocks of 16 and entity arrays in 256-entry chunks; a snapshot copies
+// only the chunks that differ from the one before and shares the rest, so static geometry and parked
+// sprites cost nothing per capture.
+class LevelHistory {
+public:
+    explicit LevelHistory(double seconds = 10.0, double interval = 0.05);
+
+    // Captures `level` and `player` if `interval` has passed since the last capture. A different level
+    // (seed) than the snapshots held starts the history over.
+    void record(const Level& level, const Player& player, double time);
+    // Restores the newest snapshot taken at least `seconds` before the latest one (the oldest held if the
+    // history is shorter) and drops everything after it. Rebuilds the level's collision grid; the lightmap
+    // follows the doors on its next sync. False when nothing is held for this level.
+    bool rewind(double seconds, Level& level, Player& player, double& time);
+    void clear();
+    // Keeps the newest snapshots that fit the new length.
+    void setLength(double seconds);
+    LevelHistoryStats stats() const;
+
+private:
+    const LevelSnapshot& at(size_t age) const { return ring_[(head_ + ring_.size() - age) % ring_.size()]; } // 0 = newest
+
+    double interval_;
+    std::vector<LevelSnapshot> ring_;
+    size_t head_ = 0; // newest
+    size_t count_ = 0;
+    double captureUsTotal_ = 0.0;
+    double lastCaptureUs_ = 0.0;
+    size_t captures_ = 0;
+    CowCaptureStats last_;
+};
+
+// history_seconds (stored in `seconds`), rewind and snapshot_stats. rewind restores into whatever `level` holds,
+// moves `player` and `gameTime` back with it, and refuses while `paused` is set (a timedemo is running).
+void registerLevelHistoryCommands(ConsoleState& console, LevelHistory& history, double& seconds, std::unique_ptr<Level>& level, Player& player, double& gameTime, const bool& paused);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include "entities.h"
+#include "game_types.h"
+
+class ThreadPool;
+
+constexpr int LIGHT_SPRITE_ID = 2; // sprite_greenlight.png emits light
+
+// Per-channel multiplier in 8.8 fixed point; 256 leaves the texel unchanged.
+struct LightLevel {
+    Uint16 r;
+    Uint16 g;
+    Uint16 b;
+};
+
+struct LightSource {
+    double x;
+    double y;
+    double radius;
+    float r;
+    float g;
+    float b;
+};
+
+enum LightFace {
+    FACE_WEST = 0,
+    FACE_EAST = 1,
+    FACE_NORTH = 2,
+    FACE_SOUTH = 3,
+};
+
+// Baked light per wall face and per floor/door cell, from static light sprites.
+struct Lightmap {
+    int width = 0;
+    int height = 0;
+    std::vector<LightLevel> faces; // 4 per tile, indexed by LightFace
+    std::vector<LightLevel> cells; // sprites and door slabs take their cell's level
+    std::vector<LightSource> lights;
+    std::vector<Uint8> doorOpen;   // door states the current bake assumed
+    double bakeMs = 0.0;
+
+    const LightLevel& face(int x, int y, int f) const { return faces[(y * width + x) * 4 + f]; }
+    const LightLevel& cell(int x, int y) const { return cells[y * width + x]; }
+};
+
+// Face of the hit tile that a DDA ray with this side flag and direction sees.
+inline int faceForHit(bool side, double rayDirX, double rayDirY) {
+    if (!side) {
+        return rayDirX > 0 ? FACE_WEST : FACE_EAST;
+    }
+    return rayDirY > 0 ? FACE_NORTH : FACE_SOUTH;
+}
+
+// Stationary light sprites; wanderers carrying the texture do not light the level.
+std::vector<LightSource> collectLights(const EntityStore& entities);
+Lightmap bakeLightmap(const Map& map, const std::vector<Door>& doors, std::vector<LightSource> lights);
+Lightmap bakeLightmap(const Map& map, const std::vector<Door>& doors, std::vector<LightSource> lights, ThreadPool& pool);
+// Rebakes only the neighbourhood of doors that opened or shut since the last bake; returns how many did.
+int syncLightmapDoors(Lightmap& lightmap, const Map& map, const std::vector<Door>& doors);
+int syncLightmapDoors(Lightmap& lightmap, const Map& map, const std::vector<Door>& doors, ThreadPool& pool);
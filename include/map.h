@@ -5,5 +5,8 @@
 #include <vector>
 
 Map createRandomMap();
+// Same seed and size always produce the same map; width/height 0 picks a random size.
+Map createRandomMap(unsigned seed, int width = 0, int height = 0);
 std::pair<double, double> pickSpawnPoint(const Map& map);
 std::vector<Sprite> createSprites(const Map& map);
+std::vector<Sprite> createSprites(const Map& map, unsigned seed);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Headless mode: renders every frame of a camera path to numbered images.
+// args: --render-path <file|auto> --out <dir> [--seed n] [--format ppm|png] [--size WxH] [--writers n]
+int runOfflineRender(const std::vector<std::string>& args);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+struct GridPoint {
+    int x;
+    int y;
+};
+
+// Movement costs: 10 per straight step, 14 per diagonal, plus the entered cell's extra cost.
+constexpr Uint32 NAV_STRAIGHT_COST = 10;
+constexpr Uint32 NAV_DIAGONAL_COST = 14;
+constexpr Uint16 NAV_DOOR_OPEN_COST = 2;    // squeezing through an open door
+constexpr Uint16 NAV_DOOR_CLOSED_COST = 30; // waiting for a closed door to open
+constexpr Uint32 NAV_UNREACHABLE = 0xffffffffu;
+
+// Passability and per-cell entry cost derived from a Map; doors are passable with a cost.
+struct NavGrid {
+    int width = 0;
+    int height = 0;
+    std::vector<Uint8> passable;
+    std::vector<Uint16> extraCost;
+
+    bool walkable(int x, int y) const {
+        return x >= 0 && y >= 0 && x < width && y < height && passable[y * width + x];
+    }
+};
+
+// Integration field towards one target; direction indexes the 8 neighbour offsets, -1 for none.
+struct FlowField {
+    int targetX = 0;
+    int targetY = 0;
+    std::vector<Uint32> distance;
+    std::vector<Sint8> direction;
+    unsigned long long lastUsed = 0;
+};
+
+NavGrid buildNavGrid(const Map& map, const std::vector<Door>& doors);
+
+// Jump-point search for single queries plus an LRU cache of flow fields for
+// many-agents-to-one-target movement. Not thread-safe; use one per thread.
+class PathService {
+public:
+    PathService(const Map& map, const std::vector<Door>& doors);
+
+    // Fills waypoints (start and goal included) with a least-cost path; cost is optional.
+    bool findPath(GridPoint start, GridPoint goal, std::vector<GridPoint>& waypoints, Uint32* cost = nullptr);
+    // Returns the cached field for the target, building it on a miss.
+    const FlowField& flowFieldTo(GridPoint target);
+    // Unit step (dx, dy) an agent in the cell should take; false at the target or when unreachable.
+    static bool flowStep(const FlowField& field, int width, int x, int y, int& dx, int& dy);
+    // Picks up door open/closed changes and repairs cached fields around them; returns the number of doors that changed.
+    int syncDoors(const std::vector<Door>& doors);
+
+    const NavGrid& grid() const { return grid_; }
+    size_t cachedFieldCount() const { return fields_.size(); }
+    void setCacheCapacity(size_t capacity) { cacheCapacity_ = capacity < 1 ? 1 : capacity; }
+
+private:
+    struct OpenNode {
+        Uint32 f;
+        int cell;
+        bool operator>(const OpenNode& other) const { return f > other.f; }
+    };
+
+    void buildField(FlowField& field);
+    void updateCellCost(int cell, Uint16 extraCost);
+    void repairField(FlowField& field, int cell, Uint16 oldCost);
+    void propagate(FlowField& field, std::vector<OpenNode>& open);
+    bool jump(int x, int y, int dx, int dy, GridPoint goal, GridPoint& out) const;
+    bool jumpStraight(int x, int y, int dx, int dy, GridPoint goal, GridPoint& out) const;
+
+    NavGrid grid_;
+    std::vector<FlowField> fields_;
+    size_t cacheCapacity_ = 8;
+    unsigned long long useCounter_ = 0;
+    std::vector<int> doorCells_;
+    std::vector<Uint8> doorOpen_;
+
+    // A* scratch reused across queries; stamp marks which entries belong to the current search.
+    std::vector<Uint32> gScore_;
+    std::vector<int> parent_;
+    std::vector<Uint32> stamp_;
+    std::vector<Uint8> closed_;
+    Uint32 searchId_ = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+class ThreadPool;
+
+// Connection between two regions; door is an index into the doors vector, or -1 when they touch directly.
+struct PvsEdge {
+    int region;
+    int door;
+};
+
+// Floor cells grouped into regions (generator rooms, then corridor pieces split at doors) and a
+// region-to-region visibility matrix computed with every door open. The matrix is ray-sampled, then grown
+// by one ring of neighbouring regions so sampling gaps err towards drawing too much.
+struct PvsData {
+    int width = 0;
+    int height = 0;
+    int regionCount = 0;
+    std::vector<int> regionOf;    // per cell; -1 for walls and door cells
+    std::vector<int> doorOf;      // per cell; door index for door cells, else -1
+    std::vector<int> doorSides;   // two regions per door (-1 when a side is not floor)
+    std::vector<std::vector<PvsEdge>> edges;
+    size_t rowWords = 0;
+    std::vector<Uint64> visible;  // regionCount rows of rowWords bits
+    double buildMs = 0.0;
+
+    bool regionSees(int from, int to) const {
+        return (visible[from * rowWords + (to >> 6)] >> (to & 63)) & 1;
+    }
+};
+
+// Regions potentially visible from one position under the current door states.
+struct VisibleRegions {
+    const PvsData* pvs = nullptr;
+    bool all = true;            // no PVS, or the viewer is outside every region
+    std::vector<Uint64> bits;
+    std::vector<int> queue;     // scratch reused between frames
+    int count = 0;
+
+    bool containsRegion(int region) const {
+        return all || (region >= 0 && ((bits[region >> 6] >> (region & 63)) & 1));
+    }
+    // Floor and door cells only; walls are never contained unless everything is.
+    bool containsCell(int x, int y) const {
+        if (all) return true;
+        if (x < 0 || y < 0 || x >= pvs->width || y >= pvs->height) return false;
+        int cell = y * pvs->width + x;
+        int door = pvs->doorOf[cell];
+        if (door >= 0) {
+            return containsRegion(pvs->doorSides[door * 2]) || containsRegion(pvs->doorSides[door * 2 + 1]);
+        }
+        return pvs->regionOf[cell] >= 0 && containsRegion(pvs->regionOf[cell]);
+    }
+};
+
+PvsData buildPvs(const Map& map, const std::vector<Door>& doors);
+PvsData buildPvs(const Map& map, const std::vector<Door>& doors, ThreadPool& pool);
+// A region is visible when the precomputed matrix says so and it can be reached from the viewer
+// through visible regions without crossing a fully closed door.
+void computeVisibleRegions(const PvsData& pvs, const std::vector<Door>& doors, double x, double y, VisibleRegions& out);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+struct RayHit {
+    int mapX = 0;
+    int mapY = 0;
+    int wallId = 0;           // tile id that stopped the ray, DOOR_TILE for a door slab
+    bool side = false;        // true when a y-facing (north/south) face was hit
+    double distance = 0.0;    // along the ray in units of the direction vector's length
+    const Door* door = nullptr;
+    int steps = 0;            // DDA cell steps taken
+    int doorTests = 0;        // door slabs intersected on the way
+    bool crossedDoor = false; // passed through a door cell on the way to the hit
+};
+
+// Grid DDA shared by the renderer and visibility queries. Marches from the origin along
+// (dirX, dirY) until a wall or door slab is hit, or until the ray has passed maxDist.
+// Door slabs follow their current openAmount, so rays pass through the open gap.
+bool castRay(const Map& map, const std::vector<Door>& doors, double originX, double originY, double dirX, double dirY, double maxDist, RayHit& hit);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "alloc_stats.h"
+#include "framebuffer.h"
+#include "render_diagnostics.h"
+
+class FrameCapture;
+class ThreadPool;
+
+// Bump allocator for per-frame scratch. A frame that outgrows the block is served from
+// temporary heap blocks, and the next reset() grows the block to that frame's high-water
+// mark, so steady-state frames never touch the heap.
+class FrameArena {
+public:
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialised storage valid until the next reset().
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+    void reset();
+
+    size_t capacity() const { return capacity_; }
+    size_t highWater() const { return highWater_; }
+    unsigned growCount() const { return growCount_; }
+
+private:
+    void* allocateBytes(size_t bytes, size_t align);
+
+    std::unique_ptr<unsigned char[]> block_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    size_t highWater_ = 0;
+    unsigned growCount_ = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow_;
+};
+
+// Scratch memory that outlives a frame; owned by whoever drives the render loop.
+struct RenderContext {
+    FrameArena arena;
+    AllocationCounters lastFrameAllocations; // heap allocations the last renderFrame made, on its thread and its pool workers
+    ThreadPool* pool = nullptr;              // column workers; null uses workerPool()
+    unsigned lastFrameRays = 0;              // wall rays cast by the last renderViews
+    unsigned lastFrameSprites = 0;           // sprites projected into the last renderViews' views
+    double lastViewsMs = 0.0;                // 3D views of the last renderFrame, transpose included
+    FrameCapture* capture = nullptr;         // handed each finished 3D view by renderFrame while it wants frames
+    ColumnMajorFrame columnFrame;            // renderFrame's intermediate target when cfg.columnMajor
+    RenderDiagnostics diagnostics;           // filled by renderViews while cfg.diagnostics is on
+};
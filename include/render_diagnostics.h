@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game_types.h"
+
+// Build with -DRAYCASTER_DIAGNOSTICS=0 to leave the counting column loops out of the binary altogether;
+// with it on, frames rendered while r_diag is off take the same loops as a build without it.
+#ifndef RAYCASTER_DIAGNOSTICS
+#define RAYCASTER_DIAGNOSTICS 1
+#endif
+
+struct FrameTarget;
+
+struct DiagnosticTotals {
+    uint64_t ddaSteps = 0;
+    uint64_t doorTests = 0;
+    uint64_t pixelWrites = 0; // background, walls and opaque sprite texels
+    uint64_t pixels = 0;
+    unsigned columns = 0;
+    unsigned maxSteps = 0;     // in one column
+    unsigned maxDoorTests = 0; // in one column
+    unsigned maxOverdraw = 0;  // writes to one pixel
+};
+
+// Counters one frame's column tasks write into. Each task only touches its own columns, so nothing is
+// shared between workers.
+struct RenderDiagnostics {
+    int width = 0;
+    int height = 0;
+    std::vector<SDL_Rect> viewports;
+    std::vector<int> columnOffset;    // first entry of each view in steps/doorTests
+    std::vector<uint32_t> steps;      // per view column, views back to back
+    std::vector<uint32_t> doorTests;
+    std::vector<uint8_t> overdraw;    // per frame pixel, row-major, saturating at 255
+    DiagnosticTotals last;            // of the last counted frame
+    bool counted = false;             // whether any frame has been counted yet
+
+    // Sizes and clears the counters for a frame of `viewCount` viewports.
+    void begin(int frameWidth, int frameHeight, const SDL_Rect* views, int viewCount);
+    // Sums the frame's counters into `last`.
+    void finish();
+};
+
+// Colours the row-major target by the chosen counter: blue for little work through green and yellow to red
+// for the frame's worst. Overdraw uses a fixed scale, one step per extra write.
+void drawDiagnosticOverlay(const RenderDiagnostics& diag, DiagOverlay overlay, const FrameTarget& target);
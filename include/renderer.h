@@ -1,8 +1,51 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "game_types.h"
 #include "console.h"
+#include "entities.h"
+#include "lighting.h"
+#include "pvs.h"
+#include "render_context.h"
 
-void renderFrame(const Map& map, const std::vector<Door>& doors, const std::vector<Sprite>& sprites, const Player& player, const Config& cfg, SDL_Renderer* renderer, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps);
+// ARGB8888 pixel destination for the 3D view. Pixel (x, y) is pixels[y * pitch + x * step]: a row-major
+// target has step 1, a column-major one (see framebuffer.h) pitch 1 and step = column length.
+struct FrameTarget {
+    Uint32* pixels;
+    int width;
+    int height;
+    int pitch;
+    int step = 1;
+};
+
+// One camera drawn into a sub-rectangle of a shared frame (split-screen players, spectators).
+struct RenderView {
+    Player camera;
+    SDL_Rect viewport;
+    const VisibleRegions* visible = nullptr;
+};
+
+// With a visible set, sprites in regions outside it are skipped and the minimap shows only what is in view.
+// With a lightmap and cfg.lighting, walls and sprites take one baked light level per column.
+void renderWorld(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const VisibleRegions* visible = nullptr, const Lightmap* lightmap = nullptr);
+// One-off renders (tools, offline frames); allocates its own scratch.
+void renderWorld(const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const VisibleRegions* visible = nullptr, const Lightmap* lightmap = nullptr);
+// Renders every view in one pass: the columns of all viewports are scheduled together on rc.pool.
+void renderViews(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const RenderView* views, int viewCount, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const Lightmap* lightmap = nullptr);
+void renderFrame(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const SDLContext& ctx, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps, const VisibleRegions* visible = nullptr, const Lightmap* lightmap = nullptr);
+// Split-screen variant. Viewports are in frame-texture pixels (ctx.frameWidth x ctx.frameHeight); the minimap
+// follows views[0].
+void renderFrame(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const RenderView* views, int viewCount, const Config& cfg, const SDLContext& ctx, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps, const Lightmap* lightmap = nullptr);
+
+// wall_height, r_textures, r_lighting, r_spans, r_culling and r_column_major, bound to cfg.
+void registerRendererCvars(ConsoleState& console, Config& cfg);
+// alloc_stats and diag_stats on `rc`'s last frame, splitscreen (into `splitViews`), and r_threads (stored in
+// `threads`): a count above 0 renders on `pool`, a private pool of that many threads, 0 on workerPool() again.
+void registerRenderContextCommands(ConsoleState& console, RenderContext& rc, const Config& cfg, int& splitViews, int& threads, std::unique_ptr<ThreadPool>& pool);
+
+// Tiles a width x height frame into 1, 2 (stacked) or 4 (quadrant) viewports; returns how many were written.
+int splitScreenLayout(int width, int height, int views, SDL_Rect* out);
+// Rescales the camera plane so a viewport with a different aspect ratio keeps the full frame's proportions.
+Player cameraForViewport(const Player& camera, int fullWidth, int fullHeight, const SDL_Rect& viewport);
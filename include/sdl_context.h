@@ -2,5 +2,11 @@
 
 #include "game_types.h"
 
+struct ConsoleState;
+
 bool initSDL(SDLContext& ctx, const Config& cfg);
+// Replaces the 3D view's streaming texture; the old one is kept if creation fails.
+bool resizeFrameTexture(SDLContext& ctx, int width, int height);
 void shutdownSDL(SDLContext& ctx);
+// r_scale: resizes the 3D view to the window size times cfg.renderScale.
+void registerDisplayCvars(ConsoleState& console, SDLContext& ctx, Config& cfg);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game_types.h"
+#include "pvs.h"
+
+// Ticks a client may fall behind on acks before it is sent a full snapshot again.
+const int SNAPSHOT_HISTORY = 32;
+const size_t MAX_SNAPSHOT_BYTES = 65536;
+
+// One end of a local datagram link standing in for the network (AF_UNIX socketpair, loopback UDP on Windows).
+using SocketHandle = std::intptr_t;
+const SocketHandle INVALID_SOCKET_HANDLE = -1;
+
+// Raises the open-file limit so `clients` links fit, two descriptors each. False, with the reason on stderr, when
+// the hard limit is too low; always true on Windows.
+bool reserveClientLinks(int clients);
+
+// Replicated player state, quantised: position in 1/256 cell, facing in 1/65536 turn.
+struct NetPlayer {
+    Sint32 x = 0;
+    Sint32 y = 0;
+    Uint16 angle = 0;
+    bool present = false; // false (and zeroed) when outside the receiving client's visible set
+};
+
+// What one client was sent for one tick. Door openness is quantised to 1/255.
+struct WorldSnapshot {
+    Uint32 tick = 0;
+    std::vector<NetPlayer> players;
+    std::vector<Uint8> doors;
+};
+
+// Appends `current` encoded against `baseline`; only changed players and doors are written, as varint deltas.
+// A null baseline produces a full snapshot.
+void encodeSnapshot(const WorldSnapshot& current, const WorldSnapshot* baseline, std::vector<Uint8>& out);
+// baselineTick is 0 for a full snapshot.
+bool readSnapshotHeader(const Uint8* data, size_t size, Uint32& tick, Uint32& baselineTick);
+bool decodeSnapshot(const Uint8* data, size_t size, const WorldSnapshot* baseline, WorldSnapshot& out);
+
+struct ServerStats {
+    Uint64 ticks = 0;
+    Uint64 snapshots = 0;
+    Uint64 fullSnapshots = 0;    // sent without a usable acked baseline
+    Uint64 droppedSnapshots = 0; // client's receive queue was full
+    Uint64 snapshotBytes = 0;
+    double lastTickMs = 0.0;
+};
+
+// Authoritative world without video. Every client sends {ack tick, buttons} datagrams and is answered each
+// tick with a snapshot delta-compressed against the last tick it acknowledged.
+class SimulationServer {
+public:
+    SimulationServer(Map map, const Config& cfg);
+    ~SimulationServer();
+    SimulationServer(const SimulationServer&) = delete;
+    SimulationServer& operator=(const SimulationServer&) = delete;
+
+    // Adds a player and returns the client's end of its link, or INVALID_SOCKET_HANDLE.
+    SocketHandle connectClient(const Player& spawn);
+    void tick(double dt);
+
+    Uint32 currentTick() const { return tick_; }
+    const Map& map() const { return map_; }
+    const std::vector<Door>& doors() const { return doors_; }
+    const std::vector<Player>& players() const { return players_; }
+    // The snapshot last sent to client `index`, for checking what the client rebuilt.
+    const WorldSnapshot& lastSent(size_t index) const;
+    const ServerStats& stats() const { return stats_; }
+
+private:
+    struct Client {
+        SocketHandle socket = INVALID_SOCKET_HANDLE;
+        Uint8 buttons = 0;
+        Uint8 previousButtons = 0;
+        Uint32 ackTick = 0;
+        std::vector<WorldSnapshot> sent; // ring indexed by tick % SNAPSHOT_HISTORY
+        VisibleRegions visible;
+        std::vector<Uint8> packet;
+        ServerStats counters;
+    };
+
+    void receiveInput(Client& client);
+    void sendSnapshot(Client& client, const Player& player);
+
+    Map map_;
+    Config cfg_;
+    std::vector<Door> doors_;
+    PvsData pvs_;
+    std::vector<Player> players_;
+    std::vector<std::unique_ptr<Client>> clients_;
+    std::vector<NetPlayer> quantisedPlayers_;
+    std::vector<Uint8> quantisedDoors_;
+    Uint32 tick_ = 0;
+    ServerStats stats_;
+};
+
+// Client end: sends input with an ack of the newest snapshot it holds, and rebuilds the world from deltas.
+class SnapshotClient {
+public:
+    explicit SnapshotClient(SocketHandle socket);
+    ~SnapshotClient();
+    SnapshotClient(const SnapshotClient&) = delete;
+    SnapshotClient& operator=(const SnapshotClient&) = delete;
+
+    bool sendInput(Uint8 buttons);
+    // Applies every queued snapshot; returns how many were decoded.
+    int receive();
+
+    const WorldSnapshot& latest() const { return history_[latestTick_ % SNAPSHOT_HISTORY]; }
+    Uint32 latestTick() const { return latestTick_; }
+    Uint64 bytesReceived() const { return bytesReceived_; }
+    Uint64 undecodable() const { return undecodable_; }
+
+private:
+    SocketHandle socket_;
+    std::vector<WorldSnapshot> history_;
+    std::vector<Uint8> buffer_;
+    Uint32 latestTick_ = 0;
+    Uint64 bytesReceived_ = 0;
+    Uint64 undecodable_ = 0; // malformed, or the baseline had already left the history
+};
+
+// Deterministic wandering input for simulated clients.
+Uint8 scriptedBotInput(int bot, Uint32 tick);
+// Players start spread across the map's rooms.
+Player botSpawn(const Map& map, int bot);
+
+// Headless mode: a server and simulated clients on local links.
+// args: --server [--players n] [--seconds s] [--tick-rate hz] [--seed n]
+int runServer(const std::vector<std::string>& args);
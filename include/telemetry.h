@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game_types.h"
+
+struct ConsoleState;
+
+// Single-producer single-consumer ring: one thread pushes, one other thread pops, neither ever waits.
+// push fails when the ring is full, pop when it is empty.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // Producer side: slots push can still fill. Only grows while the producer is not pushing.
+    size_t freeSlots() const { return Capacity - (tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire)); }
+
+private:
+    std::array<T, Capacity> items_{};
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// One frame as the telemetry stream reports it.
+struct FrameMetrics {
+    Uint32 frame = 0;
+    float frameMs = 0.0f;  // since the previous frame
+    float simMs = 0.0f;    // input, doors, entities, collision, visibility
+    float viewsMs = 0.0f;  // 3D views (RenderContext::lastViewsMs)
+    float renderMs = 0.0f; // all of renderFrame, overlays and present included
+    Uint32 rays = 0;
+    Uint32 sprites = 0;     // projected into the views
+    Uint32 doorsActive = 0; // not fully closed
+    Uint32 entities = 0;
+    Uint32 allocations = 0; // heap allocations renderFrame made (RenderContext::lastFrameAllocations)
+    Uint32 allocBytes = 0;
+};
+
+// A command or reply line with the connection it belongs to.
+struct TelemetryLine {
+    int client = 0;
+    std::array<char, 248> text{};
+};
+
+struct TelemetryStats {
+    size_t clients = 0;
+    Uint64 framesSent = 0;     // frame lines written, summed over clients
+    Uint64 framesDropped = 0;  // full ring, or a client too slow to take the line whole
+    Uint64 commands = 0;
+    Uint64 commandsDropped = 0;
+    Uint64 repliesDropped = 0; // command output lines that did not fit the reply ring
+};
+
+// Opt-in local metrics endpoint on a Unix-domain stream socket. Connected clients receive one text line per
+// frame:
+//   F <frame> <frame_ms> <sim_ms> <views_ms> <render_ms> <rays> <sprites> <doors_active> <entities> <allocs> <alloc_bytes>
+// and may send console commands, one per line; the output of each comes back as "R <line>" lines and always
+// ends with "R .", after "R truncated <n> lines" when it did not fit. `telemetry off` and `telemetry <path>` are refused from
+// clients. The frame loop only touches lock-free rings: a slow or stalled reader loses lines, it never
+// holds up a frame. Not available on Windows.
+class TelemetryServer {
+public:
+    TelemetryServer() = default;
+    ~TelemetryServer();
+    TelemetryServer(const TelemetryServer&) = delete;
+    TelemetryServer& operator=(const TelemetryServer&) = delete;
+
+    // Binds `path` and starts the I/O thread. A socket file already at `path` is replaced; any other file
+    // there is left alone and start fails. False, with the reason on stderr, if the socket cannot be set up.
+    bool start(const std::string& path);
+    // Closes every connection and empties the queues, so nothing queued reaches a later client.
+    void stop();
+    bool running() const { return thread_.joinable(); }
+    const std::string& path() const { return path_; }
+
+    // Frame loop side. publish never blocks; a full ring drops the frame.
+    void publish(const FrameMetrics& metrics);
+    // Runs `execute` for each command received since the last call and sends its output back. Commands wait
+    // in their queue while the reply ring has no room for a terminator.
+    void runCommands(const std::function<std::vector<std::string>(const std::string& command)>& execute);
+    // True while runCommands is executing a client's command. Commands that would stop this server check it,
+    // because the sender would lose its reply.
+    bool runningCommand() const { return runningCommand_; }
+    TelemetryStats stats() const;
+
+private:
+    struct Client;
+    void ioLoop();
+
+    std::string path_;
+    int listenFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    SpscRing<FrameMetrics, 1024> frames_;
+    SpscRing<TelemetryLine, 64> commands_; // I/O thread to frame loop
+    SpscRing<TelemetryLine, 256> replies_; // frame loop to I/O thread
+    std::atomic<size_t> clients_{0};
+    std::atomic<Uint64> framesSent_{0};
+    std::atomic<Uint64> framesDropped_{0};
+    std::atomic<Uint64> commandsRun_{0};
+    std::atomic<Uint64> commandsDropped_{0};
+    std::atomic<Uint64> repliesDropped_{0};
+    int nextClientId_ = 1; // I/O thread only; not reset by stop, so ids never repeat
+    bool runningCommand_ = false; // frame loop only
+};
+
+// telemetry [socket path|off]: starts, stops or reports on `telemetry`.
+void registerTelemetryCommands(ConsoleState& console, TelemetryServer& telemetry);
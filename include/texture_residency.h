@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "assets.h"
+#include "game_types.h"
+
+struct ConsoleState;
+
+struct TextureResidencyStats {
+    size_t hits = 0;        // textures drawn at full resolution, counted once per frame each
+    size_t misses = 0;      // textures drawn with their placeholder, counted once per frame each
+    size_t loads = 0;       // full chains read back and installed
+    size_t evictions = 0;
+    size_t failedLoads = 0;
+    double loadMs = 0.0;    // summed loader time
+    size_t residentBytes = 0;
+    size_t peakBytes = 0;
+    size_t placeholderBytes = 0;
+    int resident = 0;       // wall textures currently at full resolution
+    int managed = 0;        // wall textures with a placeholder
+    int pending = 0;        // requested and not installed yet
+};
+
+// Keeps wall textures at full resolution only while they are in use, within a byte budget. Every wall
+// starts as a small placeholder (the tail of its mip chain from 8x8 down); a tile id the DDA hits is read
+// back from the texture cache archive on a loader thread and swapped in at the next frame boundary, and
+// the least recently used textures not drawn that frame are dropped back to placeholders when the budget
+// is exceeded. A working set larger than the budget overshoots it rather than thrashing.
+//
+// While attached, the manager's wall surfaces and chains belong to this class; sprites are untouched.
+class TextureResidency {
+public:
+    TextureResidency(TextureManager& tm, size_t budgetBytes);
+    // Detaches and frees every wall level it owns; call before freeTextures.
+    ~TextureResidency();
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    // Swaps the walls for placeholders. Needs a valid cache archive for the manifest; false (and nothing
+    // changed) without one.
+    bool attach(const std::string& manifestPath, const std::string& cachePath);
+    bool attached() const { return attached_; }
+
+    // Called by column workers for every wall they texture. Lock-free; repeated marks are plain reads.
+    void markUsed(int wallId) {
+        if (wallId >= 0 && wallId < static_cast<int>(slots_.size()) && !used_[wallId].load(std::memory_order_relaxed)) {
+            used_[wallId].store(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Between frames, on the render thread: installs finished loads, requests the walls the last frame
+    // hit, and evicts down to the budget.
+    void update();
+    void setBudget(size_t budgetBytes) { budget_ = budgetBytes; }
+    size_t budget() const { return budget_; }
+    TextureResidencyStats stats() const;
+
+private:
+    struct Slot {
+        bool managed = false;
+        std::vector<SDL_Surface*> placeholder;
+        std::vector<SDL_Surface*> full; // installed in the manager while resident
+        std::vector<TextureArchiveLevel> levels;
+        size_t bytes = 0;               // of the full chain
+        bool loading = false;
+        bool failed = false;            // unreadable archive entry; stays a placeholder
+        Uint64 lastUse = 0;
+    };
+    struct Loaded {
+        int id;
+        std::vector<SDL_Surface*> chain;
+        double ms;
+    };
+
+    void loaderLoop(std::string cachePath);
+    void install(int id, std::vector<SDL_Surface*> chain);
+    void evict(int id);
+
+    TextureManager& tm_;
+    size_t budget_;
+    bool attached_ = false;
+    std::vector<Slot> slots_;
+    std::unique_ptr<std::atomic<Uint8>[]> used_;
+    Uint64 frame_ = 0;
+    TextureResidencyStats stats_;
+
+    std::mutex mutex_;
+    std::condition_variable requested_;
+    std::deque<int> requests_;
+    std::vector<Loaded> loaded_;
+    bool stopping_ = false;
+    std::thread loader_;
+};
+
+// tex_budget_mb (stored in `budgetMb`) and tex_stats. `residency` is null when there is no texture cache to page from.
+void registerTextureResidencyCommands(ConsoleState& console, TextureResidency* residency, int& budgetMb);
@@ -1,8 +1,24 @@
 #pragma once
 
+#include <ostream>
+#include <string>
+#include <vector>
+
 #include "game_types.h"
 
+const char* const TEXTURE_MANIFEST_PATH = "resources/textures/manifest.txt";
+const char* const TEXTURE_CACHE_PATH = "resources/textures/textures.cache";
+
 TextureManager loadTextures();
+TextureManager loadTextures(const std::string& manifestPath, const std::string& cachePath);
+void printAssetLoadReport(std::ostream& out, const AssetLoadStats& stats);
 void freeTextures(TextureManager& tm);
+std::vector<SDL_Surface*> buildMipChain(SDL_Surface* base, bool colorKeyed);
+void rebuildMipChains(TextureManager& tm);
+int selectMipLevel(double texelsPerPixel, int levelCount);
 Color sampleTexture(SDL_Surface* surf, int x, int y);
 Uint32 sampleTextureRaw(SDL_Surface* surf, int x, int y);
+// Procedural 64x64 checker so tools still exercise texture sampling without assets on disk.
+SDL_Surface* makeCheckerSurface(int seed, bool colorKeyed);
+// Replaces every texture the manifest names but that failed to load with a checker.
+void fillMissingTextures(TextureManager& tm);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads shared by every parallel subsystem.
+// parallelFor does not allocate, so it is safe to call from per-frame code.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned workerCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Workers plus the calling thread, which always helps with parallelFor.
+    unsigned concurrency() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Runs fn(begin, end) over [0, count) in chunks of `grain` and returns when all are done.
+    // Calls made from inside any chunk (worker or caller) run inline to avoid deadlocking the pool.
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        using F = std::remove_reference_t<Fn>;
+        runRange(count, grain, [](void* ctx, size_t begin, size_t end) { (*static_cast<F*>(ctx))(begin, end); },
+                 const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+    }
+
+    // Queues a fire-and-forget task for a worker.
+    void submit(std::function<void()> task);
+
+private:
+    using RangeFn = void (*)(void* ctx, size_t begin, size_t end);
+    struct Job {
+        RangeFn fn = nullptr;
+        void* ctx = nullptr;
+        size_t count = 0;
+        size_t grain = 1;
+        size_t chunks = 0;
+        bool countAllocations = false; // the caller is in an AllocationCountScope; workers count its chunks too
+    };
+
+    void runRange(size_t count, size_t grain, RangeFn fn, void* ctx);
+    void runChunks(const Job& job);
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::mutex jobMutex_; // serialises parallelFor callers
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable doneCv_;
+    Job job_;
+    unsigned long long jobGeneration_ = 0;
+    unsigned activeWorkers_ = 0;
+    std::atomic<size_t> nextChunk_{0};
+    std::atomic<size_t> pendingChunks_{0};
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+};
+
+// Process-wide pool sized to the hardware thread count.
+ThreadPool& workerPool();
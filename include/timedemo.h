@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "camera_path.h"
+#include "console.h"
+#include "game_types.h"
+
+struct Level;
+
+// Simulation step used for doors and entities while a demo runs, so every run sees the same world.
+constexpr double TIMEDEMO_STEP = 1.0 / 60.0;
+
+struct TimedemoResult {
+    size_t frames = 0;
+    double totalMs = 0.0;
+    double avgFps = 0.0;
+    double minFps = 0.0;
+    double low1Fps = 0.0; // mean fps over the slowest 1% of frames
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+struct TimedemoRun {
+    bool active = false;
+    CameraPath path;
+    size_t frame = 0;
+    std::vector<double> frameMs;
+    Uint64 lastCounter = 0;
+    std::string name;
+    std::string reportFile;
+    Player restorePose{}; // where the player was when the run started; put back when it ends or is aborted
+};
+
+// demo_record and demo_stop state: while active, the frame loop appends the player's pose every frame.
+struct CameraRecording {
+    CameraPath path;
+    bool active = false;
+};
+
+// Takes over the camera and turns vsync off until the run finishes or is aborted.
+void startTimedemo(TimedemoRun& run, CameraPath path, const std::string& name, const std::string& reportFile, SDL_Renderer* renderer);
+// Call once per frame before rendering; poses the player and returns false once every frame has been timed.
+bool advanceTimedemo(TimedemoRun& run, Player& player);
+// Restores vsync, prints the result to the console and appends it to the report file.
+void finishTimedemo(TimedemoRun& run, ConsoleState& console, SDL_Renderer* renderer, bool aborted);
+TimedemoResult summarizeFrameTimes(std::vector<double> frameMs);
+// timedemo flies a path over whatever `level` holds, doors reset first, and remembers `player` to restore
+// afterwards; demo_record and demo_stop fill and save `recording`.
+void registerTimedemoCommands(ConsoleState& console, TimedemoRun& demo, CameraRecording& recording, std::unique_ptr<Level>& level, Player& player, SDL_Renderer* renderer);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include "game_types.h"
+
+class ThreadPool;
+
+struct LosQuery {
+    double fromX;
+    double fromY;
+    double toX;
+    double toY;
+};
+
+// True when nothing solid lies on the segment; partially open doors block only where their slab is.
+bool hasLineOfSight(const Map& map, const std::vector<Door>& doors, double fromX, double fromY, double toX, double toY);
+// Answers a batch across the worker pool; results[i] is 1 when query i is unobstructed.
+void queryLineOfSight(const Map& map, const std::vector<Door>& doors, const std::vector<LosQuery>& queries, std::vector<Uint8>& results);
+void queryLineOfSight(const Map& map, const std::vector<Door>& doors, const std::vector<LosQuery>& queries, std::vector<Uint8>& results, ThreadPool& pool);
@@ -1,75 +1,166 @@
 #include "input.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include "collision.h"
+#include "console.h"
 #include "doors.h"
 
 namespace {
-bool isWalkable(double x, double y, const Map& map, const std::vector<Door>& doors) {
-    int cellX = static_cast<int>(x);
-    int cellY = static_cast<int>(y);
-    int tile = map.at(cellX, cellY);
-    if (tile == 0) {
-        return true;
+void rotatePlayer(Player& player, double angle) {
+    double oldDirX = player.dirX;
+    player.dirX = player.dirX * std::cos(angle) - player.dirY * std::sin(angle);
+    player.dirY = oldDirX * std::sin(angle) + player.dirY * std::cos(angle);
+    double oldPlaneX = player.planeX;
+    player.planeX = player.planeX * std::cos(angle) - player.planeY * std::sin(angle);
+    player.planeY = oldPlaneX * std::sin(angle) + player.planeY * std::cos(angle);
+}
+} // namespace
+
+Uint8 inputFromKeys(const Uint8* keystate) {
+    Uint8 buttons = 0;
+    if (keystate[SDL_SCANCODE_W] || keystate[SDL_SCANCODE_UP]) buttons |= INPUT_FORWARD;
+    if (keystate[SDL_SCANCODE_S] || keystate[SDL_SCANCODE_DOWN]) buttons |= INPUT_BACK;
+    if (keystate[SDL_SCANCODE_A] || keystate[SDL_SCANCODE_LEFT]) buttons |= INPUT_TURN_LEFT;
+    if (keystate[SDL_SCANCODE_D] || keystate[SDL_SCANCODE_RIGHT]) buttons |= INPUT_TURN_RIGHT;
+    if (keystate[SDL_SCANCODE_LSHIFT] || keystate[SDL_SCANCODE_RSHIFT]) buttons |= INPUT_SPRINT;
+    if (keystate[SDL_SCANCODE_SPACE]) buttons |= INPUT_USE;
+    return buttons;
+}
+
+void setMouseCaptured(MouseLook& look, const Config& cfg, bool captured) {
+    bool relative = cfg.mouseLook && captured;
+    if (relative == look.relative) {
+        return;
     }
-    if (tile == DOOR_TILE) {
-        const Door* door = findDoor(doors, cellX, cellY);
-        return door && door->openAmount > 0.8;
+    SDL_SetRelativeMouseMode(relative ? SDL_TRUE : SDL_FALSE);
+    look.relative = relative;
+    look.pendingX = 0;
+    look.pending = false;
+}
+
+void accumulateMouseMotion(MouseLook& look, const SDL_Event& e) {
+    if (e.type != SDL_MOUSEMOTION || !look.relative) {
+        return;
     }
-    return false;
+    if (!look.pending) {
+        look.oldestEvent = e.motion.timestamp;
+        look.pending = true;
+    }
+    look.pendingX += e.motion.xrel;
+}
+
+void applyMouseLook(MouseLook& look, Player& player, const Config& cfg) {
+    if (!look.relative) {
+        return;
+    }
+    // Motion that arrived while this frame simulated; everything else stays queued for the next poll.
+    SDL_PumpEvents();
+    SDL_Event events[64];
+    int count;
+    while ((count = SDL_PeepEvents(events, 64, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION)) > 0) {
+        for (int i = 0; i < count; ++i) {
+            accumulateMouseMotion(look, events[i]);
+        }
+    }
+    if (!look.pending) {
+        return;
+    }
+    // One rotation by the summed delta; rightward motion turns right like INPUT_TURN_RIGHT.
+    rotatePlayer(player, -look.pendingX * cfg.mouseSensitivity);
+    look.applied = true;
+    look.appliedEvent = look.oldestEvent;
+    look.appliedCounter = SDL_GetPerformanceCounter();
+    look.pendingX = 0;
+    look.pending = false;
+}
+
+void finishMouseLookFrame(MouseLook& look) {
+    if (!look.applied) {
+        return;
+    }
+    look.applied = false;
+    size_t slot = look.samples % look.eventToPresentMs.size();
+    look.eventToPresentMs[slot] = static_cast<float>(SDL_GetTicks() - look.appliedEvent);
+    look.applyToPresentMs[slot] = static_cast<float>((SDL_GetPerformanceCounter() - look.appliedCounter) * 1000.0 / SDL_GetPerformanceFrequency());
+    ++look.samples;
+}
+
+MouseLatencyStats mouseLatencyStats(const MouseLook& look) {
+    MouseLatencyStats stats;
+    stats.samples = std::min(look.samples, look.eventToPresentMs.size());
+    if (stats.samples == 0) {
+        return stats;
+    }
+    std::array<float, 256> sorted = look.eventToPresentMs;
+    std::sort(sorted.begin(), sorted.begin() + stats.samples);
+    for (size_t i = 0; i < stats.samples; ++i) {
+        stats.eventMeanMs += look.eventToPresentMs[i];
+        stats.applyMeanMs += look.applyToPresentMs[i];
+        stats.applyMaxMs = std::max(stats.applyMaxMs, static_cast<double>(look.applyToPresentMs[i]));
+    }
+    stats.eventMeanMs /= stats.samples;
+    stats.applyMeanMs /= stats.samples;
+    stats.eventP95Ms = sorted[(stats.samples - 1) * 95 / 100];
+    stats.eventMaxMs = sorted[stats.samples - 1];
+    return stats;
 }
-} // namespace
 
-void handleInput(const Uint8* keystate, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt) {
+void applyPlayerInput(Uint8 buttons, Uint8& previousButtons, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt, const CollisionGrid* grid) {
     double moveStep = cfg.moveSpeed * dt;
     double rotStep = cfg.rotSpeed * dt;
 
-    if (keystate[SDL_SCANCODE_LSHIFT] || keystate[SDL_SCANCODE_RSHIFT]) {
+    if (buttons & INPUT_SPRINT) {
         moveStep = cfg.moveSpeedSprint * dt;
     }
-    if (keystate[SDL_SCANCODE_W] || keystate[SDL_SCANCODE_UP]) {
-        double nextX = player.x + player.dirX * moveStep;
-        double nextY = player.y + player.dirY * moveStep;
-        if (isWalkable(nextX, player.y, map, doors)) {
-            player.x = nextX;
-        }
-        if (isWalkable(player.x, nextY, map, doors)) {
-            player.y = nextY;
-        }
+    double direction = ((buttons & INPUT_FORWARD) ? 1.0 : 0.0) - ((buttons & INPUT_BACK) ? 1.0 : 0.0);
+    if (direction != 0.0) {
+        CircleMove move = moveCircle(map, doors, grid, player.x, player.y, PLAYER_RADIUS, player.dirX * moveStep * direction, player.dirY * moveStep * direction);
+        player.x = move.x;
+        player.y = move.y;
     }
-    if (keystate[SDL_SCANCODE_S] || keystate[SDL_SCANCODE_DOWN]) {
-        double nextX = player.x - player.dirX * moveStep;
-        double nextY = player.y - player.dirY * moveStep;
-        if (isWalkable(nextX, player.y, map, doors)) {
-            player.x = nextX;
-        }
-        if (isWalkable(player.x, nextY, map, doors)) {
-            player.y = nextY;
-        }
+    if (buttons & INPUT_TURN_LEFT) {
+        rotatePlayer(player, rotStep);
     }
-    if (keystate[SDL_SCANCODE_A] || keystate[SDL_SCANCODE_LEFT]) {
-        double oldDirX = player.dirX;
-        player.dirX = player.dirX * std::cos(rotStep) - player.dirY * std::sin(rotStep);
-        player.dirY = oldDirX * std::sin(rotStep) + player.dirY * std::cos(rotStep);
-        double oldPlaneX = player.planeX;
-        player.planeX = player.planeX * std::cos(rotStep) - player.planeY * std::sin(rotStep);
-        player.planeY = oldPlaneX * std::sin(rotStep) + player.planeY * std::cos(rotStep);
+    if (buttons & INPUT_TURN_RIGHT) {
+        rotatePlayer(player, -rotStep);
     }
-    if (keystate[SDL_SCANCODE_D] || keystate[SDL_SCANCODE_RIGHT]) {
-        double oldDirX = player.dirX;
-        player.dirX = player.dirX * std::cos(-rotStep) - player.dirY * std::sin(-rotStep);
-        player.dirY = oldDirX * std::sin(-rotStep) + player.dirY * std::cos(-rotStep);
-        double oldPlaneX = player.planeX;
-        player.planeX = player.planeX * std::cos(-rotStep) - player.planeY * std::sin(-rotStep);
-        player.planeY = oldPlaneX * std::sin(-rotStep) + player.planeY * std::cos(-rotStep);
-    }
-    static bool wasSpaceDown = false;
-    bool isSpaceDown = keystate[SDL_SCANCODE_SPACE];
-    if (isSpaceDown && !wasSpaceDown) {
+    // Use toggles a door on the press only, not while held.
+    if ((buttons & INPUT_USE) && !(previousButtons & INPUT_USE)) {
         Door* target = doorInFront(player, map, doors);
         if (target) {
             target->targetOpen = !target->targetOpen;
         }
     }
-    wasSpaceDown = isSpaceDown;
+    previousButtons = buttons;
+}
+
+void handleInput(const Uint8* keystate, const Map& map, std::vector<Door>& doors, Player& player, const Config& cfg, double dt, const CollisionGrid* grid) {
+    static Uint8 previousButtons = 0;
+    applyPlayerInput(inputFromKeys(keystate), previousButtons, map, doors, player, cfg, dt, grid);
+}
+
+void registerInputCvars(ConsoleState& console, Config& cfg) {
+    registerCvar(console, "move_speed", &cfg.moveSpeed, 0.1, 50.0, "Walk speed in cells per second");
+    registerCvar(console, "sprint_speed", &cfg.moveSpeedSprint, 0.1, 50.0, "Sprint speed in cells per second");
+    registerCvar(console, "turn_speed", &cfg.rotSpeed, 0.1, 20.0, "Keyboard turn speed in radians per second");
+    registerCvar(console, "m_look", &cfg.mouseLook, "Turn with the mouse (relative mode) while the console is closed");
+    registerCvar(console, "m_sensitivity", &cfg.mouseSensitivity, 0.0001, 0.05, "Mouse turn in radians per count");
+}
+
+void registerInputCommands(ConsoleState& console, const MouseLook& mouseLook) {
+    registerConsoleCommand(console, "input_latency", "input_latency", "Mouse-look latency from motion event and from applying the turn to present", [&mouseLook](ConsoleState& con, const std::vector<std::string>&) {
+        MouseLatencyStats st = mouseLatencyStats(mouseLook);
+        if (st.samples == 0) {
+            consolePrint(con, "No mouse turns measured yet; close the console and move the mouse");
+            return;
+        }
+        char line[200];
+        std::snprintf(line, sizeof(line), "last %zu turns: event to present %.1f ms mean, %.1f p95, %.1f max", st.samples, st.eventMeanMs,
+                      st.eventP95Ms, st.eventMaxMs);
+        consolePrint(con, line);
+        std::snprintf(line, sizeof(line), "turn applied to present %.2f ms mean, %.2f max", st.applyMeanMs, st.applyMaxMs);
+        consolePrint(con, line);
+    });
 }
@@ -0,0 +1,193 @@
+#include "level.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "console.h"
+#include "doors.h"
+#include "map.h"
+#include "thread_pool.h"
+
+namespace {
+// Reads one byte per page of every surface the level can sample, mip levels included.
+size_t touchSurfaces(const std::vector<std::vector<SDL_Surface*>>& chains, const std::vector<bool>& used, volatile Uint8& sink) {
+    const size_t page = 4096;
+    size_t pages = 0;
+    for (size_t id = 0; id < chains.size() && id < used.size(); ++id) {
+        if (!used[id]) {
+            continue;
+        }
+        for (SDL_Surface* surf : chains[id]) {
+            if (!surf || !surf->pixels) {
+                continue;
+            }
+            const Uint8* bytes = static_cast<const Uint8*>(surf->pixels);
+            size_t size = static_cast<size_t>(surf->pitch) * surf->h;
+            for (size_t offset = 0; offset < size; offset += page) {
+                sink = static_cast<Uint8>(sink + bytes[offset]);
+                ++pages;
+            }
+        }
+    }
+    return pages;
+}
+} // namespace
+
+std::unique_ptr<Level> buildLevel(unsigned seed, const TextureManager& tm, ThreadPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    auto level = std::make_unique<Level>();
+    level->seed = seed;
+    level->map = createRandomMap(seed);
+    level->doors = extractDoors(level->map);
+    auto spawn = pickSpawnPoint(level->map);
+    level->spawn = Player{spawn.first, spawn.second, -1.0, 0.0, 0.0, 0.66};
+
+    std::vector<Sprite> sprites = createSprites(level->map, seed);
+    sprites.erase(std::remove_if(sprites.begin(), sprites.end(), [&](const Sprite& s) {
+                      double dx = s.x - spawn.first;
+                      double dy = s.y - spawn.second;
+                      return (dx * dx + dy * dy) < 4.0;
+                  }),
+                  sprites.end());
+    level->entities = entitiesFromSprites(sprites);
+    assignSpriteColliders(level->entities, level->map);
+    level->collision.reset(level->map.width, level->map.height);
+    level->collision.sync(level->entities);
+    level->pvs = buildPvs(level->map, level->doors, pool);
+    level->lightmap = bakeLightmap(level->map, level->doors, collectLights(level->entities), pool);
+
+    // Resident walls are the residency manager's business, and it swaps their chains between frames.
+    std::vector<bool> wallsUsed(tm.residency ? 0 : tm.textureMips.size(), false);
+    for (int tile : level->map.tiles) {
+        if (tile > 0 && tile < static_cast<int>(wallsUsed.size())) {
+            wallsUsed[tile] = true;
+        }
+    }
+    std::vector<bool> spritesUsed(tm.spriteMips.size(), false);
+    for (int id : level->entities.textureId) {
+        if (id >= 0 && id < static_cast<int>(spritesUsed.size())) {
+            spritesUsed[id] = true;
+        }
+    }
+    volatile Uint8 sink = 0;
+    level->texturePagesTouched = touchSurfaces(tm.textureMips, wallsUsed, sink) + touchSurfaces(tm.spriteMips, spritesUsed, sink);
+
+    level->buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return level;
+}
+
+LevelManager::~LevelManager() {
+    shutdown();
+}
+
+void LevelManager::shutdown() {
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    result_.reset();
+    if (retirer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(retireMutex_);
+            stopping_ = true;
+        }
+        retireReady_.notify_one();
+        retirer_.join();
+        stopping_ = false;
+    }
+}
+
+bool LevelManager::preload(unsigned seed, const TextureManager& tm) {
+    if (building()) {
+        return false;
+    }
+    if (loader_.joinable()) {
+        loader_.join();
+        retire(std::move(result_));
+    }
+    finished_.store(false);
+    pendingSeed_ = seed;
+    loader_ = std::thread([this, seed, &tm] {
+        // A private serial pool: the build must not queue parallelFor jobs ahead of the render's.
+        ThreadPool serial(0);
+        result_ = buildLevel(seed, tm, serial);
+        finished_.store(true);
+    });
+    return true;
+}
+
+std::unique_ptr<Level> LevelManager::takeReady() {
+    if (!ready()) {
+        return nullptr;
+    }
+    loader_.join();
+    return std::move(result_);
+}
+
+void LevelManager::retire(std::unique_ptr<Level> level) {
+    if (!level) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(retireMutex_);
+        retired_.push_back(std::move(level));
+    }
+    if (!retirer_.joinable()) {
+        retirer_ = std::thread([this] { retireLoop(); });
+    }
+    retireReady_.notify_one();
+}
+
+void LevelManager::retireLoop() {
+    std::unique_lock<std::mutex> lock(retireMutex_);
+    for (;;) {
+        retireReady_.wait(lock, [this] { return stopping_ || !retired_.empty(); });
+        std::vector<std::unique_ptr<Level>> batch;
+        batch.swap(retired_);
+        bool stop = stopping_;
+        lock.unlock();
+        batch.clear(); // the frees, outside the lock so retire never waits on them
+        lock.lock();
+        if (stop && retired_.empty()) {
+            return;
+        }
+    }
+}
+
+void registerLevelCommands(ConsoleState& console, std::unique_ptr<Level>& level, const VisibleRegions& visible, LevelManager& levels, const TextureManager& textures, bool& switchPending, bool& readyReported) {
+    registerConsoleCommand(console, "spawn_actors", "spawn_actors <n>", "Spawn n wandering actors", [&level](ConsoleState& con, const std::vector<std::string>& args) {
+        int count = args.size() >= 2 ? std::atoi(args[1].c_str()) : 0;
+        if (count <= 0) {
+            consolePrint(con, "Usage: spawn_actors <n>");
+            return;
+        }
+        spawnWanderers(level->entities, level->map, count, SDL_GetTicks());
+        consolePrint(con, std::to_string(level->entities.size()) + " entities");
+    });
+    registerConsoleCommand(console, "pvs_stats", "pvs_stats", "Show region count and current visible set", [&level, &visible](ConsoleState& con, const std::vector<std::string>&) {
+        std::string inView = visible.all ? "all" : std::to_string(visible.count);
+        consolePrint(con, std::to_string(level->pvs.regionCount) + " regions, " + inView + " potentially visible, built in " +
+                              std::to_string(static_cast<int>(level->pvs.buildMs)) + " ms");
+    });
+    registerConsoleCommand(console, "level_preload", "level_preload [seed]", "Build a level in the background; level_switch swaps it in", [&levels, &textures, &readyReported](ConsoleState& con, const std::vector<std::string>& args) {
+        unsigned seed = args.size() >= 2 ? static_cast<unsigned>(std::strtoul(args[1].c_str(), nullptr, 10)) : std::random_device{}();
+        if (!levels.preload(seed, textures)) {
+            consolePrint(con, "Still building level " + std::to_string(levels.pendingSeed()));
+            return;
+        }
+        readyReported = false;
+        consolePrint(con, "Building level " + std::to_string(seed));
+    });
+    registerConsoleCommand(console, "level_switch", "level_switch", "Swap in the preloaded level at the next frame", [&levels, &switchPending](ConsoleState& con, const std::vector<std::string>&) {
+        if (!levels.building() && !levels.ready()) {
+            consolePrint(con, "Nothing preloaded; level_preload first");
+            return;
+        }
+        switchPending = true;
+        if (levels.building()) {
+            consolePrint(con, "Switching once level " + std::to_string(levels.pendingSeed()) + " is built");
+        }
+    });
+}
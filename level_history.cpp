@@ -0,0 +1,187 @@
+#include "level_history.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "console.h"
+#include "level.h"
+
+namespace {
+bool sameDoor(const Door& a, const Door& b) {
+    return a.x == b.x && a.y == b.y && a.vertical == b.vertical && a.targetOpen == b.targetOpen &&
+           std::memcmp(&a.openAmount, &b.openAmount, sizeof(double)) == 0 &&
+           std::memcmp(&a.timeFullyOpen, &b.timeFullyOpen, sizeof(double)) == 0;
+}
+
+template <typename T, size_t Chunk>
+void addUnique(const CowArray<T, Chunk>& array, std::unordered_set<const void*>& seen, size_t& bytes) {
+    for (const auto& chunk : array.chunks()) {
+        if (seen.insert(chunk.get()).second) {
+            bytes += chunk->size() * sizeof(T);
+        }
+    }
+}
+} // namespace
+
+LevelHistory::LevelHistory(double seconds, double interval) : interval_(interval) {
+    setLength(seconds);
+}
+
+void LevelHistory::record(const Level& level, const Player& player, double time) {
+    if (count_ > 0 && at(0).seed != level.seed) {
+        clear();
+    }
+    if (count_ > 0 && time - at(0).time < interval_) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    const LevelSnapshot* prev = count_ > 0 ? &at(0) : nullptr;
+    size_t slot = count_ > 0 ? (head_ + 1) % ring_.size() : head_;
+    LevelSnapshot& snap = ring_[slot];
+    CowCaptureStats stats;
+    const EntityStore& e = level.entities;
+    snap.tiles.capture(level.map.tiles, prev ? &prev->tiles : nullptr, stats);
+    snap.doors.capture(level.doors, prev ? &prev->doors : nullptr, stats, sameDoor);
+    snap.x.capture(e.x, prev ? &prev->x : nullptr, stats);
+    snap.y.capture(e.y, prev ? &prev->y : nullptr, stats);
+    snap.velX.capture(e.velX, prev ? &prev->velX : nullptr, stats);
+    snap.velY.capture(e.velY, prev ? &prev->velY : nullptr, stats);
+    snap.textureId.capture(e.textureId, prev ? &prev->textureId : nullptr, stats);
+    snap.animTime.capture(e.animTime, prev ? &prev->animTime : nullptr, stats);
+    snap.rngState.capture(e.rngState, prev ? &prev->rngState : nullptr, stats);
+    snap.flags.capture(e.flags, prev ? &prev->flags : nullptr, stats);
+    snap.radius.capture(e.radius, prev ? &prev->radius : nullptr, stats);
+    snap.time = time;
+    snap.seed = level.seed;
+    snap.player = player;
+    head_ = slot;
+    count_ = std::min(count_ + 1, ring_.size());
+
+    lastCaptureUs_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    captureUsTotal_ += lastCaptureUs_;
+    ++captures_;
+    last_ = stats;
+}
+
+bool LevelHistory::rewind(double seconds, Level& level, Player& player, double& time) {
+    if (count_ == 0 || at(0).seed != level.seed) {
+        return false;
+    }
+    double target = at(0).time - seconds;
+    size_t age = 0;
+    while (age + 1 < count_ && at(age).time > target) {
+        ++age;
+    }
+    const LevelSnapshot& snap = at(age);
+    EntityStore& e = level.entities;
+    snap.tiles.restore(level.map.tiles);
+    snap.doors.restore(level.doors);
+    snap.x.restore(e.x);
+    snap.y.restore(e.y);
+    snap.velX.restore(e.velX);
+    snap.velY.restore(e.velY);
+    snap.textureId.restore(e.textureId);
+    snap.animTime.restore(e.animTime);
+    snap.rngState.restore(e.rngState);
+    snap.flags.restore(e.flags);
+    snap.radius.restore(e.radius);
+    player = snap.player;
+    time = snap.time;
+    // Entities may have been added since, so the grid is rebuilt rather than synced.
+    level.collision.reset(level.map.width, level.map.height);
+    level.collision.sync(level.entities);
+
+    head_ = (head_ + ring_.size() - age) % ring_.size();
+    count_ -= age;
+    return true;
+}
+
+void LevelHistory::clear() {
+    for (LevelSnapshot& snap : ring_) {
+        snap = LevelSnapshot{};
+    }
+    head_ = 0;
+    count_ = 0;
+}
+
+void LevelHistory::setLength(double seconds) {
+    size_t capacity = static_cast<size_t>(std::ceil(std::max(seconds, interval_) / std::max(interval_, 1e-3))) + 1;
+    std::vector<LevelSnapshot> ring(capacity);
+    size_t kept = std::min(count_, capacity);
+    for (size_t age = 0; age < kept; ++age) {
+        ring[kept - 1 - age] = at(age);
+    }
+    ring_ = std::move(ring);
+    count_ = kept;
+    head_ = kept > 0 ? kept - 1 : 0;
+}
+
+LevelHistoryStats LevelHistory::stats() const {
+    LevelHistoryStats stats;
+    stats.snapshots = count_;
+    stats.seconds = count_ > 0 ? at(0).time - at(count_ - 1).time : 0.0;
+    stats.lastCaptureUs = lastCaptureUs_;
+    stats.avgCaptureUs = captures_ ? captureUsTotal_ / captures_ : 0.0;
+    stats.captures = captures_;
+    stats.last = last_;
+    std::unordered_set<const void*> seen;
+    for (size_t age = 0; age < count_; ++age) {
+        const LevelSnapshot& snap = at(age);
+        addUnique(snap.tiles, seen, stats.uniqueBytes);
+        addUnique(snap.doors, seen, stats.uniqueBytes);
+        addUnique(snap.x, seen, stats.uniqueBytes);
+        addUnique(snap.y, seen, stats.uniqueBytes);
+        addUnique(snap.velX, seen, stats.uniqueBytes);
+        addUnique(snap.velY, seen, stats.uniqueBytes);
+        addUnique(snap.textureId, seen, stats.uniqueBytes);
+        addUnique(snap.animTime, seen, stats.uniqueBytes);
+        addUnique(snap.rngState, seen, stats.uniqueBytes);
+        addUnique(snap.flags, seen, stats.uniqueBytes);
+        addUnique(snap.radius, seen, stats.uniqueBytes);
+    }
+    if (count_ > 0) {
+        const LevelSnapshot& snap = at(0);
+        size_t entities = snap.x.size();
+        stats.fullCopyBytes = snap.tiles.size() * sizeof(int) + snap.doors.size() * sizeof(Door) +
+                              entities * (4 * sizeof(double) + sizeof(int) + 2 * sizeof(float) + 2 * sizeof(Uint32));
+    }
+    return stats;
+}
+
+void registerLevelHistoryCommands(ConsoleState& console, LevelHistory& history, double& seconds, std::unique_ptr<Level>& level, Player& player, double& gameTime, const bool& paused) {
+    registerCvar(console, "history_seconds", &seconds, 1.0, 120.0, "Game seconds of level snapshots kept for rewind", [&history, &seconds](ConsoleState&) {
+        history.setLength(seconds);
+    });
+    registerConsoleCommand(console, "rewind", "rewind <seconds>", "Restore the level and player as they were that long ago", [&history, &level, &player, &gameTime, &paused](ConsoleState& con, const std::vector<std::string>& args) {
+        double seconds = args.size() >= 2 ? std::atof(args[1].c_str()) : 0.0;
+        if (seconds <= 0.0) {
+            consolePrint(con, "Usage: rewind <seconds>");
+            return;
+        }
+        if (paused) {
+            consolePrint(con, "Not during a timedemo");
+            return;
+        }
+        double before = gameTime;
+        if (!history.rewind(seconds, *level, player, gameTime)) {
+            consolePrint(con, "No history for this level yet");
+            return;
+        }
+        char line[120];
+        std::snprintf(line, sizeof(line), "Rewound %.2f s", before - gameTime);
+        consolePrint(con, line);
+    });
+    registerConsoleCommand(console, "snapshot_stats", "snapshot_stats", "Rewind history length, memory and per-capture cost", [&history](ConsoleState& con, const std::vector<std::string>&) {
+        LevelHistoryStats st = history.stats();
+        char line[200];
+        std::snprintf(line, sizeof(line), "%zu snapshots over %.1f s, %.1f KiB held (%.1f KiB each if copied in full)", st.snapshots, st.seconds,
+                      st.uniqueBytes / 1024.0, st.fullCopyBytes / 1024.0);
+        consolePrint(con, line);
+        std::snprintf(line, sizeof(line), "last capture %.1f us (avg %.1f us): %zu chunks copied (%.1f KiB), %zu shared", st.lastCaptureUs, st.avgCaptureUs,
+                      st.last.chunksCopied, st.last.bytesCopied / 1024.0, st.last.chunksShared);
+        consolePrint(con, line);
+    });
+}
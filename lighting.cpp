@@ -0,0 +1,166 @@
+#include "lighting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "thread_pool.h"
+#include "visibility.h"
+
+namespace {
+const double LIGHT_RADIUS = 7.0;
+const float AMBIENT = 0.8f;
+const float MAX_LEVEL = 2.0f;
+const float GREEN_LIGHT[3] = {0.45f, 1.0f, 0.5f};
+const double FACE_OFFSET = 0.01; // samples sit just off the face, inside the open neighbour
+
+const int FACE_DX[4] = {-1, 1, 0, 0};
+const int FACE_DY[4] = {0, 0, -1, 1};
+
+bool isOpenCell(const Map& map, int x, int y) {
+    int tile = map.at(x, y);
+    return tile == 0 || tile == DOOR_TILE;
+}
+
+LightLevel toLevel(const float rgb[3]) {
+    auto channel = [](float v) {
+        return static_cast<Uint16>(std::min(v, MAX_LEVEL) * 256.0f + 0.5f);
+    };
+    return {channel(rgb[0]), channel(rgb[1]), channel(rgb[2])};
+}
+
+// Ambient plus every light that reaches the point; normal (0,0) skips the Lambert term.
+LightLevel gatherLight(const Map& map, const std::vector<Door>& doors, const std::vector<LightSource>& lights,
+                       double px, double py, double nx, double ny) {
+    float rgb[3] = {AMBIENT, AMBIENT, AMBIENT};
+    for (const auto& light : lights) {
+        double dx = light.x - px;
+        double dy = light.y - py;
+        if (std::abs(dx) > light.radius || std::abs(dy) > light.radius) {
+            continue;
+        }
+        double dist = std::sqrt(dx * dx + dy * dy);
+        if (dist >= light.radius) {
+            continue;
+        }
+        double lambert = 1.0;
+        if (nx != 0.0 || ny != 0.0) {
+            lambert = dist > 0.0 ? (dx * nx + dy * ny) / dist : 1.0;
+            if (lambert <= 0.0) {
+                continue;
+            }
+        }
+        if (!hasLineOfSight(map, doors, light.x, light.y, px, py)) {
+            continue;
+        }
+        double falloff = 1.0 - dist / light.radius;
+        float amount = static_cast<float>(falloff * falloff * lambert);
+        rgb[0] += amount * light.r;
+        rgb[1] += amount * light.g;
+        rgb[2] += amount * light.b;
+    }
+    return toLevel(rgb);
+}
+
+// Doors are baked as either shut or fully open so partially open frames do not trigger rebakes.
+std::vector<Door> bakeDoorStates(const std::vector<Door>& doors, const std::vector<Uint8>& open) {
+    std::vector<Door> baked = doors;
+    for (size_t i = 0; i < baked.size(); ++i) {
+        baked[i].openAmount = open[i] ? 1.0 : 0.0;
+    }
+    return baked;
+}
+
+void bakeRect(Lightmap& lm, const Map& map, const std::vector<Door>& doors, int x0, int y0, int x1, int y1, ThreadPool& pool) {
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(map.width - 1, x1);
+    y1 = std::min(map.height - 1, y1);
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    // Rows write disjoint slots of the lightmap.
+    pool.parallelFor(static_cast<size_t>(y1 - y0 + 1), 4, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            int y = y0 + static_cast<int>(row);
+            for (int x = x0; x <= x1; ++x) {
+                int tile = map.at(x, y);
+                if (tile == 0 || tile == DOOR_TILE) {
+                    lm.cells[y * lm.width + x] = gatherLight(map, doors, lm.lights, x + 0.5, y + 0.5, 0.0, 0.0);
+                    continue;
+                }
+                for (int f = 0; f < 4; ++f) {
+                    if (!isOpenCell(map, x + FACE_DX[f], y + FACE_DY[f])) {
+                        continue; // never visible
+                    }
+                    double px = x + 0.5 + FACE_DX[f] * (0.5 + FACE_OFFSET);
+                    double py = y + 0.5 + FACE_DY[f] * (0.5 + FACE_OFFSET);
+                    lm.faces[(y * lm.width + x) * 4 + f] = gatherLight(map, doors, lm.lights, px, py, FACE_DX[f], FACE_DY[f]);
+                }
+            }
+        }
+    });
+}
+} // namespace
+
+std::vector<LightSource> collectLights(const EntityStore& entities) {
+    std::vector<LightSource> lights;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (entities.textureId[i] == LIGHT_SPRITE_ID && !(entities.flags[i] & ENTITY_WANDER)) {
+            lights.push_back({entities.x[i], entities.y[i], LIGHT_RADIUS, GREEN_LIGHT[0], GREEN_LIGHT[1], GREEN_LIGHT[2]});
+        }
+    }
+    return lights;
+}
+
+Lightmap bakeLightmap(const Map& map, const std::vector<Door>& doors, std::vector<LightSource> lights) {
+    return bakeLightmap(map, doors, std::move(lights), workerPool());
+}
+
+Lightmap bakeLightmap(const Map& map, const std::vector<Door>& doors, std::vector<LightSource> lights, ThreadPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    Lightmap lm;
+    lm.width = map.width;
+    lm.height = map.height;
+    const float ambient[3] = {AMBIENT, AMBIENT, AMBIENT};
+    lm.faces.assign(map.tiles.size() * 4, toLevel(ambient));
+    lm.cells.assign(map.tiles.size(), toLevel(ambient));
+    lm.lights = std::move(lights);
+    lm.doorOpen.resize(doors.size());
+    for (size_t i = 0; i < doors.size(); ++i) {
+        lm.doorOpen[i] = doors[i].openAmount > 0.0 ? 1 : 0;
+    }
+    bakeRect(lm, map, bakeDoorStates(doors, lm.doorOpen), 0, 0, map.width - 1, map.height - 1, pool);
+    lm.bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return lm;
+}
+
+int syncLightmapDoors(Lightmap& lightmap, const Map& map, const std::vector<Door>& doors) {
+    return syncLightmapDoors(lightmap, map, doors, workerPool());
+}
+
+int syncLightmapDoors(Lightmap& lightmap, const Map& map, const std::vector<Door>& doors, ThreadPool& pool) {
+    int changed = 0;
+    int x0 = map.width, y0 = map.height, x1 = -1, y1 = -1;
+    for (size_t i = 0; i < doors.size() && i < lightmap.doorOpen.size(); ++i) {
+        Uint8 open = doors[i].openAmount > 0.0 ? 1 : 0;
+        if (open == lightmap.doorOpen[i]) {
+            continue;
+        }
+        lightmap.doorOpen[i] = open;
+        ++changed;
+        // Any light path through the door ends within one radius of it.
+        int reach = static_cast<int>(std::ceil(LIGHT_RADIUS)) + 1;
+        x0 = std::min(x0, doors[i].x - reach);
+        y0 = std::min(y0, doors[i].y - reach);
+        x1 = std::max(x1, doors[i].x + reach);
+        y1 = std::max(y1, doors[i].y + reach);
+    }
+    if (changed == 0 || lightmap.lights.empty()) {
+        return changed;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bakeRect(lightmap, map, bakeDoorStates(doors, lightmap.doorOpen), x0, y0, x1, y1, pool);
+    lightmap.bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return changed;
+}
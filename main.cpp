@@ -1,18 +1,58 @@
 #include <SDL2/SDL.h>
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
 
+#include "bench.h"
+
+#include "camera_path.h"
+#include "capture.h"
 #include "doors.h"
+#include "entities.h"
 #include "game_types.h"
+#include "golden.h"
 #include "input.h"
+#include "level.h"
+#include "level_history.h"
+#include "lighting.h"
 #include "map.h"
+#include "offline_render.h"
+#include "pvs.h"
 #include "renderer.h"
 #include "sdl_context.h"
+#include "server.h"
+#include "telemetry.h"
+#include "texture_residency.h"
 #include "textures.h"
+#include "thread_pool.h"
+#include "timedemo.h"
 #include "console.h"
 
+namespace {
+// Cvar settings applied at startup, after every module has registered its cvars.
+const char* const CVAR_FILE = "raycaster.cfg";
+} // namespace
+
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    if (argc >= 2 && std::string(argv[1]) == "--bench") {
+        return runBenchmark(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--golden") {
+        return runGolden(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--render-path") {
+        return runOfflineRender(std::vector<std::string>(argv + 1, argv + argc));
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--server") {
+        return runServer(std::vector<std::string>(argv + 1, argv + argc));
+    }
 
     Config cfg{};
     SDLContext ctx{};
@@ -21,25 +61,63 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    Map map = createRandomMap();
-    std::vector<Door> doors = extractDoors(map);
-    std::vector<Sprite> sprites = createSprites(map);
     TextureManager textures = loadTextures();
-    auto spawn = pickSpawnPoint(map);
-    Player player{spawn.first, spawn.second, -1.0, 0.0, 0.0, 0.66};
-
-    sprites.erase(std::remove_if(sprites.begin(), sprites.end(), [&](const Sprite& s) {
-                      double dx = s.x - player.x;
-                      double dy = s.y - player.y;
-                      return (dx * dx + dy * dy) < 4.0;
-                  }),
-                  sprites.end());
+    int textureBudgetMb = 64;
+    auto residency = std::make_unique<TextureResidency>(textures, static_cast<size_t>(textureBudgetMb) << 20);
+    if (!residency->attach(TEXTURE_MANIFEST_PATH, TEXTURE_CACHE_PATH)) {
+        residency.reset();
+    }
+    std::unique_ptr<Level> level = buildLevel(std::random_device{}(), textures, workerPool());
+    LevelManager levels;
+    VisibleRegions visible;
+    Player player = level->spawn;
 
     ConsoleState console{};
+    bool switchPending = false;
+    bool readyReported = false;
+    registerLevelCommands(console, level, visible, levels, textures, switchPending, readyReported);
+    TimedemoRun demo;
+    demo.restorePose = player;
+    CameraRecording recording;
+    registerTimedemoCommands(console, demo, recording, level, player, ctx.renderer);
+    RenderContext renderContext;
+    FrameCapture capture(cfg.screenWidth, cfg.screenHeight);
+    renderContext.capture = &capture;
+    registerCaptureCommands(console, capture);
+    LevelHistory history;
+    double historySeconds = 10.0;
+    double gameTime = 0.0;
+    registerLevelHistoryCommands(console, history, historySeconds, level, player, gameTime, demo.active);
+    registerTextureResidencyCommands(console, residency.get(), textureBudgetMb);
+    // Split-screen: view 0 is the player, the others are spectator cameras slowly panning in the first rooms.
+    int splitViews = 1;
+    std::array<RenderView, 4> views{};
+    std::array<VisibleRegions, 4> spectatorVisible;
+    double spectatorAngle = 0.0;
+    // r_threads swaps in a private column pool owned here.
+    int renderThreads = 0;
+    std::unique_ptr<ThreadPool> renderPool;
+    registerRenderContextCommands(console, renderContext, cfg, splitViews, renderThreads, renderPool);
+    TelemetryServer telemetry;
+    registerTelemetryCommands(console, telemetry);
+    if (const char* path = std::getenv("RAYCASTER_TELEMETRY")) {
+        if (telemetry.start(path)) {
+            consolePrint(console, std::string("Telemetry on ") + path);
+        }
+    }
+    MouseLook mouseLook;
+    registerInputCommands(console, mouseLook);
+    registerInputCvars(console, cfg);
+    registerRendererCvars(console, cfg);
+    registerDisplayCvars(console, ctx, cfg);
+    if (std::filesystem::exists(CVAR_FILE)) {
+        loadCvarFile(console, CVAR_FILE);
+    }
     bool minimapVisible = true;
     double fps = 0.0;
 
     bool running = true;
+    Uint32 frameNumber = 0;
     Uint32 lastTicks = SDL_GetTicks();
     while (running) {
         SDL_Event e;
@@ -47,16 +125,51 @@ int main(int argc, char* argv[]) {
             if (e.type == SDL_QUIT) {
                 running = false;
             } else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
+                if (e.key.keysym.sym == SDLK_ESCAPE && demo.active) {
+                    finishTimedemo(demo, console, ctx.renderer, true);
+                    player = demo.restorePose;
+                } else if (e.key.keysym.sym == SDLK_ESCAPE) {
                     running = false;
                 } else if (e.key.repeat == 0 && e.key.keysym.sym == SDLK_TAB) {
                     setConsoleOpen(console, !console.open);
+                } else if (e.key.repeat == 0 && e.key.keysym.sym == SDLK_F12) {
+                    takeScreenshot(console, capture, "");
                 } else if (e.key.repeat == 0 && e.key.keysym.sym == SDLK_m) {
                     if (!console.open) minimapVisible = !minimapVisible;
                 }
             }
+            accumulateMouseMotion(mouseLook, e);
             handleConsoleEvent(console, e, cfg, player, running);
         }
+        setMouseCaptured(mouseLook, cfg, !console.open && !demo.active);
+        if (telemetry.running()) {
+            telemetry.runCommands([&](const std::string& command) { return executeConsoleCommand(console, command, cfg, player, running); });
+        }
+
+        // Level swap between frames: the previous frame is presented and nothing of this one has run yet.
+        if (levels.ready() && !demo.active) {
+            auto swapStart = std::chrono::steady_clock::now();
+            if (switchPending) {
+                std::unique_ptr<Level> next = levels.takeReady();
+                std::swap(level, next);
+                player = level->spawn;
+                visible = VisibleRegions{};
+                levels.retire(std::move(next));
+                history.clear();
+                switchPending = false;
+                double swapUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - swapStart).count();
+                char line[160];
+                std::snprintf(line, sizeof(line), "Switched to level %u in %.1f us (built in %.0f ms off-thread)", level->seed, swapUs, level->buildMs);
+                consolePrint(console, line);
+            } else if (!readyReported) {
+                readyReported = true;
+                consolePrint(console, "Level " + std::to_string(levels.pendingSeed()) + " ready; level_switch swaps it in");
+            }
+        }
+
+        if (residency) {
+            residency->update();
+        }
 
         Uint32 currentTicks = SDL_GetTicks();
         double dt = (currentTicks - lastTicks) / 1000.0;
@@ -64,16 +177,77 @@ int main(int argc, char* argv[]) {
         double instFps = (dt > 0.0) ? (1.0 / dt) : fps;
         fps = fps * 0.9 + instFps * 0.1;
 
+        auto simStart = std::chrono::steady_clock::now();
         const Uint8* keystate = SDL_GetKeyboardState(nullptr);
-        if (!console.open) {
-            handleInput(keystate, map, doors, player, cfg, dt);
+        if (demo.active) {
+            dt = TIMEDEMO_STEP;
+            if (!advanceTimedemo(demo, player)) {
+                finishTimedemo(demo, console, ctx.renderer, false);
+                player = demo.restorePose;
+            }
+        } else if (!console.open) {
+            handleInput(keystate, level->map, level->doors, player, cfg, dt, &level->collision);
         }
-        updateDoors(doors, player, dt);
+        if (recording.active) {
+            recording.path.frames.push_back(player);
+        }
+        updateDoors(level->doors, player, dt);
+        updateEntities(level->entities, level->map, level->doors, level->collision, dt);
+        level->collision.sync(level->entities);
+        syncLightmapDoors(level->lightmap, level->map, level->doors);
+        computeVisibleRegions(level->pvs, level->doors, player.x, player.y, visible);
+        // Timedemos reset doors and fly a scripted camera, so they stay out of the history.
+        if (!demo.active) {
+            gameTime += dt;
+            history.record(*level, player, gameTime);
+        }
+        // Last thing before the views are built: only the turn, which nothing simulated above depends on.
+        applyMouseLook(mouseLook, player, cfg);
+        auto simEnd = std::chrono::steady_clock::now();
 
-        renderFrame(map, doors, sprites, player, cfg, ctx.renderer, textures, console, minimapVisible, fps);
+        SDL_Rect viewports[4];
+        int viewCount = splitScreenLayout(ctx.frameWidth, ctx.frameHeight, splitViews, viewports);
+        spectatorAngle += dt * 0.3;
+        for (int v = 0; v < viewCount; ++v) {
+            Player camera = player;
+            views[v].visible = cfg.pvsCulling ? &visible : nullptr;
+            if (v > 0) {
+                const MapRoom* room = v - 1 < static_cast<int>(level->map.rooms.size()) ? &level->map.rooms[v - 1] : nullptr;
+                double x = room ? room->x + room->w * 0.5 : player.x;
+                double y = room ? room->y + room->h * 0.5 : player.y;
+                camera = cameraFromAngle(x, y, spectatorAngle + v * 1.5707963);
+                computeVisibleRegions(level->pvs, level->doors, x, y, spectatorVisible[v]);
+                views[v].visible = cfg.pvsCulling ? &spectatorVisible[v] : nullptr;
+            }
+            views[v].camera = cameraForViewport(camera, ctx.frameWidth, ctx.frameHeight, viewports[v]);
+            views[v].viewport = viewports[v];
+        }
+        renderFrame(renderContext, level->map, level->doors, level->entities, views.data(), viewCount, cfg, ctx, textures, console, minimapVisible, fps, &level->lightmap);
+        finishMouseLookFrame(mouseLook);
+        ++frameNumber;
+        if (telemetry.running()) {
+            FrameMetrics metrics;
+            metrics.frame = frameNumber;
+            metrics.frameMs = static_cast<float>(dt * 1000.0);
+            metrics.simMs = std::chrono::duration<float, std::milli>(simEnd - simStart).count();
+            metrics.viewsMs = static_cast<float>(renderContext.lastViewsMs);
+            metrics.renderMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - simEnd).count();
+            metrics.rays = renderContext.lastFrameRays;
+            metrics.sprites = renderContext.lastFrameSprites;
+            metrics.doorsActive = static_cast<Uint32>(std::count_if(level->doors.begin(), level->doors.end(), [](const Door& d) { return d.openAmount > 0.0; }));
+            metrics.entities = static_cast<Uint32>(level->entities.size());
+            metrics.allocations = static_cast<Uint32>(renderContext.lastFrameAllocations.count);
+            metrics.allocBytes = static_cast<Uint32>(renderContext.lastFrameAllocations.bytes);
+            telemetry.publish(metrics);
+        }
     }
 
     setConsoleOpen(console, false);
+    // Queued screenshots and recorded frames are encoded with SDL_image, so they must be written before SDL quits.
+    capture.finish();
+    // A build still running reads texture pages; finish it before the textures go.
+    levels.shutdown();
+    residency.reset();
     freeTextures(textures);
     shutdownSDL(ctx);
     return 0;
@@ -68,10 +68,18 @@ void addDoors(Map& m, std::mt19937& rng) {
 
 Map createRandomMap() {
     std::random_device rd;
-    std::mt19937 rng(rd());
+    return createRandomMap(rd());
+}
+
+Map createRandomMap(unsigned seed, int width, int height) {
+    std::mt19937 rng(seed);
     std::uniform_int_distribution<int> sizeDist(32, 256);
     int w = sizeDist(rng);
     int h = sizeDist(rng);
+    if (width > 0 && height > 0) {
+        w = std::max(width, 16);
+        h = std::max(height, 16);
+    }
 
     Map m{};
     m.width = w;
@@ -121,6 +129,10 @@ Map createRandomMap() {
         // Fallback to a small open box if random placement failed.
         int margin = 2;
         fillRect(m, margin, margin, w - margin * 2, h - margin * 2, 0);
+        m.rooms.push_back({margin, margin, w - margin * 2, h - margin * 2});
+    }
+    for (const auto& r : rooms) {
+        m.rooms.push_back({r.x, r.y, r.w, r.h});
     }
 
     // Connect rooms with corridors (simple chaining + some random links).
@@ -180,6 +192,11 @@ std::pair<double, double> pickSpawnPoint(const Map& map) {
 }
 
 std::vector<Sprite> createSprites(const Map& map) {
+    std::random_device rd;
+    return createSprites(map, rd());
+}
+
+std::vector<Sprite> createSprites(const Map& map, unsigned seed) {
     std::vector<std::pair<int, int>> candidates;
     candidates.reserve((map.width - 2) * (map.height - 2));
     for (int y = 1; y < map.height - 1; ++y) {
@@ -193,8 +210,7 @@ std::vector<Sprite> createSprites(const Map& map) {
         return {};
     }
 
-    std::random_device rd;
-    std::mt19937 rng(rd());
+    std::mt19937 rng(seed);
     std::shuffle(candidates.begin(), candidates.end(), rng);
 
     int targetCount = std::clamp((map.width * map.height) / 180, 12, 96);
@@ -0,0 +1,148 @@
+#include "offline_render.h"
+
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#include "camera_path.h"
+#include "doors.h"
+#include "entities.h"
+#include "game_types.h"
+#include "image_writer.h"
+#include "lighting.h"
+#include "map.h"
+#include "renderer.h"
+#include "textures.h"
+#include "thread_pool.h"
+#include "timedemo.h"
+
+namespace {
+struct OfflineOptions {
+    std::string pathFile;
+    std::string outDir;
+    unsigned seed = 1;
+    ImageFormat format = ImageFormat::PPM;
+    int width = 0;
+    int height = 0;
+    unsigned writers = 2;
+};
+
+bool parseOptions(const std::vector<std::string>& args, OfflineOptions& opts) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (i + 1 >= args.size()) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        const std::string& value = args[++i];
+        if (arg == "--render-path") {
+            opts.pathFile = value;
+        } else if (arg == "--out") {
+            opts.outDir = value;
+        } else if (arg == "--seed") {
+            opts.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--format") {
+            if (!parseImageFormat(value, opts.format)) {
+                std::cerr << "Unknown image format: " << value << " (ppm or png)\n";
+                return false;
+            }
+        } else if (arg == "--size") {
+            if (std::sscanf(value.c_str(), "%dx%d", &opts.width, &opts.height) != 2 || opts.width <= 0 || opts.height <= 0) {
+                std::cerr << "Invalid size: " << value << " (expected WxH)\n";
+                return false;
+            }
+        } else if (arg == "--writers") {
+            opts.writers = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    if (opts.pathFile.empty() || opts.outDir.empty()) {
+        std::cerr << "Usage: raycaster --render-path <file|auto> --out <dir> [--seed n] [--format ppm|png] [--size WxH] [--writers n]\n";
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int runOfflineRender(const std::vector<std::string>& args) {
+    OfflineOptions opts;
+    if (!parseOptions(args, opts)) {
+        return 1;
+    }
+    Config cfg{};
+    if (opts.width > 0) {
+        cfg.screenWidth = opts.width;
+        cfg.screenHeight = opts.height;
+    }
+
+    // Everything the workers read is built up front and never modified while they run.
+    const Map map = createRandomMap(opts.seed);
+    std::vector<Door> doors = extractDoors(map);
+    const EntityStore entities = entitiesFromSprites(createSprites(map, opts.seed));
+    const Lightmap lightmap = bakeLightmap(map, doors, collectLights(entities));
+    CameraPath path;
+    if (opts.pathFile == "auto") {
+        path = generateRoomTour(map, doors);
+    } else if (!loadCameraPath(opts.pathFile, path)) {
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(opts.outDir, ec);
+    if (ec) {
+        std::cerr << "Failed to create " << opts.outDir << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    IMG_Init(IMG_INIT_PNG);
+    TextureManager textures = loadTextures();
+
+    ThreadPool& pool = workerPool();
+    // Door animation depends on the camera history, so each batch's door states are stepped
+    // serially first; the frames themselves then render concurrently, one per task.
+    const size_t batch = pool.concurrency() * 2;
+    std::vector<std::vector<Door>> batchDoors(batch);
+    ImageWriteQueue writer(cfg.screenWidth, cfg.screenHeight, batch * 2, opts.writers, opts.format);
+    const char* ext = imageExtension(opts.format);
+
+    std::cout << "rendering " << path.frames.size() << " frames at " << cfg.screenWidth << "x" << cfg.screenHeight << " on "
+              << pool.concurrency() << " thread(s) to " << opts.outDir << "\n";
+    auto start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < path.frames.size(); first += batch) {
+        size_t count = std::min(batch, path.frames.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            updateDoors(doors, path.frames[first + i], TIMEDEMO_STEP);
+            batchDoors[i] = doors;
+        }
+        pool.parallelFor(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ImageBuffer* buffer = writer.acquire();
+                FrameTarget target{buffer->pixels.data(), buffer->width, buffer->height, buffer->width};
+                renderWorld(map, batchDoors[i], entities, path.frames[first + i], cfg, textures, target, nullptr, &lightmap);
+                char name[32];
+                std::snprintf(name, sizeof(name), "frame_%06zu", first + i);
+                writer.submit(buffer, (std::filesystem::path(opts.outDir) / (std::string(name) + ext)).string());
+            }
+        });
+    }
+    double renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    writer.finish();
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1) << "rendered in " << renderMs / 1000.0 << " s, written in "
+              << totalMs / 1000.0 << " s (" << path.frames.size() / (totalMs / 1000.0) << " frames/s); workers waited "
+              << writer.acquireWaitMs() << " ms for buffers, writer queue peaked at " << writer.maxQueued() << "\n";
+    freeTextures(textures);
+    IMG_Quit();
+    if (writer.failed() > 0) {
+        std::cerr << writer.failed() << " frame(s) failed to write\n";
+        return 1;
+    }
+    return 0;
+}
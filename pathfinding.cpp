@@ -0,0 +1,392 @@
+#include "pathfinding.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+#include "doors.h"
+
+namespace {
+// Straight neighbours first, then diagonals; d ^ 1 is the opposite of d. FlowField::direction indexes this table.
+const int OFFSET_X[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+const int OFFSET_Y[8] = {0, 0, 1, -1, 1, -1, -1, 1};
+
+// Closed doors cost the wait for them to open; the same threshold movement uses.
+Uint16 doorCost(const Door& door) {
+    return doorPassable(door) ? NAV_DOOR_OPEN_COST : NAV_DOOR_CLOSED_COST;
+}
+
+Uint32 octile(int ax, int ay, int bx, int by) {
+    int dx = std::abs(ax - bx);
+    int dy = std::abs(ay - by);
+    int diag = std::min(dx, dy);
+    return NAV_DIAGONAL_COST * diag + NAV_STRAIGHT_COST * (std::max(dx, dy) - diag);
+}
+
+// Diagonal moves may not cut wall corners.
+bool canStep(const NavGrid& grid, int x, int y, int dir) {
+    int nx = x + OFFSET_X[dir];
+    int ny = y + OFFSET_Y[dir];
+    if (!grid.walkable(nx, ny)) {
+        return false;
+    }
+    return dir < 4 || (grid.walkable(nx, y) && grid.walkable(x, ny));
+}
+
+int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+} // namespace
+
+NavGrid buildNavGrid(const Map& map, const std::vector<Door>& doors) {
+    NavGrid grid;
+    grid.width = map.width;
+    grid.height = map.height;
+    grid.passable.assign(map.tiles.size(), 0);
+    grid.extraCost.assign(map.tiles.size(), 0);
+    for (size_t i = 0; i < map.tiles.size(); ++i) {
+        grid.passable[i] = map.tiles[i] == 0 ? 1 : 0;
+    }
+    for (const auto& door : doors) {
+        int cell = door.y * map.width + door.x;
+        grid.passable[cell] = 1;
+        grid.extraCost[cell] = doorCost(door);
+    }
+    return grid;
+}
+
+PathService::PathService(const Map& map, const std::vector<Door>& doors)
+    : grid_(buildNavGrid(map, doors)) {
+    size_t cells = grid_.passable.size();
+    gScore_.assign(cells, 0);
+    parent_.assign(cells, -1);
+    stamp_.assign(cells, 0);
+    closed_.assign(cells, 0);
+    for (const auto& door : doors) {
+        doorCells_.push_back(door.y * map.width + door.x);
+        doorOpen_.push_back(doorPassable(door) ? 1 : 0);
+    }
+}
+
+bool PathService::jumpStraight(int x, int y, int dx, int dy, GridPoint goal, GridPoint& out) const {
+    for (;;) {
+        x += dx;
+        y += dy;
+        if (!grid_.walkable(x, y)) {
+            return false;
+        }
+        // Doors break the uniform-cost symmetry JPS relies on, so every door is a jump point.
+        if ((x == goal.x && y == goal.y) || grid_.extraCost[y * grid_.width + x] != 0) {
+            out = {x, y};
+            return true;
+        }
+        bool forced = dx != 0
+            ? (grid_.walkable(x, y - 1) && !grid_.walkable(x - dx, y - 1)) || (grid_.walkable(x, y + 1) && !grid_.walkable(x - dx, y + 1))
+            : (grid_.walkable(x - 1, y) && !grid_.walkable(x - 1, y - dy)) || (grid_.walkable(x + 1, y) && !grid_.walkable(x + 1, y - dy));
+        if (forced) {
+            out = {x, y};
+            return true;
+        }
+    }
+}
+
+bool PathService::jump(int x, int y, int dx, int dy, GridPoint goal, GridPoint& out) const {
+    if (dx == 0 || dy == 0) {
+        return jumpStraight(x, y, dx, dy, goal, out);
+    }
+    GridPoint ignored;
+    for (;;) {
+        x += dx;
+        y += dy;
+        if (!grid_.walkable(x, y)) {
+            return false;
+        }
+        if ((x == goal.x && y == goal.y) || grid_.extraCost[y * grid_.width + x] != 0
+            || jumpStraight(x, y, dx, 0, goal, ignored) || jumpStraight(x, y, 0, dy, goal, ignored)) {
+            out = {x, y};
+            return true;
+        }
+        if (!grid_.walkable(x + dx, y) || !grid_.walkable(x, y + dy)) {
+            return false;
+        }
+    }
+}
+
+bool PathService::findPath(GridPoint start, GridPoint goal, std::vector<GridPoint>& waypoints, Uint32* cost) {
+    waypoints.clear();
+    if (!grid_.walkable(start.x, start.y) || !grid_.walkable(goal.x, goal.y)) {
+        return false;
+    }
+    if (++searchId_ == 0) {
+        std::fill(stamp_.begin(), stamp_.end(), 0);
+        searchId_ = 1;
+    }
+    const int width = grid_.width;
+    auto visit = [&](int cell) {
+        if (stamp_[cell] != searchId_) {
+            stamp_[cell] = searchId_;
+            gScore_[cell] = NAV_UNREACHABLE;
+            parent_[cell] = -1;
+            closed_[cell] = 0;
+        }
+    };
+
+    std::vector<OpenNode> open;
+    int startCell = start.y * width + start.x;
+    int goalCell = goal.y * width + goal.x;
+    visit(startCell);
+    gScore_[startCell] = 0;
+    open.push_back({octile(start.x, start.y, goal.x, goal.y), startCell});
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenNode>());
+        int cell = open.back().cell;
+        open.pop_back();
+        if (closed_[cell]) {
+            continue;
+        }
+        closed_[cell] = 1;
+        if (cell == goalCell) {
+            break;
+        }
+        int x = cell % width;
+        int y = cell / width;
+
+        // Pruned neighbour directions (no corner cutting): natural plus forced successors of the incoming move.
+        int dirs[8][2];
+        int dirCount = 0;
+        auto add = [&](int dx, int dy) {
+            dirs[dirCount][0] = dx;
+            dirs[dirCount][1] = dy;
+            ++dirCount;
+        };
+        if (parent_[cell] < 0) {
+            for (int d = 0; d < 8; ++d) {
+                if (canStep(grid_, x, y, d)) {
+                    add(OFFSET_X[d], OFFSET_Y[d]);
+                }
+            }
+        } else {
+            int dx = sign(x - parent_[cell] % width);
+            int dy = sign(y - parent_[cell] / width);
+            if (dx != 0 && dy != 0) {
+                bool vertical = grid_.walkable(x, y + dy);
+                bool horizontal = grid_.walkable(x + dx, y);
+                if (vertical) add(0, dy);
+                if (horizontal) add(dx, 0);
+                if (vertical && horizontal) add(dx, dy);
+            } else if (dx != 0) {
+                bool next = grid_.walkable(x + dx, y);
+                bool down = grid_.walkable(x, y + 1);
+                bool up = grid_.walkable(x, y - 1);
+                if (next) {
+                    add(dx, 0);
+                    if (down) add(dx, 1);
+                    if (up) add(dx, -1);
+                }
+                if (down) add(0, 1);
+                if (up) add(0, -1);
+            } else {
+                bool next = grid_.walkable(x, y + dy);
+                bool right = grid_.walkable(x + 1, y);
+                bool left = grid_.walkable(x - 1, y);
+                if (next) {
+                    add(0, dy);
+                    if (right) add(1, dy);
+                    if (left) add(-1, dy);
+                }
+                if (right) add(1, 0);
+                if (left) add(-1, 0);
+            }
+        }
+
+        for (int i = 0; i < dirCount; ++i) {
+            GridPoint jp;
+            if (!jump(x, y, dirs[i][0], dirs[i][1], goal, jp)) {
+                continue;
+            }
+            int next = jp.y * width + jp.x;
+            visit(next);
+            if (closed_[next]) {
+                continue;
+            }
+            // Jumps stop at every door, so the segment between jump points crosses none.
+            Uint32 g = gScore_[cell] + octile(x, y, jp.x, jp.y) + grid_.extraCost[next];
+            if (g < gScore_[next]) {
+                gScore_[next] = g;
+                parent_[next] = cell;
+                open.push_back({g + octile(jp.x, jp.y, goal.x, goal.y), next});
+                std::push_heap(open.begin(), open.end(), std::greater<OpenNode>());
+            }
+        }
+    }
+
+    if (stamp_[goalCell] != searchId_ || !closed_[goalCell]) {
+        return false;
+    }
+    for (int cell = goalCell; cell >= 0; cell = parent_[cell]) {
+        waypoints.push_back({cell % width, cell / width});
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+    if (cost) {
+        *cost = gScore_[goalCell];
+    }
+    return true;
+}
+
+// Relaxes outward from the open list; a cell's cost is the cheapest step into a neighbour plus that neighbour's cost.
+void PathService::propagate(FlowField& field, std::vector<OpenNode>& open) {
+    const int width = grid_.width;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenNode>());
+        OpenNode node = open.back();
+        open.pop_back();
+        if (node.f != field.distance[node.cell]) {
+            continue; // stale entry
+        }
+        int x = node.cell % width;
+        int y = node.cell / width;
+        Uint32 enter = node.f + grid_.extraCost[node.cell];
+        for (int d = 0; d < 8; ++d) {
+            if (!canStep(grid_, x, y, d)) {
+                continue;
+            }
+            int from = (y + OFFSET_Y[d]) * width + x + OFFSET_X[d];
+            Uint32 candidate = enter + (d < 4 ? NAV_STRAIGHT_COST : NAV_DIAGONAL_COST);
+            if (candidate < field.distance[from]) {
+                field.distance[from] = candidate;
+                field.direction[from] = static_cast<Sint8>(d ^ 1); // opposite offset points back at this cell
+                open.push_back({candidate, from});
+                std::push_heap(open.begin(), open.end(), std::greater<OpenNode>());
+            }
+        }
+    }
+}
+
+void PathService::buildField(FlowField& field) {
+    size_t cells = grid_.passable.size();
+    field.distance.assign(cells, NAV_UNREACHABLE);
+    field.direction.assign(cells, -1);
+    if (!grid_.walkable(field.targetX, field.targetY)) {
+        return;
+    }
+    int target = field.targetY * grid_.width + field.targetX;
+    field.distance[target] = 0;
+    std::vector<OpenNode> open{{0, target}};
+    propagate(field, open);
+}
+
+const FlowField& PathService::flowFieldTo(GridPoint target) {
+    ++useCounter_;
+    for (auto& field : fields_) {
+        if (field.targetX == target.x && field.targetY == target.y) {
+            field.lastUsed = useCounter_;
+            return field;
+        }
+    }
+    FlowField* slot;
+    if (fields_.size() < cacheCapacity_) {
+        fields_.emplace_back();
+        slot = &fields_.back();
+    } else {
+        slot = &*std::min_element(fields_.begin(), fields_.end(),
+                                  [](const FlowField& a, const FlowField& b) { return a.lastUsed < b.lastUsed; });
+    }
+    slot->targetX = target.x;
+    slot->targetY = target.y;
+    slot->lastUsed = useCounter_;
+    buildField(*slot);
+    return *slot;
+}
+
+bool PathService::flowStep(const FlowField& field, int width, int x, int y, int& dx, int& dy) {
+    int dir = field.direction[y * width + x];
+    if (dir < 0) {
+        return false;
+    }
+    dx = OFFSET_X[dir];
+    dy = OFFSET_Y[dir];
+    return true;
+}
+
+// Only edges into the changed cell change cost. A cheaper door relaxes outward from it;
+// a dearer one resets every cell whose route ran through it and refills that region from its edge.
+void PathService::repairField(FlowField& field, int cell, Uint16 oldCost) {
+    std::vector<OpenNode> open;
+    if (field.distance[cell] == NAV_UNREACHABLE) {
+        return;
+    }
+    if (grid_.extraCost[cell] < oldCost) {
+        open.push_back({field.distance[cell], cell});
+        propagate(field, open);
+        return;
+    }
+
+    const int width = grid_.width;
+    std::vector<int> region;
+    for (size_t i = 0; i <= region.size(); ++i) {
+        int parent = i == 0 ? cell : region[i - 1];
+        int px = parent % width;
+        int py = parent / width;
+        for (int d = 0; d < 8; ++d) {
+            int nx = px + OFFSET_X[d];
+            int ny = py + OFFSET_Y[d];
+            if (!grid_.walkable(nx, ny)) {
+                continue;
+            }
+            int child = ny * width + nx;
+            if (field.direction[child] == (d ^ 1)) {
+                field.distance[child] = NAV_UNREACHABLE;
+                field.direction[child] = -1;
+                region.push_back(child);
+            }
+        }
+    }
+    for (int r : region) {
+        int x = r % width;
+        int y = r / width;
+        for (int d = 0; d < 8; ++d) {
+            if (!canStep(grid_, x, y, d)) {
+                continue;
+            }
+            int n = (y + OFFSET_Y[d]) * width + x + OFFSET_X[d];
+            if (field.distance[n] == NAV_UNREACHABLE) {
+                continue;
+            }
+            Uint32 candidate = field.distance[n] + grid_.extraCost[n] + (d < 4 ? NAV_STRAIGHT_COST : NAV_DIAGONAL_COST);
+            if (candidate < field.distance[r]) {
+                field.distance[r] = candidate;
+                field.direction[r] = static_cast<Sint8>(d);
+            }
+        }
+        if (field.distance[r] != NAV_UNREACHABLE) {
+            open.push_back({field.distance[r], r});
+        }
+    }
+    std::make_heap(open.begin(), open.end(), std::greater<OpenNode>());
+    propagate(field, open);
+}
+
+void PathService::updateCellCost(int cell, Uint16 extraCost) {
+    Uint16 oldCost = grid_.extraCost[cell];
+    if (oldCost == extraCost) {
+        return;
+    }
+    grid_.extraCost[cell] = extraCost;
+    for (auto& field : fields_) {
+        repairField(field, cell, oldCost);
+    }
+}
+
+int PathService::syncDoors(const std::vector<Door>& doors) {
+    int changed = 0;
+    for (size_t i = 0; i < doors.size() && i < doorCells_.size(); ++i) {
+        Uint8 open = doorPassable(doors[i]) ? 1 : 0;
+        if (open != doorOpen_[i]) {
+            doorOpen_[i] = open;
+            updateCellCost(doorCells_[i], doorCost(doors[i]));
+            ++changed;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,276 @@
+#include "pvs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "thread_pool.h"
+
+namespace {
+const int MAX_CORRIDOR_REGION = 48; // cells; long corridors are split so their PVS stays tight
+const int RAYS_PER_SAMPLE = 160;
+const double TWO_PI = 6.283185307179586;
+
+void markRegion(Uint64* row, int region) {
+    if (region >= 0) {
+        row[region >> 6] |= Uint64(1) << (region & 63);
+    }
+}
+
+// Walks one ray with every door open and marks each region it passes through.
+void traceRegions(const Map& map, const PvsData& pvs, double px, double py, double dirX, double dirY, Uint64* row) {
+    int mapX = static_cast<int>(px);
+    int mapY = static_cast<int>(py);
+    double deltaX = dirX == 0.0 ? 1e30 : std::abs(1.0 / dirX);
+    double deltaY = dirY == 0.0 ? 1e30 : std::abs(1.0 / dirY);
+    int stepX = dirX < 0 ? -1 : 1;
+    int stepY = dirY < 0 ? -1 : 1;
+    double sideX = dirX < 0 ? (px - mapX) * deltaX : (mapX + 1.0 - px) * deltaX;
+    double sideY = dirY < 0 ? (py - mapY) * deltaY : (mapY + 1.0 - py) * deltaY;
+    for (;;) {
+        if (sideX < sideY) {
+            sideX += deltaX;
+            mapX += stepX;
+        } else {
+            sideY += deltaY;
+            mapY += stepY;
+        }
+        if (mapX < 0 || mapY < 0 || mapX >= pvs.width || mapY >= pvs.height) {
+            return;
+        }
+        int cell = mapY * pvs.width + mapX;
+        int door = pvs.doorOf[cell];
+        if (door >= 0) {
+            markRegion(row, pvs.doorSides[door * 2]);
+            markRegion(row, pvs.doorSides[door * 2 + 1]);
+            continue;
+        }
+        if (map.tiles[cell] != 0) {
+            return;
+        }
+        markRegion(row, pvs.regionOf[cell]);
+    }
+}
+
+void assignRegions(const Map& map, PvsData& pvs) {
+    const int w = map.width;
+    for (const auto& room : map.rooms) {
+        int id = pvs.regionCount++;
+        for (int y = room.y; y < room.y + room.h; ++y) {
+            for (int x = room.x; x < room.x + room.w; ++x) {
+                int cell = y * w + x;
+                if (map.tiles[cell] == 0 && pvs.regionOf[cell] < 0) {
+                    pvs.regionOf[cell] = id;
+                }
+            }
+        }
+    }
+    // Corridors: bounded flood fills that stop at room cells and doors.
+    std::vector<int> frontier;
+    for (int start = 0; start < static_cast<int>(map.tiles.size()); ++start) {
+        if (map.tiles[start] != 0 || pvs.regionOf[start] >= 0) {
+            continue;
+        }
+        int id = pvs.regionCount++;
+        frontier.assign(1, start);
+        pvs.regionOf[start] = id;
+        for (size_t i = 0; i < frontier.size(); ++i) {
+            int x = frontier[i] % w;
+            int y = frontier[i] / w;
+            const int nx[4] = {x + 1, x - 1, x, x};
+            const int ny[4] = {y, y, y + 1, y - 1};
+            for (int k = 0; k < 4; ++k) {
+                if (map.at(nx[k], ny[k]) != 0) {
+                    continue;
+                }
+                int n = ny[k] * w + nx[k];
+                if (pvs.regionOf[n] < 0 && static_cast<int>(frontier.size()) < MAX_CORRIDOR_REGION) {
+                    pvs.regionOf[n] = id;
+                    frontier.push_back(n);
+                }
+            }
+        }
+    }
+}
+
+void buildEdges(const Map& map, const std::vector<Door>& doors, PvsData& pvs) {
+    const int w = map.width;
+    pvs.edges.assign(pvs.regionCount, {});
+    for (int y = 0; y < map.height; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int a = pvs.regionOf[y * w + x];
+            if (a < 0) {
+                continue;
+            }
+            int right = x + 1 < w ? pvs.regionOf[y * w + x + 1] : -1;
+            int below = y + 1 < map.height ? pvs.regionOf[(y + 1) * w + x] : -1;
+            for (int b : {right, below}) {
+                if (b >= 0 && b != a) {
+                    pvs.edges[a].push_back({b, -1});
+                    pvs.edges[b].push_back({a, -1});
+                }
+            }
+        }
+    }
+    for (size_t d = 0; d < doors.size(); ++d) {
+        int a = pvs.doorSides[d * 2];
+        int b = pvs.doorSides[d * 2 + 1];
+        if (a >= 0 && b >= 0 && a != b) {
+            pvs.edges[a].push_back({b, static_cast<int>(d)});
+            pvs.edges[b].push_back({a, static_cast<int>(d)});
+        }
+    }
+    for (auto& list : pvs.edges) {
+        std::sort(list.begin(), list.end(), [](const PvsEdge& l, const PvsEdge& r) {
+            return l.region != r.region ? l.region < r.region : l.door < r.door;
+        });
+        list.erase(std::unique(list.begin(), list.end(), [](const PvsEdge& l, const PvsEdge& r) {
+                       return l.region == r.region && l.door == r.door;
+                   }),
+                   list.end());
+    }
+}
+} // namespace
+
+PvsData buildPvs(const Map& map, const std::vector<Door>& doors) {
+    return buildPvs(map, doors, workerPool());
+}
+
+PvsData buildPvs(const Map& map, const std::vector<Door>& doors, ThreadPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    PvsData pvs;
+    pvs.width = map.width;
+    pvs.height = map.height;
+    pvs.regionOf.assign(map.tiles.size(), -1);
+    pvs.doorOf.assign(map.tiles.size(), -1);
+    assignRegions(map, pvs);
+
+    pvs.doorSides.assign(doors.size() * 2, -1);
+    for (size_t d = 0; d < doors.size(); ++d) {
+        const Door& door = doors[d];
+        pvs.doorOf[door.y * map.width + door.x] = static_cast<int>(d);
+        int ax = door.vertical ? door.x - 1 : door.x;
+        int ay = door.vertical ? door.y : door.y - 1;
+        int bx = door.vertical ? door.x + 1 : door.x;
+        int by = door.vertical ? door.y : door.y + 1;
+        if (map.at(ax, ay) == 0) pvs.doorSides[d * 2] = pvs.regionOf[ay * map.width + ax];
+        if (map.at(bx, by) == 0) pvs.doorSides[d * 2 + 1] = pvs.regionOf[by * map.width + bx];
+    }
+    buildEdges(map, doors, pvs);
+
+    // Cells of each region, contiguous, so a worker can sample its region without scanning the map.
+    std::vector<int> regionStart(pvs.regionCount + 1, 0);
+    for (int r : pvs.regionOf) {
+        if (r >= 0) ++regionStart[r + 1];
+    }
+    for (int r = 0; r < pvs.regionCount; ++r) {
+        regionStart[r + 1] += regionStart[r];
+    }
+    std::vector<int> regionCells(regionStart.back());
+    std::vector<int> fill(regionStart.begin(), regionStart.end() - 1);
+    for (int cell = 0; cell < static_cast<int>(pvs.regionOf.size()); ++cell) {
+        if (pvs.regionOf[cell] >= 0) regionCells[fill[pvs.regionOf[cell]]++] = cell;
+    }
+
+    pvs.rowWords = (static_cast<size_t>(pvs.regionCount) + 63) / 64;
+    pvs.visible.assign(pvs.rowWords * pvs.regionCount, 0);
+    // Each worker owns whole rows, so no synchronisation is needed while tracing.
+    pool.parallelFor(pvs.regionCount, 1, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            Uint64* row = &pvs.visible[r * pvs.rowWords];
+            markRegion(row, static_cast<int>(r));
+            for (const auto& e : pvs.edges[r]) {
+                markRegion(row, e.region);
+            }
+            int count = regionStart[r + 1] - regionStart[r];
+            for (int i = 0; i < count; ++i) {
+                int cell = regionCells[regionStart[r] + i];
+                int x = cell % map.width;
+                int y = cell / map.width;
+                // Checkerboard samples; tiny regions use every cell. Ray fans are rotated per sample.
+                if (count > 4 && ((x + y) & 1)) {
+                    continue;
+                }
+                double offset = std::fmod(i * 0.6180339887, 1.0) * TWO_PI / RAYS_PER_SAMPLE;
+                for (int k = 0; k < RAYS_PER_SAMPLE; ++k) {
+                    double angle = offset + k * TWO_PI / RAYS_PER_SAMPLE;
+                    traceRegions(map, pvs, x + 0.5, y + 0.5, std::cos(angle), std::sin(angle), row);
+                }
+            }
+        }
+    });
+    // Sampling can see A from B but miss the reverse; visibility is symmetric.
+    for (int a = 0; a < pvs.regionCount; ++a) {
+        for (int b = a + 1; b < pvs.regionCount; ++b) {
+            if (pvs.regionSees(a, b) != pvs.regionSees(b, a)) {
+                markRegion(&pvs.visible[a * pvs.rowWords], b);
+                markRegion(&pvs.visible[b * pvs.rowWords], a);
+            }
+        }
+    }
+    // Rays only sample each region, so a region glimpsed through a gap no ray hit could be missing. Growing
+    // every row by the neighbours of the regions it sees keeps culling on the safe side: whatever lies just
+    // past a visible region's openings stays in the set.
+    std::vector<Uint64> sampled = pvs.visible;
+    pool.parallelFor(pvs.regionCount, 16, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const Uint64* seen = &sampled[r * pvs.rowWords];
+            Uint64* row = &pvs.visible[r * pvs.rowWords];
+            for (int v = 0; v < pvs.regionCount; ++v) {
+                if ((seen[v >> 6] >> (v & 63)) & 1) {
+                    for (const auto& e : pvs.edges[v]) {
+                        markRegion(row, e.region);
+                    }
+                }
+            }
+        }
+    });
+    pvs.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return pvs;
+}
+
+void computeVisibleRegions(const PvsData& pvs, const std::vector<Door>& doors, double x, double y, VisibleRegions& out) {
+    out.pvs = &pvs;
+    out.all = true;
+    out.count = 0;
+    int cx = static_cast<int>(x);
+    int cy = static_cast<int>(y);
+    if (pvs.regionCount == 0 || cx < 0 || cy < 0 || cx >= pvs.width || cy >= pvs.height) {
+        return;
+    }
+    int cell = cy * pvs.width + cx;
+    int starts[2] = {pvs.regionOf[cell], -1};
+    if (pvs.doorOf[cell] >= 0) {
+        starts[0] = pvs.doorSides[pvs.doorOf[cell] * 2];
+        starts[1] = pvs.doorSides[pvs.doorOf[cell] * 2 + 1];
+    }
+    if (starts[0] < 0 && starts[1] < 0) {
+        return; // inside a wall (noclip); cull nothing
+    }
+
+    out.all = false;
+    out.bits.assign(pvs.rowWords, 0);
+    out.queue.clear();
+    for (int s : starts) {
+        if (s >= 0 && !out.containsRegion(s)) {
+            markRegion(out.bits.data(), s);
+            out.queue.push_back(s);
+        }
+    }
+    auto potentiallyVisible = [&](int r) {
+        return (starts[0] >= 0 && pvs.regionSees(starts[0], r)) || (starts[1] >= 0 && pvs.regionSees(starts[1], r));
+    };
+    for (size_t i = 0; i < out.queue.size(); ++i) {
+        for (const auto& e : pvs.edges[out.queue[i]]) {
+            if (out.containsRegion(e.region) || !potentiallyVisible(e.region)) {
+                continue;
+            }
+            if (e.door >= 0 && doors[e.door].openAmount <= 0.0) {
+                continue; // a fully closed door seals this edge
+            }
+            markRegion(out.bits.data(), e.region);
+            out.queue.push_back(e.region);
+        }
+    }
+    out.count = static_cast<int>(out.queue.size());
+}
@@ -0,0 +1,95 @@
+#include "raycast.h"
+
+#include <cmath>
+
+#include "doors.h"
+
+bool castRay(const Map& map, const std::vector<Door>& doors, double originX, double originY, double dirX, double dirY, double maxDist, RayHit& hit) {
+    int mapX = static_cast<int>(originX);
+    int mapY = static_cast<int>(originY);
+
+    double deltaDistX = (dirX == 0) ? 1e30 : std::abs(1.0 / dirX);
+    double deltaDistY = (dirY == 0) ? 1e30 : std::abs(1.0 / dirY);
+
+    double sideDistX;
+    double sideDistY;
+    int stepX;
+    int stepY;
+
+    if (dirX < 0) {
+        stepX = -1;
+        sideDistX = (originX - mapX) * deltaDistX;
+    } else {
+        stepX = 1;
+        sideDistX = (mapX + 1.0 - originX) * deltaDistX;
+    }
+
+    if (dirY < 0) {
+        stepY = -1;
+        sideDistY = (originY - mapY) * deltaDistY;
+    } else {
+        stepY = 1;
+        sideDistY = (mapY + 1.0 - originY) * deltaDistY;
+    }
+
+    bool side = false;
+    int steps = 0;
+    int doorTests = 0;
+    hit.crossedDoor = false;
+    for (;;) {
+        if (sideDistX < sideDistY) {
+            if (sideDistX > maxDist) {
+                break;
+            }
+            sideDistX += deltaDistX;
+            mapX += stepX;
+            side = false;
+        } else {
+            if (sideDistY > maxDist) {
+                break;
+            }
+            sideDistY += deltaDistY;
+            mapY += stepY;
+            side = true;
+        }
+        ++steps;
+
+        int tile = map.at(mapX, mapY);
+        if (tile == DOOR_TILE) {
+            const Door* door = findDoor(doors, mapX, mapY);
+            if (door && door->openAmount < 0.99) {
+                ++doorTests;
+                double dist;
+                bool doorSide;
+                if (computeDoorHit(*door, originX, originY, dirX, dirY, dist, doorSide) && dist <= maxDist) {
+                    hit.mapX = mapX;
+                    hit.mapY = mapY;
+                    hit.wallId = DOOR_TILE;
+                    hit.side = doorSide;
+                    hit.distance = dist;
+                    hit.door = door;
+                    hit.steps = steps;
+                    hit.doorTests = doorTests;
+                    return true;
+                }
+            }
+            hit.crossedDoor = true;
+            continue; // fully open or no intersection; keep marching
+        }
+
+        if (tile > 0) {
+            hit.mapX = mapX;
+            hit.mapY = mapY;
+            hit.wallId = tile;
+            hit.side = side;
+            hit.distance = side ? (sideDistY - deltaDistY) : (sideDistX - deltaDistX);
+            hit.door = nullptr;
+            hit.steps = steps;
+            hit.doorTests = doorTests;
+            return true;
+        }
+    }
+    hit.steps = steps;
+    hit.doorTests = doorTests;
+    return false;
+}
@@ -0,0 +1,24 @@
+#include "render_context.h"
+
+void* FrameArena::allocateBytes(size_t bytes, size_t align) {
+    size_t offset = (used_ + align - 1) & ~(align - 1);
+    used_ = offset + bytes;
+    if (used_ > highWater_) {
+        highWater_ = used_;
+    }
+    if (used_ <= capacity_) {
+        return block_.get() + offset;
+    }
+    overflow_.emplace_back(new unsigned char[bytes ? bytes : 1]);
+    return overflow_.back().get();
+}
+
+void FrameArena::reset() {
+    overflow_.clear();
+    if (highWater_ > capacity_) {
+        capacity_ = (highWater_ + 4095) & ~size_t(4095);
+        block_.reset(new unsigned char[capacity_]);
+        ++growCount_;
+    }
+    used_ = 0;
+}
@@ -0,0 +1,91 @@
+#include "render_diagnostics.h"
+
+#include <algorithm>
+
+#include "renderer.h"
+
+namespace {
+// Blue, green, yellow, red as t goes from 0 to 1.
+Uint32 heatColour(double t) {
+    static const Uint8 RAMP[4][3] = {{0, 40, 255}, {0, 220, 60}, {255, 230, 0}, {255, 20, 0}};
+    t = std::clamp(t, 0.0, 1.0) * 3.0;
+    int i = std::min(static_cast<int>(t), 2);
+    double f = t - i;
+    Uint32 r = static_cast<Uint32>(RAMP[i][0] + (RAMP[i + 1][0] - RAMP[i][0]) * f);
+    Uint32 g = static_cast<Uint32>(RAMP[i][1] + (RAMP[i + 1][1] - RAMP[i][1]) * f);
+    Uint32 b = static_cast<Uint32>(RAMP[i][2] + (RAMP[i + 1][2] - RAMP[i][2]) * f);
+    return (r << 16) | (g << 8) | b;
+}
+
+// Three quarters heat, one quarter of the scene's brightness so the geometry stays readable.
+Uint32 tint(Uint32 pixel, Uint32 heat) {
+    Uint32 grey = (((pixel >> 16) & 0xff) + ((pixel >> 8) & 0xff) + (pixel & 0xff)) / 12;
+    Uint32 r = ((heat >> 16) & 0xff) * 3 / 4 + grey;
+    Uint32 g = ((heat >> 8) & 0xff) * 3 / 4 + grey;
+    Uint32 b = (heat & 0xff) * 3 / 4 + grey;
+    return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+} // namespace
+
+void RenderDiagnostics::begin(int frameWidth, int frameHeight, const SDL_Rect* views, int viewCount) {
+    width = frameWidth;
+    height = frameHeight;
+    viewports.assign(views, views + viewCount);
+    columnOffset.resize(viewCount);
+    int columns = 0;
+    for (int v = 0; v < viewCount; ++v) {
+        columnOffset[v] = columns;
+        columns += views[v].w;
+    }
+    steps.assign(columns, 0);
+    doorTests.assign(columns, 0);
+    overdraw.assign(static_cast<size_t>(frameWidth) * frameHeight, 0);
+}
+
+void RenderDiagnostics::finish() {
+    DiagnosticTotals totals;
+    totals.columns = static_cast<unsigned>(steps.size());
+    for (size_t i = 0; i < steps.size(); ++i) {
+        totals.ddaSteps += steps[i];
+        totals.doorTests += doorTests[i];
+        totals.maxSteps = std::max(totals.maxSteps, steps[i]);
+        totals.maxDoorTests = std::max(totals.maxDoorTests, doorTests[i]);
+    }
+    for (uint8_t writes : overdraw) {
+        totals.pixelWrites += writes;
+        totals.pixels += writes != 0;
+        totals.maxOverdraw = std::max<unsigned>(totals.maxOverdraw, writes);
+    }
+    last = totals;
+    counted = true;
+}
+
+void drawDiagnosticOverlay(const RenderDiagnostics& diag, DiagOverlay overlay, const FrameTarget& target) {
+    if (overlay == DiagOverlay::Overdraw) {
+        for (int y = 0; y < std::min(diag.height, target.height); ++y) {
+            Uint32* row = target.pixels + y * target.pitch;
+            const uint8_t* writes = diag.overdraw.data() + static_cast<size_t>(y) * diag.width;
+            for (int x = 0; x < std::min(diag.width, target.width); ++x) {
+                if (writes[x] != 0) {
+                    row[x] = tint(row[x], heatColour((writes[x] - 1) / 3.0));
+                }
+            }
+        }
+        return;
+    }
+    if (overlay != DiagOverlay::Steps && overlay != DiagOverlay::Doors) {
+        return;
+    }
+    const std::vector<uint32_t>& counts = overlay == DiagOverlay::Steps ? diag.steps : diag.doorTests;
+    double scale = 1.0 / std::max(1u, overlay == DiagOverlay::Steps ? diag.last.maxSteps : diag.last.maxDoorTests);
+    for (size_t v = 0; v < diag.viewports.size(); ++v) {
+        const SDL_Rect& r = diag.viewports[v];
+        for (int x = 0; x < r.w; ++x) {
+            Uint32 heat = heatColour(counts[diag.columnOffset[v] + x] * scale);
+            Uint32* pixel = target.pixels + r.y * target.pitch + r.x + x;
+            for (int y = 0; y < r.h; ++y, pixel += target.pitch) {
+                *pixel = tint(*pixel, heat);
+            }
+        }
+    }
+}
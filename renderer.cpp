@@ -2,13 +2,22 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
-#include <sstream>
+#include <limits>
+#include <cstdio>
 #include <string>
+#include <string_view>
 
+#include "capture.h"
+#include "column_kernels.h"
 #include "doors.h"
+#include "entities.h"
+#include "raycast.h"
+#include "texture_residency.h"
 #include "textures.h"
+#include "thread_pool.h"
 
 namespace {
 // 8x8 bitmap font (font8x8_basic)
@@ -175,9 +184,8 @@ Color doorRenderColor(const Door& door, bool isSideHit) {
     return base;
 }
 
-bool isSpritePixelTransparent(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
-    // Support both alpha-transparent sprites and Lodev's "black is transparent" convention.
-    return a == 0 || (r == 0 && g == 0 && b == 0);
+Uint32 packColor(Color c) {
+    return 0xff000000u | (static_cast<Uint32>(c.r) << 16) | (static_cast<Uint32>(c.g) << 8) | c.b;
 }
 
 void drawChar(SDL_Renderer* renderer, int x, int y, char ch, int scale, Color color) {
@@ -195,7 +203,7 @@ void drawChar(SDL_Renderer* renderer, int x, int y, char ch, int scale, Color co
     }
 }
 
-int drawText(SDL_Renderer* renderer, int x, int y, const std::string& text, int scale, Color color) {
+int drawText(SDL_Renderer* renderer, int x, int y, std::string_view text, int scale, Color color) {
     int cursor = x;
     for (char ch : text) {
         drawChar(renderer, cursor, y, ch, scale, color);
@@ -229,14 +237,14 @@ void drawConsoleOverlay(const Config& cfg, SDL_Renderer* renderer, const Console
         y += lineHeight;
     }
 
-    std::string prompt = "> " + console.input;
-    int cursorX = drawText(renderer, padding, inputY, prompt, scale, {240, 240, 240});
+    int cursorX = drawText(renderer, padding, inputY, "> ", scale, {240, 240, 240});
+    cursorX = drawText(renderer, cursorX, inputY, console.input, scale, {240, 240, 240});
     SDL_SetRenderDrawColor(renderer, 240, 240, 240, 255);
     SDL_Rect cursor{cursorX, inputY, scale * 2, 8 * scale};
     SDL_RenderFillRect(renderer, &cursor);
 }
 
-void drawMinimap(const Map& map, const Player& player, SDL_Renderer* renderer, int size, int margin) {
+void drawMinimap(const Map& map, const Player& player, SDL_Renderer* renderer, int size, int margin, const VisibleRegions* visible) {
     int x0 = margin;
     int y0 = margin;
     SDL_Rect bg{x0, y0, size, size};
@@ -278,10 +286,28 @@ void drawMinimap(const Map& map, const Player& player, SDL_Renderer* renderer, i
         SDL_RenderDrawLine(renderer, blx, bly, tlx, tly);
     };
 
-    for (int y = 0; y < map.height; ++y) {
-        for (int x = 0; x < map.width; ++x) {
+    // Only cells that can land inside the clip rect, and only walls bordering potentially visible floor.
+    int reach = static_cast<int>(size * 0.7072 / scale) + 1;
+    int minX = std::max(0, static_cast<int>(player.x) - reach);
+    int maxX = std::min(map.width - 1, static_cast<int>(player.x) + reach);
+    int minY = std::max(0, static_cast<int>(player.y) - reach);
+    int maxY = std::min(map.height - 1, static_cast<int>(player.y) + reach);
+    auto tileInView = [&](int x, int y, int tile) {
+        if (!visible || visible->all || tile == DOOR_TILE) {
+            return !visible || visible->containsCell(x, y);
+        }
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (visible->containsCell(x + dx, y + dy)) return true;
+            }
+        }
+        return false;
+    };
+
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
             int tile = map.tiles[y * map.width + x];
-            if (tile == 0) continue;
+            if (tile == 0 || !tileInView(x, y, tile)) continue;
             SDL_Color color = (tile == DOOR_TILE) ? SDL_Color{230, 200, 40, 255} : SDL_Color{240, 240, 240, 255};
             drawTile(x, y, color);
         }
@@ -297,188 +323,363 @@ void drawMinimap(const Map& map, const Player& player, SDL_Renderer* renderer, i
 }
 } // namespace
 
-void renderFrame(const Map& map, const std::vector<Door>& doors, const std::vector<Sprite>& sprites, const Player& player, const Config& cfg, SDL_Renderer* renderer, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps) {
-    SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
-    SDL_RenderClear(renderer);
+namespace {
+const int COLUMN_BLOCK = 16; // columns per scheduled task; small enough to balance four views on a few cores
+
+// A sprite already projected into one view, so column tasks only clip and sample.
+struct ProjectedSprite {
+    SDL_Surface* surface;
+    double depth;
+    int left; // unclamped first column; texture u is measured from here
+    int width;
+    int height;
+    int startX;
+    int endX;
+    int startY;
+    int endY;
+    LightLevel light;
+};
 
-    SDL_Rect skyRect{0, 0, cfg.screenWidth, cfg.screenHeight / 2};
-    SDL_SetRenderDrawColor(renderer, 60, 60, 90, 255);
-    SDL_RenderFillRect(renderer, &skyRect);
+// Per-view state shared read-only by that view's column tasks (zBuffer excepted: each task owns its columns).
+struct ViewPass {
+    FrameTarget target;
+    const Player* camera;
+    double* zBuffer;
+    const ProjectedSprite* sprites;
+    int spriteCount;
+    // Diagnostic counters for this view's columns, used only by the Count instantiations below.
+    uint32_t* steps;
+    uint32_t* doorTests;
+    Uint8* overdraw; // at the view's top-left pixel
+    int overdrawPitch;
+};
 
-    // Floor gradient
-    for (int y = cfg.screenHeight / 2; y < cfg.screenHeight; ++y) {
-        Uint8 shade = static_cast<Uint8>(40 + 80.0 * (y - cfg.screenHeight / 2) / (cfg.screenHeight / 2));
-        SDL_SetRenderDrawColor(renderer, shade, shade, shade, 255);
-        SDL_RenderDrawLine(renderer, 0, y, cfg.screenWidth, y);
-    }
+struct ColumnTask {
+    int view;
+    int begin;
+    int end;
+};
 
-    std::vector<double> zBuffer(cfg.screenWidth, 0.0);
+void drawBackground(const FrameTarget& target, int begin, int end) {
+    const int screenH = target.height;
+    // Sky, then the floor gradient.
+    const Uint32 sky = packColor({60, 60, 90});
+    if (target.pitch == 1) {
+        // Column-major: build the first column, then copy it across the block.
+        Uint32* first = target.pixels + begin * target.step;
+        std::fill_n(first, screenH / 2, sky);
+        for (int y = screenH / 2; y < screenH; ++y) {
+            Uint8 shade = static_cast<Uint8>(40 + 80.0 * (y - screenH / 2) / (screenH / 2));
+            first[y] = packColor({shade, shade, shade});
+        }
+        for (int x = begin + 1; x < end; ++x) {
+            std::copy_n(first, screenH, target.pixels + x * target.step);
+        }
+        return;
+    }
+    for (int y = 0; y < screenH / 2; ++y) {
+        std::fill_n(target.pixels + y * target.pitch + begin, end - begin, sky);
+    }
+    for (int y = screenH / 2; y < screenH; ++y) {
+        Uint8 shade = static_cast<Uint8>(40 + 80.0 * (y - screenH / 2) / (screenH / 2));
+        std::fill_n(target.pixels + y * target.pitch + begin, end - begin, packColor({shade, shade, shade}));
+    }
+}
 
-    for (int x = 0; x < cfg.screenWidth; ++x) {
-        double cameraX = 2.0 * x / cfg.screenWidth - 1.0;
-        double rayDirX = player.dirX + player.planeX * cameraX;
-        double rayDirY = player.dirY + player.planeY * cameraX;
+void columnRay(const ViewPass& view, int x, double& rayDirX, double& rayDirY) {
+    const Player& player = *view.camera;
+    double cameraX = 2.0 * x / view.target.width - 1.0;
+    rayDirX = player.dirX + player.planeX * cameraX;
+    rayDirY = player.dirY + player.planeY * cameraX;
+}
 
-        int mapX = static_cast<int>(player.x);
-        int mapY = static_cast<int>(player.y);
+// Draws column x of a wall or door hit. `lights` is null when lighting is off. Count also tallies the
+// column's pixel writes.
+template <bool Count>
+void drawWallColumn(const Config& cfg, const TextureManager& tm, const Lightmap* lights, const ViewPass& view, int x, const RayHit& rayHit, double rayDirX, double rayDirY) {
+    const Player& player = *view.camera;
+    const FrameTarget& target = view.target;
+    const int screenH = target.height;
+
+    bool side = rayHit.side;
+    int wallId = rayHit.wallId;
+    const Door* hitDoor = rayHit.door;
+
+    double perpWallDist = rayHit.distance;
+    if (perpWallDist <= 0.0001) {
+        perpWallDist = 0.0001;
+    }
+    int lineHeight = static_cast<int>(cfg.wallHeight * screenH / perpWallDist);
+    int drawStart = -lineHeight / 2 + screenH / 2;
+    int drawEnd = lineHeight / 2 + screenH / 2;
+
+    double hitX = player.x + perpWallDist * rayDirX;
+    double hitY = player.y + perpWallDist * rayDirY;
+    double wallX;
+    if (hitDoor) {
+        if (hitDoor->vertical) {
+            double offsetY = hitDoor->y + hitDoor->openAmount;
+            wallX = hitY - offsetY;
+        } else {
+            double offsetX = hitDoor->x + hitDoor->openAmount;
+            wallX = hitX - offsetX;
+        }
+        wallX -= std::floor(wallX);
+    } else {
+        wallX = side ? hitX : hitY;
+        wallX -= std::floor(wallX);
+    }
 
-        double deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1.0 / rayDirX);
-        double deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1.0 / rayDirY);
+    SDL_Surface* surf = nullptr;
+    if (cfg.textureMode != TextureMode::Flat && wallId >= 0 && wallId < static_cast<int>(tm.textures.size())) {
+        surf = tm.textures[wallId];
+        if (tm.residency) {
+            tm.residency->markUsed(wallId);
+        }
+    }
+    if (surf && cfg.textureMode == TextureMode::Mipmapped && wallId < static_cast<int>(tm.textureMips.size())) {
+        // Pick the level whose texel density matches this column's on-screen height.
+        const auto& chain = tm.textureMips[wallId];
+        surf = chain[selectMipLevel(static_cast<double>(surf->h) / lineHeight, static_cast<int>(chain.size()))];
+    }
+    int texW = surf ? surf->w : 1;
+    int texH = surf ? surf->h : 1;
+    int texX = static_cast<int>(wallX * texW);
+    if (!side && rayDirX > 0) {
+        texX = texW - texX - 1;
+    }
+    if (side && rayDirY < 0) {
+        texX = texW - texX - 1;
+    }
+    // Mirror door texture when viewed from the back side.
+    bool mirrorDoor = hitDoor && (hitDoor->vertical ? (rayDirX > 0) : (rayDirY > 0));
+    if (mirrorDoor) {
+        texX = texW - texX - 1;
+    }
 
-        double sideDistX;
-        double sideDistY;
-        int stepX;
-        int stepY;
+    double texStep = static_cast<double>(texH) / lineHeight;
+    double texPos = (drawStart - screenH / 2 + lineHeight / 2) * texStep;
+    // One baked level per column, with the side shade folded in.
+    Uint32 lightR = 256, lightG = 256, lightB = 256;
+    if (lights) {
+        const LightLevel& level = hitDoor ? lights->cell(rayHit.mapX, rayHit.mapY)
+                                          : lights->face(rayHit.mapX, rayHit.mapY, faceForHit(side, rayDirX, rayDirY));
+        Uint32 shade = side ? 179 : 256;
+        lightR = (level.r * shade) >> 8;
+        lightG = (level.g * shade) >> 8;
+        lightB = (level.b * shade) >> 8;
+    }
 
-        if (rayDirX < 0) {
-            stepX = -1;
-            sideDistX = (player.x - mapX) * deltaDistX;
-        } else {
-            stepX = 1;
-            sideDistX = (mapX + 1.0 - player.x) * deltaDistX;
+    // Textures are ARGB8888 (loadTextures converts), so the kernels read texels directly.
+    WallColumn column;
+    column.dst = target.pixels + x * target.step;
+    column.pitch = target.pitch;
+    column.screenH = screenH;
+    column.drawStart = drawStart;
+    column.drawEnd = drawEnd;
+    column.texels = nullptr;
+    column.texStride = 0;
+    column.texH = texH;
+    column.texPos = texPos;
+    column.texStep = texStep;
+    column.flat = surf ? Color{} : (hitDoor ? doorRenderColor(*hitDoor, side) : wallColor(wallId, side));
+    column.lightR = lightR;
+    column.lightG = lightG;
+    column.lightB = lightB;
+    if (surf) {
+        column.texStride = surf->pitch / static_cast<int>(sizeof(Uint32));
+        column.texels = static_cast<const Uint32*>(surf->pixels) + std::clamp(texX, 0, texW - 1);
+    }
+    WallShade shade = lights ? WallShade::Lit : (side ? WallShade::Side : WallShade::None);
+    selectWallKernel(surf != nullptr, shade, drawStart < 0 || drawEnd >= screenH)(column);
+    view.zBuffer[x] = perpWallDist;
+    if constexpr (Count) {
+        Uint8* writes = view.overdraw + x;
+        for (int y = std::max(drawStart, 0); y <= std::min(drawEnd, screenH - 1); ++y) {
+            Uint8& count = writes[y * view.overdrawPitch];
+            count = static_cast<Uint8>(count + (count < 255));
         }
+    }
+}
 
-        if (rayDirY < 0) {
-            stepY = -1;
-            sideDistY = (player.y - mapY) * deltaDistY;
-        } else {
-            stepY = 1;
-            sideDistY = (mapY + 1.0 - player.y) * deltaDistY;
-        }
-
-        bool hit = false;
-        bool side = false;
-        int wallId = 0;
-        double doorHitDist = -1.0;
-        const Door* hitDoor = nullptr;
-        while (!hit) {
-            if (sideDistX < sideDistY) {
-                sideDistX += deltaDistX;
-                mapX += stepX;
-                side = false;
-            } else {
-                sideDistY += deltaDistY;
-                mapY += stepY;
-                side = true;
-            }
+struct ColumnCast {
+    RayHit hit;
+    bool found;
+};
 
-            int tile = map.at(mapX, mapY);
-            if (tile == DOOR_TILE) {
-                const Door* door = findDoor(doors, mapX, mapY);
-                if (door && door->openAmount < 0.99) {
-                    double dist;
-                    bool doorSide;
-                    if (computeDoorHit(*door, player, rayDirX, rayDirY, dist, doorSide)) {
-                        hit = true;
-                        wallId = DOOR_TILE;
-                        doorHitDist = dist;
-                        side = doorSide;
-                        hitDoor = door;
-                    }
-                }
-                if (!hit) {
-                    continue; // fully open or no intersection; keep marching
-                }
-            }
+template <bool Count>
+ColumnCast castColumn(const Map& map, const std::vector<Door>& doors, const ViewPass& view, int x, double& rayDirX, double& rayDirY) {
+    const Player& player = *view.camera;
+    columnRay(view, x, rayDirX, rayDirY);
+    ColumnCast c;
+    c.found = castRay(map, doors, player.x, player.y, rayDirX, rayDirY, std::numeric_limits<double>::infinity(), c.hit);
+    if constexpr (Count) {
+        view.steps[x] += static_cast<uint32_t>(c.hit.steps);
+        view.doorTests[x] += static_cast<uint32_t>(c.hit.doorTests);
+    }
+    return c;
+}
 
-            if (tile > 0 && tile != DOOR_TILE) {
-                hit = true;
-                wallId = tile;
-            }
-        }
+// Rays at both ends met the same wall face with no door on the way, so every ray between them meets it too:
+// anything closer that could block part of the face is at least a tile wide and would cover a wider angle.
+bool sameWallFace(const ColumnCast& a, const ColumnCast& b) {
+    return a.found && b.found && !a.hit.door && !b.hit.door && !a.hit.crossedDoor && !b.hit.crossedDoor &&
+           a.hit.mapX == b.hit.mapX && a.hit.mapY == b.hit.mapY && a.hit.side == b.hit.side;
+}
 
-        double perpWallDist = (doorHitDist > 0.0) ? doorHitDist
-                                                 : (side ? (sideDistY - deltaDistY) : (sideDistX - deltaDistX));
-        if (perpWallDist <= 0.0001) {
-            perpWallDist = 0.0001;
-        }
-        int lineHeight = static_cast<int>(cfg.wallHeight * cfg.screenHeight / perpWallDist);
-        int drawStart = -lineHeight / 2 + cfg.screenHeight / 2;
-        int drawEnd = lineHeight / 2 + cfg.screenHeight / 2;
-
-        double hitX = player.x + perpWallDist * rayDirX;
-        double hitY = player.y + perpWallDist * rayDirY;
-        double wallX;
-        if (hitDoor) {
-            if (hitDoor->vertical) {
-                double offsetY = hitDoor->y + hitDoor->openAmount;
-                wallX = hitY - offsetY;
-            } else {
-                double offsetX = hitDoor->x + hitDoor->openAmount;
-                wallX = hitX - offsetX;
-            }
-            wallX -= std::floor(wallX);
-        } else {
-            wallX = side ? hitX : hitY;
-            wallX -= std::floor(wallX);
-        }
+// Intersects a ray with a face already known to be in front of it, as castRay would report the hit.
+RayHit hitOnFace(const RayHit& face, const Player& player, double rayDirX, double rayDirY) {
+    RayHit hit = face;
+    if (face.side) {
+        double planeY = face.mapY + (rayDirY < 0 ? 1.0 : 0.0);
+        hit.distance = (planeY - player.y) / rayDirY;
+    } else {
+        double planeX = face.mapX + (rayDirX < 0 ? 1.0 : 0.0);
+        hit.distance = (planeX - player.x) / rayDirX;
+    }
+    return hit;
+}
 
-        SDL_Surface* surf = nullptr;
-        if (wallId >= 0 && wallId < static_cast<int>(tm.textures.size())) {
-            surf = tm.textures[wallId];
-        }
-        int texW = surf ? surf->w : 1;
-        int texH = surf ? surf->h : 1;
-        int texX = static_cast<int>(wallX * texW);
-        if (!side && rayDirX > 0) {
-            texX = texW - texX - 1;
-        }
-        if (side && rayDirY < 0) {
-            texX = texW - texX - 1;
-        }
-        // Mirror door texture when viewed from the back side.
-        bool mirrorDoor = hitDoor && (hitDoor->vertical ? (rayDirX > 0) : (rayDirY > 0));
-        if (mirrorDoor) {
-            texX = texW - texX - 1;
+// Columns strictly between x0 and x1, whose casts are a and b, are either solved on a shared face or split.
+template <bool Count>
+void refineSpan(const Map& map, const std::vector<Door>& doors, const Config& cfg, const TextureManager& tm, const Lightmap* lights, const ViewPass& view,
+                int x0, const ColumnCast& a, int x1, const ColumnCast& b, unsigned& rays) {
+    if (x1 - x0 < 2) {
+        return;
+    }
+    double rayDirX, rayDirY;
+    if (sameWallFace(a, b)) {
+        for (int x = x0 + 1; x < x1; ++x) {
+            columnRay(view, x, rayDirX, rayDirY);
+            drawWallColumn<Count>(cfg, tm, lights, view, x, hitOnFace(a.hit, *view.camera, rayDirX, rayDirY), rayDirX, rayDirY);
         }
+        return;
+    }
+    int mid = (x0 + x1) / 2;
+    ColumnCast m = castColumn<Count>(map, doors, view, mid, rayDirX, rayDirY);
+    ++rays;
+    drawWallColumn<Count>(cfg, tm, lights, view, mid, m.hit, rayDirX, rayDirY);
+    refineSpan<Count>(map, doors, cfg, tm, lights, view, x0, a, mid, m, rays);
+    refineSpan<Count>(map, doors, cfg, tm, lights, view, mid, m, x1, b, rays);
+}
 
-        double texStep = static_cast<double>(texH) / lineHeight;
-        double texPos = (drawStart - cfg.screenHeight / 2 + lineHeight / 2) * texStep;
+// Draws wall columns [begin, end) and returns how many rays were cast.
+template <bool Count>
+unsigned drawWalls(const Map& map, const std::vector<Door>& doors, const Config& cfg, const TextureManager& tm, const Lightmap* lights, const ViewPass& view, int begin, int end) {
+    double rayDirX, rayDirY;
+    if (!cfg.wallSpans || end - begin < 3) {
+        for (int x = begin; x < end; ++x) {
+            ColumnCast c = castColumn<Count>(map, doors, view, x, rayDirX, rayDirY);
+            drawWallColumn<Count>(cfg, tm, lights, view, x, c.hit, rayDirX, rayDirY);
+        }
+        return static_cast<unsigned>(end - begin);
+    }
+    // Cast the block's end columns, then bisect only where they disagree about the face.
+    ColumnCast first = castColumn<Count>(map, doors, view, begin, rayDirX, rayDirY);
+    drawWallColumn<Count>(cfg, tm, lights, view, begin, first.hit, rayDirX, rayDirY);
+    ColumnCast last = castColumn<Count>(map, doors, view, end - 1, rayDirX, rayDirY);
+    drawWallColumn<Count>(cfg, tm, lights, view, end - 1, last.hit, rayDirX, rayDirY);
+    unsigned rays = 2;
+    refineSpan<Count>(map, doors, cfg, tm, lights, view, begin, first, end - 1, last, rays);
+    return rays;
+}
 
-        for (int y = drawStart; y <= drawEnd; ++y) {
-            if (y < 0 || y >= cfg.screenHeight) {
-                texPos += texStep;
+// Draws the parts of the view's sprites, far to near, that fall in columns [begin, end).
+template <bool Count>
+void drawSpriteColumns(const ViewPass& view, bool lit, int begin, int end) {
+    const FrameTarget& target = view.target;
+    const int screenH = target.height;
+    const SpriteKernel kernel = selectSpriteKernel(lit);
+    for (int n = 0; n < view.spriteCount; ++n) {
+        const ProjectedSprite& s = view.sprites[n];
+        SDL_Surface* spriteSurf = s.surface;
+        int first = std::max(s.startX, begin);
+        int last = std::min(s.endX, end - 1);
+        SpriteStripe stripeInfo;
+        stripeInfo.pitch = target.pitch;
+        stripeInfo.screenH = screenH;
+        stripeInfo.startY = s.startY;
+        stripeInfo.endY = s.endY;
+        stripeInfo.spriteHeight = s.height;
+        stripeInfo.texStride = spriteSurf->pitch / static_cast<int>(sizeof(Uint32));
+        stripeInfo.texH = spriteSurf->h;
+        stripeInfo.light = s.light;
+        for (int stripe = first; stripe <= last; ++stripe) {
+            if (s.depth >= view.zBuffer[stripe]) {
                 continue;
             }
-            int texY = static_cast<int>(texPos) & (texH - 1);
-            texPos += texStep;
-            Color c = surf ? sampleTexture(surf, texX, texY)
-                           : (hitDoor ? doorRenderColor(*hitDoor, side) : wallColor(wallId, side));
-            if (side) {
-                c.r = static_cast<Uint8>(c.r * 0.7);
-                c.g = static_cast<Uint8>(c.g * 0.7);
-                c.b = static_cast<Uint8>(c.b * 0.7);
+            int texX = static_cast<int>((stripe - s.left) * spriteSurf->w / static_cast<double>(s.width));
+            stripeInfo.dst = target.pixels + stripe * target.step;
+            stripeInfo.texels = static_cast<const Uint32*>(spriteSurf->pixels) + std::clamp(texX, 0, spriteSurf->w - 1);
+            kernel(stripeInfo);
+            if constexpr (Count) {
+                countSpriteStripe(stripeInfo, view.overdraw + stripe, view.overdrawPitch);
             }
-            SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, 255);
-            SDL_RenderDrawPoint(renderer, x, y);
         }
-        zBuffer[x] = perpWallDist;
     }
+}
+
+// One scheduled block of columns: background, walls, then sprites. Returns the rays cast.
+template <bool Count>
+unsigned drawColumnBlock(const Map& map, const std::vector<Door>& doors, const Config& cfg, const TextureManager& tm, const Lightmap* lights, const ViewPass& pass, const ColumnTask& task) {
+    drawBackground(pass.target, task.begin, task.end);
+    if constexpr (Count) {
+        for (int y = 0; y < pass.target.height; ++y) {
+            std::fill(pass.overdraw + y * pass.overdrawPitch + task.begin, pass.overdraw + y * pass.overdrawPitch + task.end, Uint8{1});
+        }
+    }
+    unsigned rays = drawWalls<Count>(map, doors, cfg, tm, lights, pass, task.begin, task.end);
+    drawSpriteColumns<Count>(pass, lights != nullptr, task.begin, task.end);
+    return rays;
+}
 
-    std::vector<int> spriteOrder(sprites.size());
-    std::vector<double> spriteDistance(sprites.size(), 0.0);
-    for (size_t i = 0; i < sprites.size(); ++i) {
-        spriteOrder[i] = static_cast<int>(i);
-        double dx = player.x - sprites[i].x;
-        double dy = player.y - sprites[i].y;
+template <bool Count>
+void drawColumnTasks(ThreadPool& pool, const Map& map, const std::vector<Door>& doors, const Config& cfg, const TextureManager& tm, const Lightmap* lights,
+                     const ViewPass* passes, const ColumnTask* tasks, int taskCount, unsigned* taskRays) {
+    pool.parallelFor(taskCount, 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            taskRays[t] = drawColumnBlock<Count>(map, doors, cfg, tm, lights, passes[tasks[t].view], tasks[t]);
+        }
+    });
+}
+
+// Sorts the view's sprites far to near and projects them once, before the column pass.
+int projectSprites(FrameArena& arena, const EntityStore& entities, const Config& cfg, const TextureManager& tm, const Lightmap* lights, const RenderView& view, int screenW, int screenH, ProjectedSprite*& out) {
+    const Player& player = view.camera;
+    int* spriteOrder = arena.allocate<int>(entities.size());
+    double* spriteDistance = arena.allocate<double>(entities.size());
+    int spriteCount = 0;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (!(entities.flags[i] & ENTITY_VISIBLE)) {
+            continue;
+        }
+        if (view.visible && !view.visible->containsCell(static_cast<int>(entities.x[i]), static_cast<int>(entities.y[i]))) {
+            continue;
+        }
+        spriteOrder[spriteCount++] = static_cast<int>(i);
+        double dx = player.x - entities.x[i];
+        double dy = player.y - entities.y[i];
         spriteDistance[i] = dx * dx + dy * dy;
     }
-    std::sort(spriteOrder.begin(), spriteOrder.end(), [&](int a, int b) {
+    std::sort(spriteOrder, spriteOrder + spriteCount, [&](int a, int b) {
         return spriteDistance[a] > spriteDistance[b];
     });
 
-    for (int i : spriteOrder) {
-        const Sprite& sprite = sprites[i];
-        if (sprite.textureId < 0 || sprite.textureId >= static_cast<int>(tm.spriteTextures.size())) {
+    out = arena.allocate<ProjectedSprite>(spriteCount);
+    int projected = 0;
+    for (int n = 0; n < spriteCount; ++n) {
+        int i = spriteOrder[n];
+        int textureId = entities.textureId[i];
+        if (textureId < 0 || textureId >= static_cast<int>(tm.spriteTextures.size())) {
             continue;
         }
-        SDL_Surface* spriteSurf = tm.spriteTextures[sprite.textureId];
+        SDL_Surface* spriteSurf = tm.spriteTextures[textureId];
         if (!spriteSurf) {
             continue;
         }
 
-        double spriteX = sprite.x - player.x;
-        double spriteY = sprite.y - player.y;
+        double spriteX = entities.x[i] - player.x;
+        double spriteY = entities.y[i] - player.y;
 
         double invDet = 1.0 / (player.planeX * player.dirY - player.dirX * player.planeY);
         double transformX = invDet * (player.dirY * spriteX - player.dirX * spriteY);
@@ -487,60 +688,216 @@ void renderFrame(const Map& map, const std::vector<Door>& doors, const std::vect
             continue;
         }
 
-        int spriteScreenX = static_cast<int>((cfg.screenWidth / 2.0) * (1.0 + transformX / transformY));
-        int spriteHeight = std::abs(static_cast<int>(cfg.screenHeight / transformY));
+        int spriteScreenX = static_cast<int>((screenW / 2.0) * (1.0 + transformX / transformY));
+        int spriteHeight = std::abs(static_cast<int>(screenH / transformY));
         if (spriteHeight <= 0) {
             continue;
         }
-        int drawStartY = std::max(-spriteHeight / 2 + cfg.screenHeight / 2, 0);
-        int drawEndY = std::min(spriteHeight / 2 + cfg.screenHeight / 2, cfg.screenHeight - 1);
-
-        int spriteWidth = std::abs(static_cast<int>(cfg.screenHeight / transformY));
+        int spriteWidth = std::abs(static_cast<int>(screenH / transformY));
         if (spriteWidth <= 0) {
             continue;
         }
-        int drawStartX = std::max(-spriteWidth / 2 + spriteScreenX, 0);
-        int drawEndX = std::min(spriteWidth / 2 + spriteScreenX, cfg.screenWidth - 1);
 
-        for (int stripe = drawStartX; stripe <= drawEndX; ++stripe) {
-            int texX = static_cast<int>((stripe - (-spriteWidth / 2 + spriteScreenX)) * spriteSurf->w / static_cast<double>(spriteWidth));
-            if (stripe < 0 || stripe >= cfg.screenWidth) {
-                continue;
-            }
-            if (transformY >= zBuffer[stripe]) {
-                continue;
-            }
+        if (cfg.textureMode == TextureMode::Mipmapped && textureId < static_cast<int>(tm.spriteMips.size())) {
+            const auto& chain = tm.spriteMips[textureId];
+            spriteSurf = chain[selectMipLevel(static_cast<double>(spriteSurf->h) / spriteHeight, static_cast<int>(chain.size()))];
+        }
 
-            for (int y = drawStartY; y <= drawEndY; ++y) {
-                int d = (y * 256) - (cfg.screenHeight * 128) + (spriteHeight * 128);
-                int texY = ((d * spriteSurf->h) / spriteHeight) / 256;
-                Uint32 pixel = sampleTextureRaw(spriteSurf, texX, texY);
-                Uint8 r, g, b, a;
-                SDL_GetRGBA(pixel, spriteSurf->format, &r, &g, &b, &a);
-                if (isSpritePixelTransparent(r, g, b, a)) {
-                    continue;
-                }
-                SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-                SDL_RenderDrawPoint(renderer, stripe, y);
-            }
+        ProjectedSprite& s = out[projected++];
+        s.surface = spriteSurf;
+        s.depth = transformY;
+        s.left = -spriteWidth / 2 + spriteScreenX;
+        s.width = spriteWidth;
+        s.height = spriteHeight;
+        s.startX = std::max(s.left, 0);
+        s.endX = std::min(spriteWidth / 2 + spriteScreenX, screenW - 1);
+        s.startY = std::max(-spriteHeight / 2 + screenH / 2, 0);
+        s.endY = std::min(spriteHeight / 2 + screenH / 2, screenH - 1);
+        // Light sprites are emitters and stay full bright.
+        s.light = LightLevel{256, 256, 256};
+        if (lights && textureId != LIGHT_SPRITE_ID) {
+            s.light = lights->cell(static_cast<int>(entities.x[i]), static_cast<int>(entities.y[i]));
+        }
+    }
+    return projected;
+}
+} // namespace
+
+void renderWorld(const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const VisibleRegions* visible, const Lightmap* lightmap) {
+    RenderContext rc;
+    renderWorld(rc, map, doors, entities, player, cfg, tm, target, visible, lightmap);
+}
+
+void renderWorld(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const VisibleRegions* visible, const Lightmap* lightmap) {
+    RenderView view{player, {0, 0, target.width, target.height}, visible};
+    renderViews(rc, map, doors, entities, &view, 1, cfg, tm, target, lightmap);
+}
+
+void renderViews(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const RenderView* views, int viewCount, const Config& cfg, const TextureManager& tm, const FrameTarget& target, const Lightmap* lightmap) {
+    rc.arena.reset();
+    const Lightmap* lights = cfg.lighting ? lightmap : nullptr;
+
+    // Everything the column pass touches is carved from the arena up front; workers never allocate.
+    ViewPass* passes = rc.arena.allocate<ViewPass>(viewCount);
+    bool counting = false;
+#if RAYCASTER_DIAGNOSTICS
+    counting = cfg.diagnostics != DiagOverlay::Off;
+    if (counting) {
+        SDL_Rect* viewports = rc.arena.allocate<SDL_Rect>(viewCount);
+        for (int v = 0; v < viewCount; ++v) {
+            viewports[v] = views[v].viewport;
+        }
+        rc.diagnostics.begin(target.width, target.height, viewports, viewCount);
+    }
+#endif
+    int taskCount = 0;
+    rc.lastFrameSprites = 0;
+    for (int v = 0; v < viewCount; ++v) {
+        const SDL_Rect& r = views[v].viewport;
+        ViewPass& pass = passes[v];
+        pass.target = FrameTarget{target.pixels + r.y * target.pitch + r.x * target.step, r.w, r.h, target.pitch, target.step};
+        pass.camera = &views[v].camera;
+        pass.zBuffer = rc.arena.allocate<double>(r.w);
+        ProjectedSprite* sprites = nullptr;
+        pass.spriteCount = projectSprites(rc.arena, entities, cfg, tm, lights, views[v], r.w, r.h, sprites);
+        pass.sprites = sprites;
+        rc.lastFrameSprites += static_cast<unsigned>(pass.spriteCount);
+        pass.steps = nullptr;
+        pass.doorTests = nullptr;
+        pass.overdraw = nullptr;
+        pass.overdrawPitch = 0;
+        if (counting) {
+            RenderDiagnostics& diag = rc.diagnostics;
+            pass.steps = diag.steps.data() + diag.columnOffset[v];
+            pass.doorTests = diag.doorTests.data() + diag.columnOffset[v];
+            pass.overdraw = diag.overdraw.data() + r.y * diag.width + r.x;
+            pass.overdrawPitch = diag.width;
+        }
+        taskCount += (r.w + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    }
+    ColumnTask* tasks = rc.arena.allocate<ColumnTask>(taskCount);
+    taskCount = 0;
+    for (int v = 0; v < viewCount; ++v) {
+        for (int x = 0; x < passes[v].target.width; x += COLUMN_BLOCK) {
+            tasks[taskCount++] = ColumnTask{v, x, std::min(x + COLUMN_BLOCK, passes[v].target.width)};
+        }
+    }
+
+    unsigned* taskRays = rc.arena.allocate<unsigned>(taskCount);
+
+    // All views' column blocks share one schedule, so small views fill the cores as well as one large one.
+    ThreadPool& pool = rc.pool ? *rc.pool : workerPool();
+#if RAYCASTER_DIAGNOSTICS
+    if (counting) {
+        drawColumnTasks<true>(pool, map, doors, cfg, tm, lights, passes, tasks, taskCount, taskRays);
+        rc.diagnostics.finish();
+    } else
+#endif
+    {
+        drawColumnTasks<false>(pool, map, doors, cfg, tm, lights, passes, tasks, taskCount, taskRays);
+    }
+    rc.lastFrameRays = 0;
+    for (int t = 0; t < taskCount; ++t) {
+        rc.lastFrameRays += taskRays[t];
+    }
+}
+
+int splitScreenLayout(int width, int height, int views, SDL_Rect* out) {
+    if (views >= 4) {
+        int halfW = width / 2;
+        int halfH = height / 2;
+        out[0] = {0, 0, halfW, halfH};
+        out[1] = {halfW, 0, width - halfW, halfH};
+        out[2] = {0, halfH, halfW, height - halfH};
+        out[3] = {halfW, halfH, width - halfW, height - halfH};
+        return 4;
+    }
+    if (views >= 2) {
+        int halfH = height / 2;
+        out[0] = {0, 0, width, halfH};
+        out[1] = {0, halfH, width, height - halfH};
+        return 2;
+    }
+    out[0] = {0, 0, width, height};
+    return 1;
+}
+
+Player cameraForViewport(const Player& camera, int fullWidth, int fullHeight, const SDL_Rect& viewport) {
+    // Walls and sprites scale with viewport height, so the plane follows the change in aspect ratio.
+    double scale = (static_cast<double>(viewport.w) / viewport.h) / (static_cast<double>(fullWidth) / fullHeight);
+    Player fitted = camera;
+    fitted.planeX *= scale;
+    fitted.planeY *= scale;
+    return fitted;
+}
+
+void renderFrame(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const Player& player, const Config& cfg, const SDLContext& ctx, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps, const VisibleRegions* visible, const Lightmap* lightmap) {
+    RenderView view{cameraForViewport(player, cfg.screenWidth, cfg.screenHeight, {0, 0, ctx.frameWidth, ctx.frameHeight}), {0, 0, ctx.frameWidth, ctx.frameHeight}, visible};
+    renderFrame(rc, map, doors, entities, &view, 1, cfg, ctx, tm, console, showMinimap, fps, lightmap);
+}
+
+void renderFrame(RenderContext& rc, const Map& map, const std::vector<Door>& doors, const EntityStore& entities, const RenderView* views, int viewCount, const Config& cfg, const SDLContext& ctx, const TextureManager& tm, const ConsoleState& console, bool showMinimap, double fps, const Lightmap* lightmap) {
+    AllocationCountScope counting;
+    AllocationCounters allocStart = allocationCounters();
+    SDL_Renderer* renderer = ctx.renderer;
+    SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
+    SDL_RenderClear(renderer);
+
+    // The 3D view is written straight into the streaming texture (frameWidth x frameHeight, stretched to the
+    // window on copy), overlays are drawn on top at window resolution.
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (ctx.frameTexture && SDL_LockTexture(ctx.frameTexture, nullptr, &pixels, &pitch) == 0) {
+        FrameTarget target{static_cast<Uint32*>(pixels), ctx.frameWidth, ctx.frameHeight, pitch / static_cast<int>(sizeof(Uint32))};
+        auto viewsStart = std::chrono::steady_clock::now();
+        if (cfg.columnMajor) {
+            // Every column write is contiguous; one blocked transpose produces the row-major upload.
+            rc.columnFrame.resize(target.width, target.height);
+            FrameTarget columns{rc.columnFrame.pixels.data(), target.width, target.height, 1, target.height};
+            renderViews(rc, map, doors, entities, views, viewCount, cfg, tm, columns, lightmap);
+            transposeColumnsToRows(columns.pixels, columns.width, columns.height, columns.step, target.pixels, target.pitch,
+                                   rc.pool ? *rc.pool : workerPool());
+        } else {
+            renderViews(rc, map, doors, entities, views, viewCount, cfg, tm, target, lightmap);
+        }
+        rc.lastViewsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - viewsStart).count();
+#if RAYCASTER_DIAGNOSTICS
+        if (cfg.diagnostics != DiagOverlay::Off) {
+            drawDiagnosticOverlay(rc.diagnostics, cfg.diagnostics, target);
+        }
+#endif
+        if (rc.capture && rc.capture->wantsFrame()) {
+            rc.capture->offer(target.pixels, target.width, target.height, target.pitch);
+        }
+        SDL_UnlockTexture(ctx.frameTexture);
+        SDL_RenderCopy(renderer, ctx.frameTexture, nullptr, nullptr);
+    }
+
+    if (viewCount > 1) {
+        SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+        for (int v = 0; v < viewCount; ++v) {
+            const SDL_Rect& r = views[v].viewport;
+            SDL_Rect outline{r.x * cfg.screenWidth / ctx.frameWidth, r.y * cfg.screenHeight / ctx.frameHeight,
+                             r.w * cfg.screenWidth / ctx.frameWidth, r.h * cfg.screenHeight / ctx.frameHeight};
+            SDL_RenderDrawRect(renderer, &outline);
         }
     }
 
-    if (showMinimap) {
-        drawMinimap(map, player, renderer, 250, 8);
+    // The minimap follows the first view, which is the local player's.
+    if (showMinimap && viewCount > 0) {
+        drawMinimap(map, views[0].camera, renderer, 250, 8, views[0].visible);
     }
 
     if (console.showFPS) {
-        std::ostringstream oss;
-        oss.precision(1);
-        oss << std::fixed << fps << " fps";
-        std::string text = oss.str();
+        char text[32];
+        int length = std::snprintf(text, sizeof(text), "%.1f fps", fps);
+        length = std::clamp(length, 0, static_cast<int>(sizeof(text)) - 1);
         int scale = 1;
         int charWidth = 8 * scale + scale;
-        int textWidth = static_cast<int>(text.size()) * charWidth;
+        int textWidth = length * charWidth;
         int x = cfg.screenWidth - textWidth - 8;
         int y = 8;
-        drawText(renderer, x, y, text, scale, {240, 240, 240});
+        drawText(renderer, x, y, std::string_view(text, length), scale, {240, 240, 240});
     }
 
     if (console.open) {
@@ -548,4 +905,60 @@ void renderFrame(const Map& map, const std::vector<Door>& doors, const std::vect
     }
 
     SDL_RenderPresent(renderer);
+    rc.lastFrameAllocations = allocationsSince(allocStart);
+}
+
+void registerRendererCvars(ConsoleState& console, Config& cfg) {
+    registerCvar(console, "wall_height", &cfg.wallHeight, 0.1, 10.0, "Wall height scale");
+    registerCvar(console, "r_textures", &cfg.textureMode, {"flat", "full", "mipmapped"}, "Wall texturing: flat colours, full-resolution or mipmapped");
+    registerCvar(console, "r_lighting", &cfg.lighting, "Apply the baked lightmap");
+    registerCvar(console, "r_spans", &cfg.wallSpans, "Cast walls at face edges and solve the columns between analytically");
+    registerCvar(console, "r_culling", &cfg.pvsCulling, "Skip sprites outside the PVS visible set");
+    registerCvar(console, "r_column_major", &cfg.columnMajor, "Draw into a column-major buffer, transposed on present");
+    registerCvar(console, "r_diag", &cfg.diagnostics, {"off", "counters", "steps", "doors", "overdraw"},
+                 "Count DDA steps, door tests and pixel writes; all but counters also draw them as a heatmap");
+}
+
+void registerRenderContextCommands(ConsoleState& console, RenderContext& rc, const Config& cfg, int& splitViews, int& threads, std::unique_ptr<ThreadPool>& pool) {
+    registerConsoleCommand(console, "alloc_stats", "alloc_stats", "Heap allocations in the last frame and frame arena size", [&rc](ConsoleState& con, const std::vector<std::string>&) {
+        const AllocationCounters& last = rc.lastFrameAllocations;
+        consolePrint(con, "last frame: " + std::to_string(last.count) + " allocations, " + std::to_string(last.bytes) + " bytes");
+        consolePrint(con, "frame arena: " + std::to_string(rc.arena.capacity() / 1024) + " KiB, grown " +
+                              std::to_string(rc.arena.growCount()) + " times");
+    });
+    registerConsoleCommand(console, "diag_stats", "diag_stats", "Ray, door and overdraw totals of the last counted frame (r_diag)", [&rc, &cfg](ConsoleState& con, const std::vector<std::string>&) {
+#if RAYCASTER_DIAGNOSTICS
+        const RenderDiagnostics& diag = rc.diagnostics;
+        if (cfg.diagnostics == DiagOverlay::Off || !diag.counted) {
+            consolePrint(con, "Nothing counted; set r_diag to counters, steps, doors or overdraw");
+            return;
+        }
+        const DiagnosticTotals& t = diag.last;
+        double columns = std::max(1u, t.columns);
+        char line[160];
+        std::snprintf(line, sizeof(line), "%u columns, %u rays: %llu DDA steps (%.1f/column, max %u), %llu door tests (max %u)", t.columns,
+                      rc.lastFrameRays, static_cast<unsigned long long>(t.ddaSteps), t.ddaSteps / columns, t.maxSteps,
+                      static_cast<unsigned long long>(t.doorTests), t.maxDoorTests);
+        consolePrint(con, line);
+        std::snprintf(line, sizeof(line), "%llu pixel writes for %llu pixels: %.2fx overdraw, max %u on one pixel", static_cast<unsigned long long>(t.pixelWrites),
+                      static_cast<unsigned long long>(t.pixels), static_cast<double>(t.pixelWrites) / std::max<uint64_t>(1, t.pixels), t.maxOverdraw);
+        consolePrint(con, line);
+#else
+        consolePrint(con, "Built without RAYCASTER_DIAGNOSTICS");
+#endif
+    });
+    registerConsoleCommand(console, "splitscreen", "splitscreen <1|2|4>", "Render 1, 2 or 4 views into one frame", [&splitViews](ConsoleState& con, const std::vector<std::string>& args) {
+        int count = args.size() >= 2 ? std::atoi(args[1].c_str()) : 0;
+        if (count != 1 && count != 2 && count != 4) {
+            consolePrint(con, "Usage: splitscreen <1|2|4>");
+            return;
+        }
+        splitViews = count;
+        consolePrint(con, std::to_string(count) + " view(s)");
+    });
+    registerCvar(console, "r_threads", &threads, 0, 256, "Column worker threads; 0 shares the process worker pool", [&rc, &threads, &pool](ConsoleState& con) {
+        pool.reset(threads > 0 ? new ThreadPool(static_cast<unsigned>(threads - 1)) : nullptr);
+        rc.pool = pool.get();
+        consolePrint(con, "rendering on " + std::to_string(pool ? pool->concurrency() : workerPool().concurrency()) + " thread(s)");
+    });
 }
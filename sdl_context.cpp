@@ -1,7 +1,11 @@
 #include "sdl_context.h"
 
 #include <SDL2/SDL_image.h>
+#include <algorithm>
 #include <iostream>
+#include <string>
+
+#include "console.h"
 
 bool initSDL(SDLContext& ctx, const Config& cfg) {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
@@ -30,11 +34,33 @@ bool initSDL(SDLContext& ctx, const Config& cfg) {
         return false;
     }
 
+    if (!resizeFrameTexture(ctx, cfg.screenWidth, cfg.screenHeight)) {
+        return false;
+    }
+
     SDL_SetRenderDrawBlendMode(ctx.renderer, SDL_BLENDMODE_BLEND);
     return true;
 }
 
+bool resizeFrameTexture(SDLContext& ctx, int width, int height) {
+    SDL_Texture* texture = SDL_CreateTexture(ctx.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!texture) {
+        std::cerr << "SDL_CreateTexture Error: " << SDL_GetError() << "\n";
+        return false;
+    }
+    if (ctx.frameTexture) {
+        SDL_DestroyTexture(ctx.frameTexture);
+    }
+    ctx.frameTexture = texture;
+    ctx.frameWidth = width;
+    ctx.frameHeight = height;
+    return true;
+}
+
 void shutdownSDL(SDLContext& ctx) {
+    if (ctx.frameTexture) {
+        SDL_DestroyTexture(ctx.frameTexture);
+    }
     if (ctx.renderer) {
         SDL_DestroyRenderer(ctx.renderer);
     }
@@ -44,3 +70,13 @@ void shutdownSDL(SDLContext& ctx) {
     IMG_Quit();
     SDL_Quit();
 }
+
+void registerDisplayCvars(ConsoleState& console, SDLContext& ctx, Config& cfg) {
+    registerCvar(console, "r_scale", &cfg.renderScale, 0.25, 1.0, "3D view resolution relative to the window", [&ctx, &cfg](ConsoleState& con) {
+        int width = std::max(1, static_cast<int>(cfg.screenWidth * cfg.renderScale + 0.5));
+        int height = std::max(1, static_cast<int>(cfg.screenHeight * cfg.renderScale + 0.5));
+        if (resizeFrameTexture(ctx, width, height)) {
+            consolePrint(con, "3D view " + std::to_string(width) + "x" + std::to_string(height));
+        }
+    });
+}
@@ -0,0 +1,630 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "camera_path.h"
+#include "doors.h"
+#include "input.h"
+#include "map.h"
+#include "thread_pool.h"
+
+namespace {
+const Uint8 FIELD_X = 1 << 0;
+const Uint8 FIELD_Y = 1 << 1;
+const Uint8 FIELD_ANGLE = 1 << 2;
+const Uint8 FIELD_PRESENT = 1 << 3;
+const double TWO_PI = 6.283185307179586;
+
+// --- Transport -------------------------------------------------------------
+
+#ifdef _WIN32
+void closeSocket(SocketHandle s) {
+    closesocket(static_cast<SOCKET>(s));
+}
+
+// Two non-blocking UDP sockets on 127.0.0.1, each connected to the other.
+bool openLink(SocketHandle& a, SocketHandle& b) {
+    static bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    if (!started) {
+        return false;
+    }
+    SOCKET ends[2] = {INVALID_SOCKET, INVALID_SOCKET};
+    sockaddr_in addr[2] = {};
+    for (int i = 0; i < 2; ++i) {
+        ends[i] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        addr[i].sin_family = AF_INET;
+        addr[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int length = sizeof(addr[i]);
+        if (ends[i] == INVALID_SOCKET || bind(ends[i], reinterpret_cast<sockaddr*>(&addr[i]), length) != 0 ||
+            getsockname(ends[i], reinterpret_cast<sockaddr*>(&addr[i]), &length) != 0) {
+            for (SOCKET s : ends) {
+                if (s != INVALID_SOCKET) closesocket(s);
+            }
+            return false;
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        u_long nonBlocking = 1;
+        connect(ends[i], reinterpret_cast<sockaddr*>(&addr[1 - i]), sizeof(addr[1 - i]));
+        ioctlsocket(ends[i], FIONBIO, &nonBlocking);
+    }
+    a = static_cast<SocketHandle>(ends[0]);
+    b = static_cast<SocketHandle>(ends[1]);
+    return true;
+}
+
+bool sendDatagram(SocketHandle s, const Uint8* data, size_t size) {
+    return send(static_cast<SOCKET>(s), reinterpret_cast<const char*>(data), static_cast<int>(size), 0) == static_cast<int>(size);
+}
+
+// Returns the datagram size, or -1 when nothing is queued. Oversized datagrams come back truncated as 0.
+long receiveDatagram(SocketHandle s, Uint8* data, size_t capacity) {
+    int n = recv(static_cast<SOCKET>(s), reinterpret_cast<char*>(data), static_cast<int>(capacity), 0);
+    if (n < 0) {
+        return WSAGetLastError() == WSAEMSGSIZE ? 0 : -1;
+    }
+    return n;
+}
+#else
+void closeSocket(SocketHandle s) {
+    close(static_cast<int>(s));
+}
+
+bool openLink(SocketHandle& a, SocketHandle& b) {
+    int ends[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, ends) != 0) {
+        return false;
+    }
+    a = ends[0];
+    b = ends[1];
+    return true;
+}
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = MSG_DONTWAIT;
+#endif
+
+bool sendDatagram(SocketHandle s, const Uint8* data, size_t size) {
+    return send(static_cast<int>(s), data, size, SEND_FLAGS) == static_cast<ssize_t>(size);
+}
+
+long receiveDatagram(SocketHandle s, Uint8* data, size_t capacity) {
+    ssize_t n = recv(static_cast<int>(s), data, capacity, MSG_DONTWAIT | MSG_TRUNC);
+    if (n < 0) {
+        return -1;
+    }
+    return static_cast<size_t>(n) > capacity ? 0 : static_cast<long>(n);
+}
+#endif
+
+// --- Wire format -----------------------------------------------------------
+
+// LEB128; at most 5 bytes for 32 bits.
+size_t writeVarint(Uint8* out, Uint32 value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<Uint8>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<Uint8>(value);
+    return n;
+}
+
+void putVarint(std::vector<Uint8>& out, Uint32 value) {
+    if (value < 0x80) {
+        out.push_back(static_cast<Uint8>(value));
+        return;
+    }
+    Uint8 bytes[5];
+    out.insert(out.end(), bytes, bytes + writeVarint(bytes, value));
+}
+
+bool getVarint(const Uint8*& p, const Uint8* end, Uint32& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        Uint8 byte = *p++;
+        value |= static_cast<Uint32>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Uint32 zigzag(Sint32 v) {
+    return (static_cast<Uint32>(v) << 1) ^ static_cast<Uint32>(v >> 31);
+}
+
+Sint32 unzigzag(Uint32 v) {
+    return static_cast<Sint32>(v >> 1) ^ -static_cast<Sint32>(v & 1);
+}
+
+NetPlayer baselinePlayer(const WorldSnapshot* baseline, size_t i) {
+    return baseline && i < baseline->players.size() ? baseline->players[i] : NetPlayer{};
+}
+
+Uint8 baselineDoor(const WorldSnapshot* baseline, size_t i) {
+    return baseline && i < baseline->doors.size() ? baseline->doors[i] : 0;
+}
+
+Uint8 playerChanges(const NetPlayer& current, const NetPlayer& base) {
+    if (!current.present) {
+        return 0;
+    }
+    Uint8 mask = FIELD_PRESENT;
+    if (!base.present || current.x != base.x) mask |= FIELD_X;
+    if (!base.present || current.y != base.y) mask |= FIELD_Y;
+    if (!base.present || current.angle != base.angle) mask |= FIELD_ANGLE;
+    return mask;
+}
+
+bool playerChanged(const NetPlayer& current, const NetPlayer& base) {
+    return current.present != base.present || playerChanges(current, base) != FIELD_PRESENT;
+}
+
+NetPlayer quantisePlayer(const Player& p) {
+    NetPlayer net;
+    net.x = static_cast<Sint32>(std::lround(p.x * 256.0));
+    net.y = static_cast<Sint32>(std::lround(p.y * 256.0));
+    long turn = std::lround(std::atan2(p.dirY, p.dirX) / TWO_PI * 65536.0);
+    net.angle = static_cast<Uint16>(turn & 0xffff);
+    net.present = true;
+    return net;
+}
+
+// Change lists: the total count, then (gap since the previous change + 1, payload) pairs, then a 0.
+template <typename Changed, typename Write>
+void putChangeList(std::vector<Uint8>& out, size_t count, Changed&& changed, Write&& write) {
+    putVarint(out, static_cast<Uint32>(count));
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (changed(i)) {
+            putVarint(out, static_cast<Uint32>(i - next + 1));
+            write(i);
+            next = i + 1;
+        }
+    }
+    out.push_back(0);
+}
+
+// Returns the next changed index, count at the end of the list, or -1 on malformed input.
+long nextChange(const Uint8*& p, const Uint8* end, size_t& next, size_t count) {
+    Uint32 gap = 0;
+    if (!getVarint(p, end, gap)) {
+        return -1;
+    }
+    if (gap == 0) {
+        return static_cast<long>(count);
+    }
+    size_t i = next + gap - 1;
+    if (i >= count || p == end) {
+        return -1;
+    }
+    next = i + 1;
+    return static_cast<long>(i);
+}
+} // namespace
+
+void encodeSnapshot(const WorldSnapshot& current, const WorldSnapshot* baseline, std::vector<Uint8>& out) {
+    putVarint(out, current.tick);
+    putVarint(out, baseline ? baseline->tick : 0);
+    putChangeList(
+        out, current.players.size(),
+        [&](size_t i) { return playerChanged(current.players[i], baselinePlayer(baseline, i)); },
+        [&](size_t i) {
+            const NetPlayer& p = current.players[i];
+            NetPlayer base = baselinePlayer(baseline, i);
+            Uint8 mask = playerChanges(p, base);
+            out.push_back(mask);
+            if (mask & FIELD_X) putVarint(out, zigzag(p.x - base.x));
+            if (mask & FIELD_Y) putVarint(out, zigzag(p.y - base.y));
+            if (mask & FIELD_ANGLE) putVarint(out, zigzag(static_cast<Sint16>(static_cast<Uint16>(p.angle - base.angle))));
+        });
+    putChangeList(
+        out, current.doors.size(),
+        [&](size_t i) { return current.doors[i] != baselineDoor(baseline, i); },
+        [&](size_t i) { out.push_back(current.doors[i]); });
+}
+
+bool readSnapshotHeader(const Uint8* data, size_t size, Uint32& tick, Uint32& baselineTick) {
+    const Uint8* p = data;
+    return getVarint(p, data + size, tick) && getVarint(p, data + size, baselineTick);
+}
+
+bool decodeSnapshot(const Uint8* data, size_t size, const WorldSnapshot* baseline, WorldSnapshot& out) {
+    const Uint8* p = data;
+    const Uint8* end = data + size;
+    Uint32 baselineTick = 0, count = 0;
+    if (!getVarint(p, end, out.tick) || !getVarint(p, end, baselineTick) || (baselineTick != 0) != (baseline != nullptr)) {
+        return false;
+    }
+
+    if (!getVarint(p, end, count) || count > MAX_SNAPSHOT_BYTES) {
+        return false;
+    }
+    out.players.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        out.players[i] = baselinePlayer(baseline, i);
+    }
+    size_t next = 0;
+    for (long i; (i = nextChange(p, end, next, count)) != static_cast<long>(count);) {
+        if (i < 0) {
+            return false;
+        }
+        Uint8 mask = *p++;
+        NetPlayer& player = out.players[i];
+        if (!(mask & FIELD_PRESENT)) {
+            player = NetPlayer{};
+            continue;
+        }
+        player.present = true; // entering the visible set: the fields were zero, so the deltas are absolute
+        Uint32 delta = 0;
+        if (mask & FIELD_X) {
+            if (!getVarint(p, end, delta)) return false;
+            player.x += unzigzag(delta);
+        }
+        if (mask & FIELD_Y) {
+            if (!getVarint(p, end, delta)) return false;
+            player.y += unzigzag(delta);
+        }
+        if (mask & FIELD_ANGLE) {
+            if (!getVarint(p, end, delta)) return false;
+            player.angle = static_cast<Uint16>(player.angle + unzigzag(delta));
+        }
+    }
+
+    if (!getVarint(p, end, count) || count > MAX_SNAPSHOT_BYTES) {
+        return false;
+    }
+    out.doors.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        out.doors[i] = baselineDoor(baseline, i);
+    }
+    next = 0;
+    for (long i; (i = nextChange(p, end, next, count)) != static_cast<long>(count);) {
+        if (i < 0) {
+            return false;
+        }
+        out.doors[i] = *p++;
+    }
+    return p == end;
+}
+
+SimulationServer::SimulationServer(Map map, const Config& cfg)
+    : map_(std::move(map)), cfg_(cfg), doors_(extractDoors(map_)), pvs_(buildPvs(map_, doors_)) {}
+
+SimulationServer::~SimulationServer() {
+    for (auto& client : clients_) {
+        closeSocket(client->socket);
+    }
+}
+
+bool reserveClientLinks(int clients) {
+#ifdef _WIN32
+    (void)clients;
+    return true;
+#else
+    // Both ends of every link, plus headroom for stdio, the worker pool and files the process opens.
+    rlim_t needed = static_cast<rlim_t>(clients) * 2 + 64;
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        std::cerr << "Could not read the open-file limit: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed) {
+            std::cerr << clients << " clients need " << needed << " open files, but the hard limit is " << limit.rlim_max
+                      << "; raise it (ulimit -Hn) or run fewer clients\n";
+            return false;
+        }
+        limit.rlim_cur = needed;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            std::cerr << "Could not raise the open-file limit to " << needed << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+SocketHandle SimulationServer::connectClient(const Player& spawn) {
+    SocketHandle serverEnd, clientEnd;
+    if (!openLink(serverEnd, clientEnd)) {
+        std::cerr << "Failed to open a local link for client " << clients_.size() << "\n";
+        return INVALID_SOCKET_HANDLE;
+    }
+    auto client = std::make_unique<Client>();
+    client->socket = serverEnd;
+    client->sent.resize(SNAPSHOT_HISTORY);
+    client->packet.reserve(MAX_SNAPSHOT_BYTES);
+    clients_.push_back(std::move(client));
+    players_.push_back(spawn);
+    return clientEnd;
+}
+
+const WorldSnapshot& SimulationServer::lastSent(size_t index) const {
+    return clients_[index]->sent[tick_ % SNAPSHOT_HISTORY];
+}
+
+void SimulationServer::receiveInput(Client& client) {
+    Uint8 packet[16];
+    long size;
+    while ((size = receiveDatagram(client.socket, packet, sizeof(packet))) >= 0) {
+        const Uint8* p = packet;
+        Uint32 ack = 0;
+        if (!getVarint(p, packet + size, ack) || p == packet + size) {
+            continue; // truncated or malformed; the next one will do
+        }
+        // Datagrams may arrive out of order; an older ack never replaces a newer one.
+        client.ackTick = std::max(client.ackTick, std::min(ack, tick_));
+        client.buttons = *p;
+    }
+}
+
+void SimulationServer::sendSnapshot(Client& client, const Player& player) {
+    computeVisibleRegions(pvs_, doors_, player.x, player.y, client.visible);
+    WorldSnapshot& snap = client.sent[tick_ % SNAPSHOT_HISTORY];
+    snap.tick = tick_;
+    snap.players.resize(quantisedPlayers_.size());
+    for (size_t i = 0; i < quantisedPlayers_.size(); ++i) {
+        const Player& other = players_[i];
+        bool relevant = &other == &player || client.visible.containsCell(static_cast<int>(other.x), static_cast<int>(other.y));
+        snap.players[i] = relevant ? quantisedPlayers_[i] : NetPlayer{};
+    }
+    snap.doors.assign(quantisedDoors_.begin(), quantisedDoors_.end());
+
+    const WorldSnapshot* baseline = nullptr;
+    if (client.ackTick != 0 && tick_ - client.ackTick < static_cast<Uint32>(SNAPSHOT_HISTORY)) {
+        const WorldSnapshot& acked = client.sent[client.ackTick % SNAPSHOT_HISTORY];
+        if (acked.tick == client.ackTick) {
+            baseline = &acked;
+        }
+    }
+    client.packet.clear();
+    encodeSnapshot(snap, baseline, client.packet);
+    if (!sendDatagram(client.socket, client.packet.data(), client.packet.size())) {
+        ++client.counters.droppedSnapshots;
+        return;
+    }
+    ++client.counters.snapshots;
+    client.counters.fullSnapshots += baseline ? 0 : 1;
+    client.counters.snapshotBytes += client.packet.size();
+}
+
+void SimulationServer::tick(double dt) {
+    auto start = std::chrono::steady_clock::now();
+    ++tick_;
+    // Input and movement are serial: Use toggles shared doors.
+    for (size_t i = 0; i < clients_.size(); ++i) {
+        Client& client = *clients_[i];
+        receiveInput(client);
+        applyPlayerInput(client.buttons, client.previousButtons, map_, doors_, players_[i], cfg_, dt);
+    }
+    updateDoors(doors_, players_, dt);
+
+    quantisedPlayers_.resize(players_.size());
+    for (size_t i = 0; i < players_.size(); ++i) {
+        quantisedPlayers_[i] = quantisePlayer(players_[i]);
+    }
+    quantisedDoors_.resize(doors_.size());
+    for (size_t i = 0; i < doors_.size(); ++i) {
+        quantisedDoors_[i] = static_cast<Uint8>(std::lround(doors_[i].openAmount * 255.0));
+    }
+
+    // Each client's relevance set, delta and send touch only that client's state.
+    workerPool().parallelFor(clients_.size(), 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            sendSnapshot(*clients_[i], players_[i]);
+        }
+    });
+
+    ServerStats totals;
+    for (const auto& client : clients_) {
+        totals.snapshots += client->counters.snapshots;
+        totals.fullSnapshots += client->counters.fullSnapshots;
+        totals.droppedSnapshots += client->counters.droppedSnapshots;
+        totals.snapshotBytes += client->counters.snapshotBytes;
+    }
+    totals.ticks = tick_;
+    totals.lastTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_ = totals;
+}
+
+SnapshotClient::SnapshotClient(SocketHandle socket) : socket_(socket), history_(SNAPSHOT_HISTORY), buffer_(MAX_SNAPSHOT_BYTES) {}
+
+SnapshotClient::~SnapshotClient() {
+    if (socket_ != INVALID_SOCKET_HANDLE) {
+        closeSocket(socket_);
+    }
+}
+
+bool SnapshotClient::sendInput(Uint8 buttons) {
+    Uint8 packet[6];
+    size_t size = writeVarint(packet, latestTick_);
+    packet[size++] = buttons;
+    return sendDatagram(socket_, packet, size);
+}
+
+int SnapshotClient::receive() {
+    int decoded = 0;
+    long size;
+    while ((size = receiveDatagram(socket_, buffer_.data(), buffer_.size())) >= 0) {
+        bytesReceived_ += static_cast<Uint64>(size);
+        Uint32 tick = 0, baselineTick = 0;
+        if (!readSnapshotHeader(buffer_.data(), static_cast<size_t>(size), tick, baselineTick)) {
+            ++undecodable_;
+            continue;
+        }
+        if (tick <= latestTick_) {
+            continue; // reordered behind a newer snapshot
+        }
+        const WorldSnapshot* baseline = nullptr;
+        if (baselineTick != 0) {
+            baseline = &history_[baselineTick % SNAPSHOT_HISTORY];
+            if (baseline->tick != baselineTick) {
+                ++undecodable_;
+                continue;
+            }
+        }
+        WorldSnapshot& slot = history_[tick % SNAPSHOT_HISTORY];
+        if (!decodeSnapshot(buffer_.data(), static_cast<size_t>(size), baseline, slot)) {
+            slot.tick = 0;
+            ++undecodable_;
+            continue;
+        }
+        latestTick_ = tick;
+        ++decoded;
+    }
+    return decoded;
+}
+
+Uint8 scriptedBotInput(int bot, Uint32 tick) {
+    // A new intent roughly every 45 ticks, staggered per bot.
+    Uint32 phase = tick + static_cast<Uint32>(bot) * 17;
+    Uint32 h = (phase / 45) * 2654435761u ^ static_cast<Uint32>(bot) * 40503u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    switch (h % 8) {
+    case 0:
+    case 1:
+    case 2:
+        return INPUT_FORWARD;
+    case 3:
+        return INPUT_FORWARD | INPUT_TURN_LEFT;
+    case 4:
+        return INPUT_FORWARD | INPUT_TURN_RIGHT;
+    case 5:
+        return INPUT_FORWARD | INPUT_SPRINT;
+    case 6:
+        return INPUT_TURN_LEFT;
+    default:
+        return phase % 45 < 2 ? INPUT_USE : 0;
+    }
+}
+
+Player botSpawn(const Map& map, int bot) {
+    if (map.rooms.empty()) {
+        auto spawn = pickSpawnPoint(map);
+        return cameraFromAngle(spawn.first, spawn.second, bot * 0.7);
+    }
+    const MapRoom& room = map.rooms[bot % map.rooms.size()];
+    int slot = bot / static_cast<int>(map.rooms.size());
+    double x = room.x + (slot % room.w) + 0.5;
+    double y = room.y + (slot / room.w) % room.h + 0.5;
+    return cameraFromAngle(x, y, bot * 0.7);
+}
+
+namespace {
+struct ServerOptions {
+    int players = 32;
+    double seconds = 10.0;
+    int tickRate = 120;
+    unsigned seed = 1;
+};
+
+bool parseServerOptions(const std::vector<std::string>& args, ServerOptions& opts) {
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (i + 1 >= args.size()) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        const std::string& value = args[++i];
+        if (arg == "--players") {
+            opts.players = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--seconds") {
+            opts.seconds = std::max(0.1, std::atof(value.c_str()));
+        } else if (arg == "--tick-rate") {
+            opts.tickRate = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--seed") {
+            opts.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            std::cerr << "Usage: raycaster --server [--players n] [--seconds s] [--tick-rate hz] [--seed n]\n";
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int runServer(const std::vector<std::string>& args) {
+    ServerOptions opts;
+    if (!parseServerOptions(args, opts)) {
+        return 1;
+    }
+    if (!reserveClientLinks(opts.players)) {
+        return 1;
+    }
+    Config cfg{};
+    SimulationServer server(createRandomMap(opts.seed), cfg);
+    std::vector<std::unique_ptr<SnapshotClient>> clients;
+    for (int i = 0; i < opts.players; ++i) {
+        SocketHandle socket = server.connectClient(botSpawn(server.map(), i));
+        if (socket == INVALID_SOCKET_HANDLE) {
+            return 1;
+        }
+        clients.push_back(std::make_unique<SnapshotClient>(socket));
+    }
+
+    std::cout << "server: " << opts.players << " simulated clients at " << opts.tickRate << " Hz for " << opts.seconds
+              << " s, " << server.map().width << "x" << server.map().height << " map\n";
+    using Clock = std::chrono::steady_clock;
+    const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opts.tickRate));
+    const Uint32 totalTicks = static_cast<Uint32>(opts.seconds * opts.tickRate);
+    auto next = Clock::now();
+    double tickMsSum = 0.0, tickMsMax = 0.0;
+    ServerStats reported;
+    for (Uint32 t = 1; t <= totalTicks; ++t) {
+        for (size_t i = 0; i < clients.size(); ++i) {
+            clients[i]->receive();
+            clients[i]->sendInput(scriptedBotInput(static_cast<int>(i), t));
+        }
+        server.tick(1.0 / opts.tickRate);
+        tickMsSum += server.stats().lastTickMs;
+        tickMsMax = std::max(tickMsMax, server.stats().lastTickMs);
+
+        if (t % static_cast<Uint32>(opts.tickRate) == 0 || t == totalTicks) {
+            const ServerStats& now = server.stats();
+            Uint64 sent = now.snapshots - reported.snapshots;
+            Uint32 ticks = static_cast<Uint32>(now.ticks - reported.ticks);
+            std::cout << std::fixed << std::setprecision(3) << "  tick " << t << ": " << tickMsSum / ticks << " ms avg, "
+                      << tickMsMax << " ms max, " << std::setprecision(1)
+                      << (sent ? static_cast<double>(now.snapshotBytes - reported.snapshotBytes) / sent : 0.0)
+                      << " bytes/snapshot, " << now.fullSnapshots - reported.fullSnapshots << " full, "
+                      << now.droppedSnapshots - reported.droppedSnapshots << " dropped\n";
+            reported = now;
+            tickMsSum = 0.0;
+            tickMsMax = 0.0;
+        }
+        next += step;
+        std::this_thread::sleep_until(next);
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "console.h"
+
+namespace {
+// Output a client has not taken yet; past this, its frame lines are dropped until it catches up.
+const size_t CLIENT_BACKLOG = 64 * 1024;
+const size_t MAX_COMMAND = 247;
+const char* const HEADER = "# F frame frame_ms sim_ms views_ms render_ms rays sprites doors_active entities allocs alloc_bytes\n";
+
+void copyLine(TelemetryLine& line, const std::string& text) {
+    size_t length = std::min(text.size(), line.text.size() - 1);
+    std::memcpy(line.text.data(), text.data(), length);
+    line.text[length] = '\0';
+}
+} // namespace
+
+struct TelemetryServer::Client {
+    int id;
+    int fd;
+    std::string in;
+    std::string out;
+};
+
+TelemetryServer::~TelemetryServer() {
+    stop();
+}
+
+#ifdef _WIN32
+bool TelemetryServer::start(const std::string&) {
+    std::cerr << "Telemetry needs Unix-domain sockets, which this build does not support\n";
+    return false;
+}
+
+void TelemetryServer::stop() {}
+
+void TelemetryServer::ioLoop() {}
+#else
+bool TelemetryServer::start(const std::string& path) {
+    if (running()) {
+        std::cerr << "Telemetry is already listening on " << path_ << "\n";
+        return false;
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Telemetry socket path must be 1 to " << sizeof(address.sun_path) - 1 << " characters\n";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to create telemetry socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    // Only a socket left behind by an earlier run is replaced; anything else at the path is not ours.
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Not starting telemetry: " << path << " exists and is not a socket\n";
+            close(fd);
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 4) != 0) {
+        std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    listenFd_ = fd;
+    path_ = path;
+    stopping_ = false;
+    thread_ = std::thread(&TelemetryServer::ioLoop, this);
+    return true;
+}
+
+void TelemetryServer::stop() {
+    if (!running()) {
+        return;
+    }
+    stopping_ = true;
+    thread_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+    unlink(path_.c_str());
+    clients_ = 0;
+    FrameMetrics frame;
+    while (frames_.pop(frame)) {
+    }
+    TelemetryLine line;
+    while (commands_.pop(line)) {
+    }
+    while (replies_.pop(line)) {
+    }
+}
+
+void TelemetryServer::ioLoop() {
+#ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL;
+#else
+    const int sendFlags = 0;
+#endif
+    std::vector<Client> clients;
+    auto sendReplies = [&] {
+        TelemetryLine reply;
+        while (replies_.pop(reply)) {
+            for (Client& c : clients) {
+                if (c.id == reply.client) {
+                    c.out += "R ";
+                    c.out += reply.text.data();
+                    c.out += '\n';
+                }
+            }
+        }
+        for (Client& c : clients) {
+            while (!c.out.empty()) {
+                ssize_t n = send(c.fd, c.out.data(), c.out.size(), sendFlags);
+                if (n <= 0) {
+                    break;
+                }
+                c.out.erase(0, static_cast<size_t>(n));
+            }
+        }
+    };
+    std::vector<pollfd> fds;
+    char buffer[4096];
+    while (!stopping_) {
+        fds.assign(1, pollfd{listenFd_, POLLIN, 0});
+        for (const Client& c : clients) {
+            fds.push_back(pollfd{c.fd, static_cast<short>(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0});
+        }
+        poll(fds.data(), fds.size(), 5);
+
+        int fd;
+        while ((fd = accept(listenFd_, nullptr, nullptr)) >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            clients.push_back(Client{nextClientId_++, fd, {}, HEADER});
+        }
+
+        // Commands in; a full queue answers for the frame loop.
+        for (Client& c : clients) {
+            ssize_t n;
+            while ((n = recv(c.fd, buffer, sizeof(buffer), 0)) > 0) {
+                c.in.append(buffer, static_cast<size_t>(n));
+            }
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                close(c.fd);
+                c.fd = -1;
+                continue;
+            }
+            size_t end;
+            while ((end = c.in.find('\n')) != std::string::npos) {
+                std::string command = c.in.substr(0, std::min(end, MAX_COMMAND));
+                c.in.erase(0, end + 1);
+                if (!command.empty() && command.back() == '\r') {
+                    command.pop_back();
+                }
+                TelemetryLine line;
+                line.client = c.id;
+                copyLine(line, command);
+                if (!commands_.push(line)) {
+                    ++commandsDropped_;
+                    c.out += "R busy\nR .\n";
+                }
+            }
+            if (c.in.size() > MAX_COMMAND) {
+                c.in.clear(); // no newline in sight; not a command
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.fd < 0; }), clients.end());
+        clients_ = clients.size();
+
+        FrameMetrics m;
+        while (frames_.pop(m)) {
+            char line[192];
+            int length = std::snprintf(line, sizeof(line), "F %u %.3f %.3f %.3f %.3f %u %u %u %u %u %u\n", m.frame, m.frameMs, m.simMs, m.viewsMs,
+                                       m.renderMs, m.rays, m.sprites, m.doorsActive, m.entities, m.allocations, m.allocBytes);
+            for (Client& c : clients) {
+                if (c.out.size() < CLIENT_BACKLOG) {
+                    c.out.append(line, static_cast<size_t>(length));
+                    ++framesSent_;
+                } else {
+                    ++framesDropped_;
+                }
+            }
+        }
+        sendReplies();
+    }
+    sendReplies(); // replies queued before stop() get one last attempt; clients then see EOF
+    for (Client& c : clients) {
+        close(c.fd);
+    }
+}
+#endif
+
+void TelemetryServer::publish(const FrameMetrics& metrics) {
+    if (!frames_.push(metrics)) {
+        ++framesDropped_;
+    }
+}
+
+void TelemetryServer::runCommands(const std::function<std::vector<std::string>(const std::string& command)>& execute) {
+    // Two slots stay free for every command: a truncation note and the terminator a client waits for.
+    TelemetryLine command;
+    while (replies_.freeSlots() >= 2 && commands_.pop(command)) {
+        ++commandsRun_;
+        TelemetryLine reply;
+        reply.client = command.client;
+        size_t dropped = 0;
+        runningCommand_ = true;
+        std::vector<std::string> output = execute(command.text.data());
+        runningCommand_ = false;
+        for (const std::string& text : output) {
+            copyLine(reply, text);
+            if (dropped > 0 || replies_.freeSlots() <= 2 || !replies_.push(reply)) {
+                ++dropped;
+            }
+        }
+        if (dropped > 0) {
+            repliesDropped_ += dropped;
+            copyLine(reply, "truncated " + std::to_string(dropped) + " lines");
+            replies_.push(reply);
+        }
+        copyLine(reply, ".");
+        replies_.push(reply);
+    }
+}
+
+TelemetryStats TelemetryServer::stats() const {
+    TelemetryStats stats;
+    stats.clients = clients_.load();
+    stats.framesSent = framesSent_.load();
+    stats.framesDropped = framesDropped_.load();
+    stats.commands = commandsRun_.load();
+    stats.commandsDropped = commandsDropped_.load();
+    stats.repliesDropped = repliesDropped_.load();
+    return stats;
+}
+
+void registerTelemetryCommands(ConsoleState& console, TelemetryServer& telemetry) {
+    registerConsoleCommand(console, "telemetry", "telemetry [socket path|off]", "Stream frame metrics and accept commands on a Unix socket", [&telemetry](ConsoleState& con, const std::vector<std::string>& args) {
+        if (args.size() >= 2 && telemetry.runningCommand()) {
+            // Stopping the server from its own socket would cut the reply off; only the local console may.
+            consolePrint(con, "Not from a telemetry client; use the in-game console");
+        } else if (args.size() >= 2 && args[1] == "off") {
+            telemetry.stop();
+            consolePrint(con, "Telemetry off");
+        } else if (args.size() >= 2) {
+            telemetry.stop();
+            consolePrint(con, telemetry.start(args[1]) ? "Telemetry on " + args[1] : "Could not listen on " + args[1]);
+        } else if (!telemetry.running()) {
+            consolePrint(con, "Telemetry off; telemetry <socket path> starts it");
+        } else {
+            TelemetryStats st = telemetry.stats();
+            char line[320];
+            std::snprintf(line, sizeof(line), "%s: %zu client(s), %llu frame lines sent, %llu dropped, %llu commands (%llu refused, %llu reply lines cut)",
+                          telemetry.path().c_str(), st.clients, static_cast<unsigned long long>(st.framesSent), static_cast<unsigned long long>(st.framesDropped),
+                          static_cast<unsigned long long>(st.commands), static_cast<unsigned long long>(st.commandsDropped),
+                          static_cast<unsigned long long>(st.repliesDropped));
+            consolePrint(con, line);
+        }
+    });
+}
@@ -0,0 +1,264 @@
+#include "texture_residency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "console.h"
+
+namespace {
+// Placeholders are the mip levels from this size down: 340 bytes for a square wall.
+const int PLACEHOLDER_SIZE = 8;
+
+size_t chainBytes(const std::vector<SDL_Surface*>& chain) {
+    size_t bytes = 0;
+    for (const SDL_Surface* surf : chain) {
+        bytes += static_cast<size_t>(surf->w) * surf->h * sizeof(Uint32);
+    }
+    return bytes;
+}
+
+void freeChain(std::vector<SDL_Surface*>& chain) {
+    for (SDL_Surface* surf : chain) {
+        SDL_FreeSurface(surf);
+    }
+    chain.clear();
+}
+
+// Owned copies of the chain's levels from the first one no larger than PLACEHOLDER_SIZE.
+std::vector<SDL_Surface*> copyPlaceholder(const std::vector<SDL_Surface*>& chain) {
+    size_t first = chain.size() - 1;
+    for (size_t l = 0; l < chain.size(); ++l) {
+        if (chain[l]->w <= PLACEHOLDER_SIZE && chain[l]->h <= PLACEHOLDER_SIZE) {
+            first = l;
+            break;
+        }
+    }
+    std::vector<SDL_Surface*> copy;
+    for (size_t l = first; l < chain.size(); ++l) {
+        const SDL_Surface* src = chain[l];
+        SDL_Surface* dst = SDL_CreateRGBSurfaceWithFormat(0, src->w, src->h, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!dst) {
+            std::cerr << "Failed to allocate texture placeholder: " << SDL_GetError() << "\n";
+            freeChain(copy);
+            return copy;
+        }
+        for (int y = 0; y < src->h; ++y) {
+            std::memcpy(static_cast<Uint8*>(dst->pixels) + static_cast<size_t>(y) * dst->pitch,
+                        static_cast<const Uint8*>(src->pixels) + static_cast<size_t>(y) * src->pitch, static_cast<size_t>(src->w) * sizeof(Uint32));
+        }
+        copy.push_back(dst);
+    }
+    return copy;
+}
+} // namespace
+
+TextureResidency::TextureResidency(TextureManager& tm, size_t budgetBytes) : tm_(tm), budget_(budgetBytes) {}
+
+TextureResidency::~TextureResidency() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    requested_.notify_all();
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    for (Loaded& done : loaded_) {
+        freeChain(done.chain);
+    }
+    for (size_t id = 0; id < slots_.size(); ++id) {
+        Slot& slot = slots_[id];
+        if (!slot.managed) {
+            continue;
+        }
+        freeChain(slot.full);
+        freeChain(slot.placeholder);
+        tm_.textures[id] = nullptr;
+        tm_.textureMips[id].clear();
+    }
+    if (attached_) {
+        tm_.residency = nullptr;
+    }
+}
+
+bool TextureResidency::attach(const std::string& manifestPath, const std::string& cachePath) {
+    std::vector<AssetEntry> entries = readAssetManifest(manifestPath);
+    std::vector<std::vector<TextureArchiveLevel>> index;
+    if (!readTextureArchiveIndex(cachePath, hashAssetSources(entries), entries, index)) {
+        std::cerr << "Texture residency needs an up-to-date " << cachePath << "; keeping every texture resident\n";
+        return false;
+    }
+
+    slots_.assign(tm_.textures.size(), Slot{});
+    used_.reset(new std::atomic<Uint8>[slots_.size()]());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        int id = entries[i].id;
+        if (entries[i].sprite || id < 0 || id >= static_cast<int>(slots_.size()) || slots_[id].managed || index[i].empty() ||
+            tm_.textureMips[id].empty()) {
+            continue;
+        }
+        Slot& slot = slots_[id];
+        slot.placeholder = copyPlaceholder(tm_.textureMips[id]);
+        if (slot.placeholder.empty()) {
+            continue;
+        }
+        // The full chain comes back from the archive on demand; whatever backed it until now is released.
+        freeChain(tm_.textureMips[id]);
+        tm_.textures[id] = slot.placeholder.front();
+        tm_.textureMips[id] = slot.placeholder;
+        slot.levels = index[i];
+        for (const TextureArchiveLevel& level : slot.levels) {
+            slot.bytes += static_cast<size_t>(level.width) * level.height * sizeof(Uint32);
+        }
+        slot.managed = true;
+        stats_.placeholderBytes += chainBytes(slot.placeholder);
+        ++stats_.managed;
+    }
+    tm_.residency = this;
+    attached_ = true;
+    loader_ = std::thread(&TextureResidency::loaderLoop, this, cachePath);
+    return true;
+}
+
+void TextureResidency::update() {
+    if (!attached_) {
+        return;
+    }
+    ++frame_;
+    std::vector<Loaded> done;
+    bool requested = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(loaded_);
+        for (size_t id = 0; id < slots_.size(); ++id) {
+            if (!used_[id].load(std::memory_order_relaxed)) {
+                continue;
+            }
+            used_[id].store(0, std::memory_order_relaxed);
+            Slot& slot = slots_[id];
+            slot.lastUse = frame_;
+            if (!slot.full.empty()) {
+                ++stats_.hits;
+            } else if (slot.managed) {
+                ++stats_.misses;
+                if (!slot.loading && !slot.failed) {
+                    slot.loading = true;
+                    requests_.push_back(static_cast<int>(id));
+                    requested = true;
+                }
+            }
+        }
+    }
+    if (requested) {
+        requested_.notify_one();
+    }
+
+    for (Loaded& load : done) {
+        stats_.loadMs += load.ms;
+        if (load.chain.empty()) {
+            slots_[load.id].loading = false;
+            slots_[load.id].failed = true;
+            ++stats_.failedLoads;
+            continue;
+        }
+        install(load.id, std::move(load.chain));
+    }
+
+    // Least recently used first, never a texture the last frame drew.
+    while (stats_.residentBytes > budget_) {
+        int victim = -1;
+        for (size_t id = 0; id < slots_.size(); ++id) {
+            const Slot& slot = slots_[id];
+            if (!slot.full.empty() && slot.lastUse < frame_ && (victim < 0 || slot.lastUse < slots_[victim].lastUse)) {
+                victim = static_cast<int>(id);
+            }
+        }
+        if (victim < 0) {
+            break;
+        }
+        evict(victim);
+    }
+}
+
+void TextureResidency::install(int id, std::vector<SDL_Surface*> chain) {
+    Slot& slot = slots_[id];
+    slot.loading = false;
+    slot.full = std::move(chain);
+    tm_.textures[id] = slot.full.front();
+    tm_.textureMips[id] = slot.full;
+    stats_.residentBytes += slot.bytes;
+    stats_.peakBytes = std::max(stats_.peakBytes, stats_.residentBytes);
+    ++stats_.loads;
+}
+
+void TextureResidency::evict(int id) {
+    Slot& slot = slots_[id];
+    tm_.textures[id] = slot.placeholder.front();
+    tm_.textureMips[id] = slot.placeholder;
+    freeChain(slot.full);
+    stats_.residentBytes -= slot.bytes;
+    ++stats_.evictions;
+}
+
+TextureResidencyStats TextureResidency::stats() const {
+    TextureResidencyStats stats = stats_;
+    for (const Slot& slot : slots_) {
+        stats.resident += slot.full.empty() ? 0 : 1;
+        stats.pending += slot.loading ? 1 : 0;
+    }
+    return stats;
+}
+
+void TextureResidency::loaderLoop(std::string cachePath) {
+    std::ifstream in(cachePath, std::ios::binary);
+    for (;;) {
+        int id;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            requested_.wait(lock, [&] { return stopping_ || !requests_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            id = requests_.front();
+            requests_.pop_front();
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SDL_Surface*> chain = readTextureArchiveChain(in, slots_[id].levels);
+        if (chain.empty()) {
+            std::cerr << "Failed to read wall texture " << id << " from " << cachePath << "\n";
+            in.clear();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        loaded_.push_back({id, std::move(chain), ms});
+    }
+}
+
+void registerTextureResidencyCommands(ConsoleState& console, TextureResidency* residency, int& budgetMb) {
+    registerCvar(console, "tex_budget_mb", &budgetMb, 0, 65536, "Memory for full-resolution wall textures; least recently used ones fall back to placeholders", [residency, &budgetMb](ConsoleState& con) {
+        if (residency) {
+            residency->setBudget(static_cast<size_t>(budgetMb) << 20);
+        } else {
+            consolePrint(con, "Texture residency is off (no texture cache); every texture stays resident");
+        }
+    });
+    registerConsoleCommand(console, "tex_stats", "tex_stats", "Wall texture residency: resident set, hits, misses and evictions", [residency](ConsoleState& con, const std::vector<std::string>&) {
+        if (!residency) {
+            consolePrint(con, "Texture residency is off (no texture cache); every texture stays resident");
+            return;
+        }
+        TextureResidencyStats st = residency->stats();
+        char line[200];
+        std::snprintf(line, sizeof(line), "%d/%d walls resident, %.2f of %.2f MiB (peak %.2f), placeholders %.1f KiB, %d loading",
+                      st.resident, st.managed, st.residentBytes / 1048576.0, residency->budget() / 1048576.0, st.peakBytes / 1048576.0,
+                      st.placeholderBytes / 1024.0, st.pending);
+        consolePrint(con, line);
+        std::snprintf(line, sizeof(line), "hits %zu, misses %zu (placeholder drawn), loads %zu (%.2f ms avg), failed %zu, evictions %zu", st.hits, st.misses,
+                      st.loads, st.loads ? st.loadMs / st.loads : 0.0, st.failedLoads, st.evictions);
+        consolePrint(con, line);
+    });
+}
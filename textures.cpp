@@ -2,40 +2,262 @@
 
 #include <SDL2/SDL_image.h>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
 
+#include "assets.h"
+#include "thread_pool.h"
+
 namespace {
-SDL_Surface* loadSurface(const std::string& path) {
-    SDL_Surface* loaded = IMG_Load(path.c_str());
-    if (!loaded) {
-        std::cerr << "Failed to load texture " << path << ": " << IMG_GetError() << "\n";
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct DecodedAsset {
+    std::vector<SDL_Surface*> chain;
+    double ioMs = 0.0;
+    double decodeMs = 0.0;
+    double convertMs = 0.0;
+};
+
+// Box-filters one level down. Colour-keyed (sprite) texels only average their
+// opaque neighbours so transparent borders do not bleed into the silhouette.
+SDL_Surface* downsample(SDL_Surface* src, bool colorKeyed) {
+    int w = std::max(1, src->w / 2);
+    int h = std::max(1, src->h / 2);
+    SDL_Surface* dst = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!dst) {
+        std::cerr << "Failed to allocate mip level: " << SDL_GetError() << "\n";
         return nullptr;
     }
+    Uint32* out = static_cast<Uint32*>(dst->pixels);
+    int outStride = dst->pitch / static_cast<int>(sizeof(Uint32));
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            Uint32 r = 0, g = 0, b = 0, a = 0;
+            int count = 0;
+            for (int sy = 0; sy < 2; ++sy) {
+                for (int sx = 0; sx < 2; ++sx) {
+                    Uint32 p = sampleTextureRaw(src, x * 2 + sx, y * 2 + sy);
+                    if (colorKeyed && ((p >> 24) == 0 || (p & 0x00ffffffu) == 0)) {
+                        continue;
+                    }
+                    a += (p >> 24) & 0xff;
+                    r += (p >> 16) & 0xff;
+                    g += (p >> 8) & 0xff;
+                    b += p & 0xff;
+                    ++count;
+                }
+            }
+            Uint32 texel = 0;
+            if (colorKeyed && count < 2) {
+                texel = 0; // mostly transparent footprint stays transparent
+            } else if (count > 0) {
+                Uint32 half = count / 2;
+                r = (r + half) / count;
+                g = (g + half) / count;
+                b = (b + half) / count;
+                a = (a + half) / count;
+                if (colorKeyed && (r | g | b) == 0) {
+                    r = g = b = 1; // keep opaque texels from turning into the black key
+                }
+                texel = (a << 24) | (r << 16) | (g << 8) | b;
+            }
+            out[y * outStride + x] = texel;
+        }
+    }
+    return dst;
+}
+
+void freeMipLevels(std::vector<SDL_Surface*>& chain) {
+    for (size_t i = 1; i < chain.size(); ++i) {
+        SDL_FreeSurface(chain[i]);
+    }
+    chain.clear();
+}
+
+// Reads, decodes and converts one texture; runs on a worker thread.
+DecodedAsset decodeAsset(const AssetEntry& entry) {
+    DecodedAsset result;
+    auto start = Clock::now();
+    std::ifstream in(entry.path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    result.ioMs = elapsedMs(start);
+    if (!in.good() && !in.eof()) {
+        bytes.clear();
+    }
+    if (bytes.empty()) {
+        std::cerr << "Failed to load texture " << entry.path << ": cannot read file\n";
+        return result;
+    }
+
+    start = Clock::now();
+    SDL_Surface* loaded = IMG_Load_RW(SDL_RWFromConstMem(bytes.data(), static_cast<int>(bytes.size())), 1);
+    result.decodeMs = elapsedMs(start);
+    if (!loaded) {
+        std::cerr << "Failed to load texture " << entry.path << ": " << IMG_GetError() << "\n";
+        return result;
+    }
+
+    start = Clock::now();
     SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
     SDL_FreeSurface(loaded);
     if (!converted) {
-        std::cerr << "Failed to convert texture " << path << ": " << SDL_GetError() << "\n";
+        std::cerr << "Failed to convert texture " << entry.path << ": " << SDL_GetError() << "\n";
+    } else {
+        result.chain = buildMipChain(converted, entry.sprite);
+    }
+    result.convertMs = elapsedMs(start);
+    return result;
+}
+
+void installChain(TextureManager& tm, const AssetEntry& entry, std::vector<SDL_Surface*> chain) {
+    auto& surfaces = entry.sprite ? tm.spriteTextures : tm.textures;
+    auto& chains = entry.sprite ? tm.spriteMips : tm.textureMips;
+    if (entry.id >= static_cast<int>(surfaces.size())) {
+        surfaces.resize(entry.id + 1, nullptr);
+        chains.resize(entry.id + 1);
+    }
+    if (surfaces[entry.id]) {
+        // Later manifest lines override earlier ones.
+        freeMipLevels(chains[entry.id]);
+        SDL_FreeSurface(surfaces[entry.id]);
     }
-    return converted;
+    surfaces[entry.id] = chain.empty() ? nullptr : chain.front();
+    chains[entry.id] = std::move(chain);
 }
 } // namespace
 
+std::vector<SDL_Surface*> buildMipChain(SDL_Surface* base, bool colorKeyed) {
+    std::vector<SDL_Surface*> chain;
+    if (!base) {
+        return chain;
+    }
+    chain.push_back(base);
+    while (chain.back()->w > 1 || chain.back()->h > 1) {
+        SDL_Surface* next = downsample(chain.back(), colorKeyed);
+        if (!next) {
+            break;
+        }
+        chain.push_back(next);
+    }
+    return chain;
+}
+
+void rebuildMipChains(TextureManager& tm) {
+    for (auto& chain : tm.textureMips) {
+        freeMipLevels(chain);
+    }
+    for (auto& chain : tm.spriteMips) {
+        freeMipLevels(chain);
+    }
+    tm.textureMips.clear();
+    tm.spriteMips.clear();
+    for (auto* surf : tm.textures) {
+        tm.textureMips.push_back(buildMipChain(surf, false));
+    }
+    for (auto* surf : tm.spriteTextures) {
+        tm.spriteMips.push_back(buildMipChain(surf, true));
+    }
+}
+
+int selectMipLevel(double texelsPerPixel, int levelCount) {
+    if (levelCount <= 1 || !(texelsPerPixel > 1.0)) {
+        return 0;
+    }
+    // floor(log2): the chosen level still has between one and two texels per pixel.
+    int level = std::ilogb(texelsPerPixel);
+    return std::min(level, levelCount - 1);
+}
+
 TextureManager loadTextures() {
+    return loadTextures(TEXTURE_MANIFEST_PATH, TEXTURE_CACHE_PATH);
+}
+
+TextureManager loadTextures(const std::string& manifestPath, const std::string& cachePath) {
+    auto start = Clock::now();
     TextureManager tm{};
-    tm.textures.resize(6, nullptr);
-    tm.textures[1] = loadSurface("resources/textures/redbrick.png");
-    tm.textures[2] = loadSurface("resources/textures/greystone.png");
-    tm.textures[3] = loadSurface("resources/textures/wood.png");
-    tm.textures[4] = loadSurface("resources/textures/bluestone.png");
-    tm.textures[DOOR_TILE] = loadSurface("resources/textures/door.png");
-    tm.spriteTextures.push_back(loadSurface("resources/textures/sprite_barrel.png"));
-    tm.spriteTextures.push_back(loadSurface("resources/textures/sprite_pillar.png"));
-    tm.spriteTextures.push_back(loadSurface("resources/textures/sprite_greenlight.png"));
+    AssetLoadStats& stats = tm.loadStats;
+
+    std::vector<AssetEntry> entries = readAssetManifest(manifestPath);
+    Uint64 sourceHash = hashAssetSources(entries);
+    for (const auto& entry : entries) {
+        auto& surfaces = entry.sprite ? tm.spriteTextures : tm.textures;
+        if (entry.id >= static_cast<int>(surfaces.size())) {
+            surfaces.resize(entry.id + 1, nullptr);
+        }
+    }
+    tm.textureMips.resize(tm.textures.size());
+    tm.spriteMips.resize(tm.spriteTextures.size());
+
+    stats.fromCache = mapTextureArchive(cachePath, sourceHash, entries, tm);
+    stats.ioMs = elapsedMs(start);
+    if (!stats.fromCache) {
+        // First run (or stale cache): decode every source across the worker pool.
+        ThreadPool& pool = workerPool();
+        stats.threads = std::min<unsigned>(pool.concurrency(), static_cast<unsigned>(std::max<size_t>(1, entries.size())));
+        std::vector<DecodedAsset> decoded(entries.size());
+        pool.parallelFor(entries.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                decoded[i] = decodeAsset(entries[i]);
+            }
+        });
+        for (size_t i = 0; i < entries.size(); ++i) {
+            stats.ioMs += decoded[i].ioMs;
+            stats.decodeMs += decoded[i].decodeMs;
+            stats.convertMs += decoded[i].convertMs;
+            installChain(tm, entries[i], std::move(decoded[i].chain));
+        }
+        auto ioStart = Clock::now();
+        writeTextureArchive(cachePath, sourceHash, entries, tm);
+        stats.ioMs += elapsedMs(ioStart);
+    }
+
+    for (const auto* chains : {&tm.textureMips, &tm.spriteMips}) {
+        for (const auto& chain : *chains) {
+            stats.textureCount += chain.empty() ? 0 : 1;
+            for (const SDL_Surface* surf : chain) {
+                stats.pixelBytes += static_cast<size_t>(surf->w) * surf->h * sizeof(Uint32);
+            }
+        }
+    }
+    stats.totalMs = elapsedMs(start);
+    printAssetLoadReport(std::cout, stats);
     return tm;
 }
 
+void printAssetLoadReport(std::ostream& out, const AssetLoadStats& stats) {
+    std::ostringstream oss;
+    oss.precision(2);
+    oss << std::fixed << "Textures: " << stats.textureCount << " loaded, " << stats.pixelBytes / 1024.0 << " KiB";
+    if (stats.fromCache) {
+        oss << ", mapped from cache\n";
+    } else {
+        oss << ", decoded on " << stats.threads << " thread(s)\n";
+    }
+    oss << "  io      " << stats.ioMs << " ms\n"
+        << "  decode  " << stats.decodeMs << " ms (summed across threads)\n"
+        << "  convert " << stats.convertMs << " ms (summed across threads)\n"
+        << "  total   " << stats.totalMs << " ms wall clock\n";
+    out << oss.str();
+}
+
 void freeTextures(TextureManager& tm) {
+    for (auto& chain : tm.textureMips) {
+        freeMipLevels(chain);
+    }
+    for (auto& chain : tm.spriteMips) {
+        freeMipLevels(chain);
+    }
+    tm.textureMips.clear();
+    tm.spriteMips.clear();
     for (auto* surf : tm.textures) {
         if (surf) {
             SDL_FreeSurface(surf);
@@ -48,6 +270,7 @@ void freeTextures(TextureManager& tm) {
     }
     tm.textures.clear();
     tm.spriteTextures.clear();
+    tm.archive.reset(); // after the surfaces that borrow its pixels
 }
 
 Uint32 sampleTextureRaw(SDL_Surface* surf, int x, int y) {
@@ -71,3 +294,41 @@ Color sampleTexture(SDL_Surface* surf, int x, int y) {
     SDL_GetRGBA(pixel, surf->format, &r, &g, &b, &a);
     return {r, g, b};
 }
+
+SDL_Surface* makeCheckerSurface(int seed, bool colorKeyed) {
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!surf) {
+        return nullptr;
+    }
+    Uint32* pixels = static_cast<Uint32*>(surf->pixels);
+    int stride = surf->pitch / static_cast<int>(sizeof(Uint32));
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            Uint32 v = static_cast<Uint32>((x * 7 + y * 13 + seed * 31) & 0xff);
+            Uint32 c = (((x / 8 + y / 8) & 1) ? 0xff402010u : 0xffa08060u) ^ (v << 8) ^ static_cast<Uint32>(seed * 0x00102030);
+            bool transparent = colorKeyed && ((x - 32) * (x - 32) + (y - 32) * (y - 32) > 28 * 28);
+            pixels[y * stride + x] = transparent ? 0 : (c | 0xff000000u);
+        }
+    }
+    return surf;
+}
+
+void fillMissingTextures(TextureManager& tm) {
+    bool replaced = false;
+    for (size_t i = 1; i < tm.textures.size(); ++i) {
+        if (!tm.textures[i]) {
+            tm.textures[i] = makeCheckerSurface(static_cast<int>(i), false);
+            replaced = true;
+        }
+    }
+    for (size_t i = 0; i < tm.spriteTextures.size(); ++i) {
+        if (!tm.spriteTextures[i]) {
+            tm.spriteTextures[i] = makeCheckerSurface(static_cast<int>(i) + 8, true);
+            replaced = true;
+        }
+    }
+    if (replaced) {
+        std::cout << "note: missing textures replaced with procedural ones\n";
+        rebuildMipChains(tm);
+    }
+}
@@ -0,0 +1,135 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "alloc_stats.h"
+
+namespace {
+thread_local bool insideWorker = false;
+} // namespace
+
+ThreadPool::ThreadPool(unsigned workerCount) {
+    workers_.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeCv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wakeCv_.notify_one();
+}
+
+void ThreadPool::runRange(size_t count, size_t grain, RangeFn fn, void* ctx) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(1, grain);
+    size_t chunks = (count + grain - 1) / grain;
+    if (workers_.empty() || chunks == 1 || insideWorker) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial(jobMutex_);
+    Job job{fn, ctx, count, grain, chunks, countingAllocations()};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = job;
+        nextChunk_.store(0);
+        pendingChunks_.store(chunks);
+        ++jobGeneration_;
+    }
+    wakeCv_.notify_all();
+    // The caller's own chunks may nest parallelFor too; those must run inline like a worker's.
+    insideWorker = true;
+    runChunks(job);
+    insideWorker = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this] { return pendingChunks_.load() == 0 && activeWorkers_ == 0; });
+    job_ = Job{}; // late wakers must not pick up a finished job
+}
+
+void ThreadPool::runChunks(const Job& job) {
+    for (;;) {
+        size_t chunk = nextChunk_.fetch_add(1);
+        if (chunk >= job.chunks) {
+            return;
+        }
+        size_t begin = chunk * job.grain;
+        size_t end = std::min(job.count, begin + job.grain);
+        job.fn(job.ctx, begin, end);
+        if (pendingChunks_.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            doneCv_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    insideWorker = true;
+    unsigned long long seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wakeCv_.wait(lock, [&] { return stop_ || jobGeneration_ != seenGeneration || !tasks_.empty(); });
+        if (jobGeneration_ != seenGeneration) {
+            seenGeneration = jobGeneration_;
+            Job job = job_;
+            if (job.fn) {
+                ++activeWorkers_;
+                lock.unlock();
+                {
+                    AllocationCountScope counting(job.countAllocations);
+                    runChunks(job);
+                }
+                lock.lock();
+                --activeWorkers_;
+                doneCv_.notify_all();
+            }
+            continue;
+        }
+        if (!tasks_.empty()) {
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+            continue;
+        }
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+ThreadPool& workerPool() {
+    static ThreadPool pool([] {
+        // RAYCASTER_THREADS caps the total thread count, including the caller.
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        if (const char* env = std::getenv("RAYCASTER_THREADS")) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(env)));
+        }
+        return threads - 1;
+    }());
+    return pool;
+}
@@ -0,0 +1,151 @@
+#include "timedemo.h"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "level.h"
+
+namespace {
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+std::vector<std::string> formatResult(const TimedemoRun& run, const TimedemoResult& r, bool aborted) {
+    std::vector<std::string> lines;
+    std::ostringstream oss;
+    oss.precision(1);
+    oss << std::fixed << "timedemo " << run.name << ": " << r.frames << " frames in " << r.totalMs / 1000.0 << " s"
+        << (aborted ? " (aborted)" : "");
+    lines.push_back(oss.str());
+    oss.str("");
+    oss << "  avg " << r.avgFps << " fps, min " << r.minFps << " fps, 1% low " << r.low1Fps << " fps";
+    lines.push_back(oss.str());
+    oss.str("");
+    oss.precision(2);
+    oss << "  frame ms: p50 " << r.p50Ms << ", p90 " << r.p90Ms << ", p99 " << r.p99Ms << ", max " << r.maxMs;
+    lines.push_back(oss.str());
+    return lines;
+}
+} // namespace
+
+void startTimedemo(TimedemoRun& run, CameraPath path, const std::string& name, const std::string& reportFile, SDL_Renderer* renderer) {
+    run.active = true;
+    run.path = std::move(path);
+    run.frame = 0;
+    run.frameMs.clear();
+    run.frameMs.reserve(run.path.frames.size());
+    run.lastCounter = 0;
+    run.name = name;
+    run.reportFile = reportFile;
+    SDL_RenderSetVSync(renderer, 0);
+}
+
+bool advanceTimedemo(TimedemoRun& run, Player& player) {
+    // Each interval covers a whole loop iteration: simulation, render and present.
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (run.frame > 0) {
+        run.frameMs.push_back((now - run.lastCounter) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+    run.lastCounter = now;
+    if (run.frame >= run.path.frames.size()) {
+        return false;
+    }
+    player = run.path.frames[run.frame++];
+    return true;
+}
+
+TimedemoResult summarizeFrameTimes(std::vector<double> frameMs) {
+    TimedemoResult r;
+    r.frames = frameMs.size();
+    if (frameMs.empty()) {
+        return r;
+    }
+    std::sort(frameMs.begin(), frameMs.end());
+    for (double ms : frameMs) {
+        r.totalMs += ms;
+    }
+    size_t slowest = std::max<size_t>(1, frameMs.size() / 100);
+    double slowMs = 0.0;
+    for (size_t i = frameMs.size() - slowest; i < frameMs.size(); ++i) {
+        slowMs += frameMs[i];
+    }
+    r.avgFps = r.totalMs > 0.0 ? r.frames * 1000.0 / r.totalMs : 0.0;
+    r.maxMs = frameMs.back();
+    r.minFps = r.maxMs > 0.0 ? 1000.0 / r.maxMs : 0.0;
+    r.low1Fps = slowMs > 0.0 ? slowest * 1000.0 / slowMs : 0.0;
+    r.p50Ms = percentile(frameMs, 0.50);
+    r.p90Ms = percentile(frameMs, 0.90);
+    r.p99Ms = percentile(frameMs, 0.99);
+    return r;
+}
+
+void finishTimedemo(TimedemoRun& run, ConsoleState& console, SDL_Renderer* renderer, bool aborted) {
+    if (!run.active) {
+        return;
+    }
+    run.active = false;
+    SDL_RenderSetVSync(renderer, 1);
+
+    std::vector<std::string> lines = formatResult(run, summarizeFrameTimes(run.frameMs), aborted);
+    for (const auto& line : lines) {
+        consolePrint(console, line);
+    }
+    std::ofstream out(run.reportFile, std::ios::app);
+    if (!out) {
+        consolePrint(console, "Failed to write " + run.reportFile);
+        return;
+    }
+    std::time_t now = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    out << "# " << stamp << "\n";
+    for (const auto& line : lines) {
+        out << line << "\n";
+    }
+    consolePrint(console, "Results appended to " + run.reportFile);
+}
+
+void registerTimedemoCommands(ConsoleState& console, TimedemoRun& demo, CameraRecording& recording, std::unique_ptr<Level>& level, Player& player, SDL_Renderer* renderer) {
+    registerConsoleCommand(console, "timedemo", "timedemo [path|auto] [report]", "Fly a camera path with vsync off and report fps", [&demo, &level, &player, renderer](ConsoleState& con, const std::vector<std::string>& args) {
+        std::string source = args.size() >= 2 ? args[1] : "auto";
+        std::string report = args.size() >= 3 ? args[2] : "timedemo.txt";
+        CameraPath path;
+        if (source == "auto") {
+            path = generateRoomTour(level->map, level->doors);
+        } else if (!loadCameraPath(source, path)) {
+            consolePrint(con, "Could not load camera path " + source);
+            return;
+        }
+        // Same starting world every run: doors shut, then fixed-step simulation.
+        for (auto& door : level->doors) {
+            door.openAmount = 0.0;
+            door.targetOpen = false;
+            door.timeFullyOpen = 0.0;
+        }
+        demo.restorePose = player;
+        consolePrint(con, "timedemo: " + std::to_string(path.frames.size()) + " frames, Esc aborts");
+        startTimedemo(demo, std::move(path), source, report, renderer);
+        setConsoleOpen(con, false);
+    });
+    registerConsoleCommand(console, "demo_record", "demo_record", "Record the camera path, one pose per frame", [&recording](ConsoleState& con, const std::vector<std::string>&) {
+        recording.path.frames.clear();
+        recording.active = true;
+        consolePrint(con, "Recording camera path; demo_stop [file] saves it");
+    });
+    registerConsoleCommand(console, "demo_stop", "demo_stop [file]", "Stop recording and save the camera path", [&recording](ConsoleState& con, const std::vector<std::string>& args) {
+        if (!recording.active) {
+            consolePrint(con, "Not recording");
+            return;
+        }
+        recording.active = false;
+        std::string file = args.size() >= 2 ? args[1] : "demo.path";
+        if (saveCameraPath(file, recording.path)) {
+            consolePrint(con, "Saved " + std::to_string(recording.path.frames.size()) + " frames to " + file);
+        } else {
+            consolePrint(con, "Failed to write " + file);
+        }
+    });
+}
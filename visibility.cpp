@@ -0,0 +1,42 @@
+#include "visibility.h"
+
+#include "doors.h"
+#include "raycast.h"
+#include "thread_pool.h"
+
+namespace {
+const size_t QUERY_CHUNK = 256;
+} // namespace
+
+bool hasLineOfSight(const Map& map, const std::vector<Door>& doors, double fromX, double fromY, double toX, double toY) {
+    double dirX = toX - fromX;
+    double dirY = toY - fromY;
+    // castRay only tests cells it steps into, so a door slab inside the start cell is checked here.
+    int startX = static_cast<int>(fromX);
+    int startY = static_cast<int>(fromY);
+    if (map.at(startX, startY) == DOOR_TILE) {
+        const Door* door = findDoor(doors, startX, startY);
+        double dist;
+        bool side;
+        if (door && door->openAmount < 0.99 && computeDoorHit(*door, fromX, fromY, dirX, dirY, dist, side) && dist <= 1.0) {
+            return false;
+        }
+    }
+    // With the unnormalised direction the target sits at distance 1.
+    RayHit hit;
+    return !castRay(map, doors, fromX, fromY, dirX, dirY, 1.0, hit);
+}
+
+void queryLineOfSight(const Map& map, const std::vector<Door>& doors, const std::vector<LosQuery>& queries, std::vector<Uint8>& results) {
+    queryLineOfSight(map, doors, queries, results, workerPool());
+}
+
+void queryLineOfSight(const Map& map, const std::vector<Door>& doors, const std::vector<LosQuery>& queries, std::vector<Uint8>& results, ThreadPool& pool) {
+    results.resize(queries.size());
+    pool.parallelFor(queries.size(), QUERY_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const LosQuery& q = queries[i];
+            results[i] = hasLineOfSight(map, doors, q.fromX, q.fromY, q.toX, q.toY) ? 1 : 0;
+        }
+    });
+}